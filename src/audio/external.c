@@ -10,6 +10,7 @@
 #include "game/level_update.h"
 #include "game/object_list_processor.h"
 #include "game/camera.h"
+#include "game/snapshot.h"
 #include "seq_ids.h"
 #include "dialog_ids.h"
 
@@ -876,7 +877,14 @@ void create_next_audio_buffer(s16 *samples, u32 num_samples) {
         sGameLoopTicked = 0;
     }
     s32 writtenCmds;
+#ifdef HEADLESS
+    // Nothing is listening, only the sound requests above need to be kept up
+    (void) writtenCmds;
+    (void) samples;
+    (void) num_samples;
+#else
     synthesis_execute(gAudioCmdBuffers[0], &writtenCmds, samples, num_samples);
+#endif
     gAudioRandom = ((gAudioRandom + gAudioFrameCount) * gAudioFrameCount);
     decrease_sample_dma_ttls();
 }
@@ -2477,3 +2485,66 @@ void unused_80321460(UNUSED s32 arg0, UNUSED s32 arg1, UNUSED s32 arg2, UNUSED s
 void unused_80321474(UNUSED s32 arg0) {
 }
 #endif
+
+#ifdef SNAPSHOTS
+extern struct SoundAllocPool gAudioSessionPool;
+extern struct SoundAllocPool gSeqAndBankPool;
+extern struct SoundAllocPool gPersistentCommonPool;
+extern struct SoundAllocPool gTemporaryCommonPool;
+
+/**
+ * Register the sound request and sequence state for snapshots. The audio
+ * heap holds the notes and the loaded sequences and banks, the DMA and
+ * synthesis state is left out since it's rebuilt from the sequence state.
+ */
+void audio_snapshot_regions(void) {
+    SNAPSHOT_REGION(sGameLoopTicked);
+    SNAPSHOT_REGION(sNumProcessedSoundRequests);
+    SNAPSHOT_REGION(sSoundRequestCount);
+    SNAPSHOT_REGION(sCurrentMusicDynamic);
+    SNAPSHOT_REGION(sBackgroundMusicForDynamics);
+    SNAPSHOT_REGION(sPlayer0CurSeqId);
+    SNAPSHOT_REGION(sMusicDynamicDelay);
+    SNAPSHOT_REGION(D_803320A4);
+    SNAPSHOT_REGION(D_803320B0);
+    SNAPSHOT_REGION(D_803320BC);
+    SNAPSHOT_REGION(sSoundBankDisabled);
+    SNAPSHOT_REGION(D_80332108);
+    SNAPSHOT_REGION(sHasStartedFadeOut);
+    SNAPSHOT_REGION(D_80332110);
+    SNAPSHOT_REGION(D_8033211C);
+    SNAPSHOT_REGION(D_80332120);
+    SNAPSHOT_REGION(D_80332124);
+    SNAPSHOT_REGION(sBackgroundMusicQueueSize);
+    SNAPSHOT_REGION(sSoundRequests);
+    SNAPSHOT_REGION(D_80360928);
+    SNAPSHOT_REGION(sUsedChannelsForSoundBank);
+    SNAPSHOT_REGION(sCurrentSound);
+    SNAPSHOT_REGION(gSoundBanks);
+    SNAPSHOT_REGION(D_80363808);
+    SNAPSHOT_REGION(D_80363812);
+    SNAPSHOT_REGION(sCapVolumeTo40);
+    SNAPSHOT_REGION(sBackgroundMusicQueue);
+
+    SNAPSHOT_REGION(gSequencePlayers);
+    SNAPSHOT_REGION(gSequenceChannels);
+    SNAPSHOT_REGION(gSequenceLayers);
+    SNAPSHOT_REGION(gSequenceChannelNone);
+    SNAPSHOT_REGION(gLayerFreeList);
+    SNAPSHOT_REGION(gNoteFreeLists);
+    SNAPSHOT_REGION(gNotes);
+    SNAPSHOT_REGION(gAudioRandom);
+
+    snapshot_add_region(gAudioHeap, gAudioHeapSize);
+    SNAPSHOT_REGION(gAudioSessionPool);
+    SNAPSHOT_REGION(gAudioInitPool);
+    SNAPSHOT_REGION(gNotesAndBuffersPool);
+    SNAPSHOT_REGION(gSeqAndBankPool);
+    SNAPSHOT_REGION(gPersistentCommonPool);
+    SNAPSHOT_REGION(gTemporaryCommonPool);
+    SNAPSHOT_REGION(gSeqLoadedPool);
+    SNAPSHOT_REGION(gBankLoadedPool);
+    SNAPSHOT_REGION(gBankLoadStatus);
+    SNAPSHOT_REGION(gSeqLoadStatus);
+}
+#endif
@@ -58,6 +58,9 @@ void sound_reset(u8 presetId);
 void audio_set_sound_mode(u8 arg0);
 
 void audio_init(void); // in load.c
+#ifdef SNAPSHOTS
+void audio_snapshot_regions(void);
+#endif
 
 #ifdef VERSION_EU
 struct SPTask *unused_80321460(void);
@@ -152,7 +152,14 @@ void create_next_audio_buffer(s16 *samples, u32 num_samples) {
     if (osRecvMesg(OSMesgQueues[1], &msg, OS_MESG_NOBLOCK) != -1) {
         func_802ad7ec((u32) msg);
     }
+#ifdef HEADLESS
+    // Nothing is listening, only the sound requests above need to be kept up
+    writtenCmds = 0;
+    (void) samples;
+    (void) num_samples;
+#else
     synthesis_execute(gAudioCmdBuffers[0], &writtenCmds, samples, num_samples);
+#endif
     gAudioRandom = ((gAudioRandom + gAudioFrameCount) * gAudioFrameCount);
     gAudioRandom = gAudioRandom + writtenCmds / 8;
 }
@@ -9,10 +9,12 @@
 #include "game/mario.h"
 #include "game/memory.h"
 #include "game/obj_behaviors_2.h"
+#include "game/object_collision.h"
 #include "game/object_helpers.h"
 #include "game/object_list_processor.h"
 #include "graph_node.h"
 #include "surface_collision.h"
+#include "game/snapshot.h"
 
 // Macros for retrieving arguments from behavior scripts.
 #define BHV_CMD_GET_1ST_U8(index)  (u8)((gCurBhvCommand[index] >> 24) & 0xFF) // unused
@@ -59,6 +61,13 @@ u16 random_u16(void) {
     return gRandomSeed16;
 }
 
+#ifdef HEADLESS
+// Return the random seed without advancing it, for hashing the game state.
+u16 random_get_seed(void) {
+    return gRandomSeed16;
+}
+#endif
+
 // Generate a pseudorandom float in the range [0, 1).
 f32 random_float(void) {
     f32 rnd = random_u16();
@@ -847,14 +856,613 @@ static BhvCommandProc BehaviorCmdTable[] = {
     bhv_cmd_spawn_water_droplet,
 };
 
+// Run behavior commands starting at gCurBhvCommand until one of them ends the frame.
+static void cur_obj_run_bhv_commands(void) {
+    BhvCommandProc bhvCmdProc;
+    s32 bhvProcResult;
+
+    do {
+        bhvCmdProc = BehaviorCmdTable[*gCurBhvCommand >> 24];
+        bhvProcResult = bhvCmdProc();
+    } while (bhvProcResult == BHV_PROC_CONTINUE);
+}
+
+#if defined(PREDECODE_BEHAVIORS) && !defined(NO_SEGMENTED_MEMORY)
+#error PREDECODE_BEHAVIORS keeps decoded scripts by address, which needs NO_SEGMENTED_MEMORY
+#endif
+
+#ifdef PREDECODE_BEHAVIORS
+/**
+ * Behavior scripts are translated into blocks of pre-decoded instructions the
+ * first time they run, with the operands unpacked and each command's handler
+ * stored in the instruction itself, so running a script doesn't go through
+ * BehaviorCmdTable or decode the command words again. A block is a straight
+ * run of commands up to one that never falls through (GOTO, RETURN, BREAK,
+ * END_LOOP...). Scripts never move without segmented memory, so decoded blocks
+ * are kept for the rest of the game.
+ *
+ * Objects still keep their position in the script (curBhvCommand) and their
+ * behavior stack as script addresses, so everything else sees the same state
+ * as before. Jumps check the address they land on against the instruction they
+ * were resolved to, and look it up again if it doesn't match.
+ *
+ * Commands that only run when an object spawns go through their original
+ * bhv_cmd_* function. If the pool runs out, scripts run as before.
+ */
+#define BHV_INSN_POOL_SIZE 4096
+#define BHV_INSN_HASH_SIZE 2048
+#define BHV_INSN_MAX_LOOP_DEPTH 8
+
+struct BhvInsn;
+typedef struct BhvInsn *(*BhvInsnProc)(struct BhvInsn *insn);
+
+struct BhvInsn {
+    BhvInsnProc proc;
+    const BehaviorScript *script; // The command this was decoded from
+    struct BhvInsn *next;         // The following command, NULL at the end of a block
+    struct BhvInsn *target;       // Where the command jumps to, NULL if not resolved yet
+    union {
+        s32 i;
+        f32 f;
+        void *ptr;
+    } args[2];
+    u8 field;
+    u8 length; // In script words
+};
+
+struct BhvInsnHashEntry {
+    const BehaviorScript *script;
+    struct BhvInsn *insn;
+};
+
+static struct BhvInsn sBhvInsnPool[BHV_INSN_POOL_SIZE];
+static s32 sBhvInsnPoolUsed;
+static struct BhvInsnHashEntry sBhvInsnHash[BHV_INSN_HASH_SIZE];
+static s32 sBhvInsnHashUsed;
+
+// The instruction each object resumes at next frame, checked against its curBhvCommand
+static struct BhvInsn *sObjectBhvInsns[OBJECT_POOL_CAPACITY];
+static struct BhvInsn *sBhvResumeInsn;
+
+static struct BhvInsn *bhv_insn_lookup(const BehaviorScript *script);
+
+static struct BhvInsnHashEntry *bhv_insn_hash_find(const BehaviorScript *script) {
+    uintptr_t addr = (uintptr_t) script;
+    s32 i = ((addr >> 2) ^ (addr >> 13)) & (BHV_INSN_HASH_SIZE - 1);
+
+    while (sBhvInsnHash[i].script != NULL && sBhvInsnHash[i].script != script) {
+        i = (i + 1) & (BHV_INSN_HASH_SIZE - 1);
+    }
+
+    return &sBhvInsnHash[i];
+}
+
+static void bhv_insn_register(struct BhvInsn *insn) {
+    struct BhvInsnHashEntry *entry;
+
+    // Keep the table from filling up so probing always ends
+    if (sBhvInsnHashUsed < BHV_INSN_HASH_SIZE * 3 / 4) {
+        entry = bhv_insn_hash_find(insn->script);
+        if (entry->script == NULL) {
+            entry->script = insn->script;
+            entry->insn = insn;
+            sBhvInsnHashUsed++;
+        }
+    }
+}
+
+// Stop running commands for this frame, resuming at addr next frame.
+static struct BhvInsn *bhv_insn_stop(const BehaviorScript *addr, struct BhvInsn *insn) {
+    gCurBhvCommand = addr;
+    sBhvResumeInsn = insn;
+    return NULL;
+}
+
+// Keep running commands at addr, or through BehaviorCmdTable if it can't be decoded.
+static struct BhvInsn *bhv_insn_continue(const BehaviorScript *addr, struct BhvInsn *insn) {
+    if (insn == NULL) {
+        insn = bhv_insn_lookup(addr);
+        if (insn == NULL) {
+            gCurBhvCommand = addr;
+            cur_obj_run_bhv_commands();
+            sBhvResumeInsn = NULL;
+        }
+    }
+    return insn;
+}
+
+static struct BhvInsn *bhv_insn_advance(struct BhvInsn *insn) {
+    return bhv_insn_continue(insn->script + insn->length, insn->next);
+}
+
+// Go back to the start of a loop, using the decoded loop start if it's the one on the stack.
+static struct BhvInsn *bhv_insn_loop_start(struct BhvInsn *insn, const BehaviorScript *addr) {
+    if (insn->target != NULL && insn->target->script == addr) {
+        return insn->target;
+    }
+    return NULL;
+}
+
+// Runs a command through its original bhv_cmd_* function.
+static struct BhvInsn *bhv_insn_cmd(struct BhvInsn *insn) {
+    s32 result;
+    struct BhvInsn *next = NULL;
+
+    gCurBhvCommand = insn->script;
+    result = BehaviorCmdTable[*insn->script >> 24]();
+
+    if (gCurBhvCommand == insn->script + insn->length) {
+        next = insn->next;
+    } else if (gCurBhvCommand == insn->script) {
+        next = insn;
+    }
+
+    if (result == BHV_PROC_BREAK) {
+        return bhv_insn_stop(gCurBhvCommand, next);
+    }
+    return bhv_insn_continue(gCurBhvCommand, next);
+}
+
+static struct BhvInsn *bhv_insn_delay(struct BhvInsn *insn) {
+    if (gCurrentObject->bhvDelayTimer < insn->args[0].i - 1) {
+        gCurrentObject->bhvDelayTimer++;
+        return bhv_insn_stop(insn->script, insn);
+    }
+
+    gCurrentObject->bhvDelayTimer = 0;
+    return bhv_insn_stop(insn->script + 1, insn->next);
+}
+
+static struct BhvInsn *bhv_insn_call(struct BhvInsn *insn) {
+    cur_obj_bhv_stack_push((uintptr_t) &insn->script[2]);
+
+    if (insn->target == NULL) {
+        insn->target = bhv_insn_lookup(insn->args[0].ptr);
+    }
+    return bhv_insn_continue(insn->args[0].ptr, insn->target);
+}
+
+static struct BhvInsn *bhv_insn_return(UNUSED struct BhvInsn *insn) {
+    const BehaviorScript *addr = (const BehaviorScript *) cur_obj_bhv_stack_pop();
+
+    return bhv_insn_continue(addr, bhv_insn_lookup(addr));
+}
+
+static struct BhvInsn *bhv_insn_goto(struct BhvInsn *insn) {
+    if (insn->target == NULL) {
+        insn->target = bhv_insn_lookup(insn->args[0].ptr);
+    }
+    return bhv_insn_continue(insn->args[0].ptr, insn->target);
+}
+
+static struct BhvInsn *bhv_insn_begin_repeat(struct BhvInsn *insn) {
+    cur_obj_bhv_stack_push((uintptr_t) &insn->script[1]);
+    cur_obj_bhv_stack_push(insn->args[0].i);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_end_repeat(struct BhvInsn *insn) {
+    u32 count = cur_obj_bhv_stack_pop();
+    const BehaviorScript *addr;
+
+    count--;
+    if (count != 0) {
+        addr = (const BehaviorScript *) cur_obj_bhv_stack_pop();
+        cur_obj_bhv_stack_push((uintptr_t) addr);
+        cur_obj_bhv_stack_push(count);
+        return bhv_insn_stop(addr, bhv_insn_loop_start(insn, addr));
+    }
+
+    cur_obj_bhv_stack_pop();
+    return bhv_insn_stop(insn->script + 1, insn->next);
+}
+
+static struct BhvInsn *bhv_insn_end_repeat_continue(struct BhvInsn *insn) {
+    u32 count = cur_obj_bhv_stack_pop();
+    const BehaviorScript *addr;
+
+    count--;
+    if (count != 0) {
+        addr = (const BehaviorScript *) cur_obj_bhv_stack_pop();
+        cur_obj_bhv_stack_push((uintptr_t) addr);
+        cur_obj_bhv_stack_push(count);
+        return bhv_insn_continue(addr, bhv_insn_loop_start(insn, addr));
+    }
+
+    cur_obj_bhv_stack_pop();
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_begin_loop(struct BhvInsn *insn) {
+    cur_obj_bhv_stack_push((uintptr_t) &insn->script[1]);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_end_loop(struct BhvInsn *insn) {
+    const BehaviorScript *addr = (const BehaviorScript *) cur_obj_bhv_stack_pop();
+
+    cur_obj_bhv_stack_push((uintptr_t) addr);
+    return bhv_insn_stop(addr, bhv_insn_loop_start(insn, addr));
+}
+
+static struct BhvInsn *bhv_insn_break(struct BhvInsn *insn) {
+    return bhv_insn_stop(insn->script, insn);
+}
+
+static struct BhvInsn *bhv_insn_deactivate(struct BhvInsn *insn) {
+    gCurrentObject->activeFlags = ACTIVE_FLAG_DEACTIVATED;
+    return bhv_insn_stop(insn->script, insn);
+}
+
+static struct BhvInsn *bhv_insn_call_native(struct BhvInsn *insn) {
+    ((NativeBhvFunc) insn->args[0].ptr)();
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_add_float(struct BhvInsn *insn) {
+    cur_obj_add_float(insn->field, insn->args[0].f);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_float(struct BhvInsn *insn) {
+    cur_obj_set_float(insn->field, insn->args[0].f);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_add_int(struct BhvInsn *insn) {
+    cur_obj_add_int(insn->field, insn->args[0].i);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_int(struct BhvInsn *insn) {
+    cur_obj_set_int(insn->field, insn->args[0].i);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_or_int(struct BhvInsn *insn) {
+    cur_obj_or_int(insn->field, insn->args[0].i);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_and_int(struct BhvInsn *insn) {
+    cur_obj_and_int(insn->field, insn->args[0].i);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_sum_float(struct BhvInsn *insn) {
+    cur_obj_set_float(insn->field, cur_obj_get_float(insn->args[0].i) + cur_obj_get_float(insn->args[1].i));
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_animate_texture(struct BhvInsn *insn) {
+    if ((gGlobalTimer % insn->args[0].i) == 0) {
+        cur_obj_add_int(insn->field, 1);
+    }
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_billboard(struct BhvInsn *insn) {
+    gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_BILLBOARD;
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_hide(struct BhvInsn *insn) {
+    cur_obj_hide();
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_hitbox(struct BhvInsn *insn) {
+    gCurrentObject->hitboxRadius = insn->args[0].f;
+    gCurrentObject->hitboxHeight = insn->args[1].f;
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_hurtbox(struct BhvInsn *insn) {
+    gCurrentObject->hurtboxRadius = insn->args[0].f;
+    gCurrentObject->hurtboxHeight = insn->args[1].f;
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_vptr(struct BhvInsn *insn) {
+    cur_obj_set_vptr(insn->field, insn->args[0].ptr);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_animate(struct BhvInsn *insn) {
+    struct Animation **animations = gCurrentObject->oAnimations;
+
+    geo_obj_init_animation(&gCurrentObject->header.gfx, &animations[insn->args[0].i]);
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_home(struct BhvInsn *insn) {
+    gCurrentObject->oHomeX = gCurrentObject->oPosX;
+    gCurrentObject->oHomeY = gCurrentObject->oPosY;
+    gCurrentObject->oHomeZ = gCurrentObject->oPosZ;
+
+    return bhv_insn_advance(insn);
+}
+
+static struct BhvInsn *bhv_insn_set_interact_type(struct BhvInsn *insn) {
+    gCurrentObject->oInteractType = insn->args[0].i;
+
+    return bhv_insn_advance(insn);
+}
+
+// Length in script words of each command, by command ID.
+static const u8 sBhvCmdLengths[] = {
+    1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, // 0x00
+    1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 3, 1, 1, 1, // 0x10
+    1, 1, 1, 2, 1, 1, 1, 2, 1, 3, 2, 3, 3, 1, 2, 2, // 0x20
+    5, 2, 1, 2, 1, 1, 2, 2,                         // 0x30
+};
+
+/**
+ * Decode one command, returning TRUE if execution never falls through past it.
+ */
+static s32 bhv_decode_command(struct BhvInsn *insn, const BehaviorScript *script) {
+    u32 cmd = script[0] >> 24;
+    s32 endsBlock = FALSE;
+
+    insn->proc = bhv_insn_cmd;
+    insn->script = script;
+    insn->next = NULL;
+    insn->target = NULL;
+    insn->field = (script[0] >> 16) & 0xFF;
+    insn->length = sBhvCmdLengths[cmd];
+
+    switch (cmd) {
+        case 0x01:
+            insn->proc = bhv_insn_delay;
+            insn->args[0].i = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x02:
+            insn->proc = bhv_insn_call;
+            insn->args[0].ptr = segmented_to_virtual((void *) script[1]);
+            break;
+        case 0x03:
+            insn->proc = bhv_insn_return;
+            endsBlock = TRUE;
+            break;
+        case 0x04:
+            insn->proc = bhv_insn_goto;
+            insn->args[0].ptr = segmented_to_virtual((void *) script[1]);
+            endsBlock = TRUE;
+            break;
+        case 0x05:
+            insn->proc = bhv_insn_begin_repeat;
+            insn->args[0].i = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x26:
+            insn->proc = bhv_insn_begin_repeat;
+            insn->args[0].i = (u8)((script[0] >> 16) & 0xFF);
+            break;
+        case 0x06:
+            insn->proc = bhv_insn_end_repeat;
+            break;
+        case 0x07:
+            insn->proc = bhv_insn_end_repeat_continue;
+            break;
+        case 0x08:
+            insn->proc = bhv_insn_begin_loop;
+            break;
+        case 0x09:
+            insn->proc = bhv_insn_end_loop;
+            endsBlock = TRUE;
+            break;
+        case 0x0A:
+        case 0x0B:
+            insn->proc = bhv_insn_break;
+            endsBlock = TRUE;
+            break;
+        case 0x1D:
+            insn->proc = bhv_insn_deactivate;
+            endsBlock = TRUE;
+            break;
+        case 0x0C:
+            insn->proc = bhv_insn_call_native;
+            insn->args[0].ptr = (void *) script[1];
+            break;
+        case 0x0D:
+            insn->proc = bhv_insn_add_float;
+            insn->args[0].f = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x0E:
+            insn->proc = bhv_insn_set_float;
+            insn->args[0].f = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x0F:
+            insn->proc = bhv_insn_add_int;
+            insn->args[0].i = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x10:
+            insn->proc = bhv_insn_set_int;
+            insn->args[0].i = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x11:
+            insn->proc = bhv_insn_or_int;
+            insn->args[0].i = script[0] & 0xFFFF;
+            break;
+        case 0x12:
+            insn->proc = bhv_insn_and_int;
+            insn->args[0].i = (script[0] & 0xFFFF) ^ 0xFFFF;
+            break;
+        case 0x1F:
+            insn->proc = bhv_insn_sum_float;
+            insn->args[0].i = (script[0] >> 8) & 0xFF;
+            insn->args[1].i = script[0] & 0xFF;
+            break;
+        case 0x34:
+            insn->proc = bhv_insn_animate_texture;
+            insn->args[0].i = (s16)(script[0] & 0xFFFF);
+            break;
+        case 0x21:
+            insn->proc = bhv_insn_billboard;
+            break;
+        case 0x22:
+            insn->proc = bhv_insn_hide;
+            break;
+        case 0x23:
+            insn->proc = bhv_insn_set_hitbox;
+            insn->args[0].f = (s16)(script[1] >> 16);
+            insn->args[1].f = (s16)(script[1] & 0xFFFF);
+            break;
+        case 0x2E:
+            insn->proc = bhv_insn_set_hurtbox;
+            insn->args[0].f = (s16)(script[1] >> 16);
+            insn->args[1].f = (s16)(script[1] & 0xFFFF);
+            break;
+        case 0x27:
+            insn->proc = bhv_insn_set_vptr;
+            insn->args[0].ptr = (void *) script[1];
+            break;
+        case 0x28:
+            insn->proc = bhv_insn_animate;
+            insn->args[0].i = (script[0] >> 16) & 0xFF;
+            break;
+        case 0x2D:
+            insn->proc = bhv_insn_set_home;
+            break;
+        case 0x2F:
+            insn->proc = bhv_insn_set_interact_type;
+            insn->args[0].i = script[1];
+            break;
+    }
+
+    return endsBlock;
+}
+
+/**
+ * Decode the block of commands starting at script. Loop ends are paired with
+ * their loop start here so jumping back doesn't need a lookup.
+ */
+static struct BhvInsn *bhv_decode_block(const BehaviorScript *script) {
+    struct BhvInsn *block = &sBhvInsnPool[sBhvInsnPoolUsed];
+    struct BhvInsn *loopStarts[BHV_INSN_MAX_LOOP_DEPTH];
+    s32 loopDepth = 0;
+    s32 count = 0;
+    s32 endsBlock = FALSE;
+    struct BhvInsn *insn;
+    u32 cmd;
+    s32 i;
+
+    while (!endsBlock && sBhvInsnPoolUsed + count < BHV_INSN_POOL_SIZE) {
+        cmd = script[0] >> 24;
+        if (cmd >= ARRAY_COUNT(sBhvCmdLengths)) {
+            break;
+        }
+
+        insn = &block[count++];
+        endsBlock = bhv_decode_command(insn, script);
+        script += insn->length;
+
+        switch (cmd) {
+            case 0x05:
+            case 0x08:
+            case 0x26:
+                if (loopDepth < BHV_INSN_MAX_LOOP_DEPTH) {
+                    loopStarts[loopDepth] = insn;
+                }
+                loopDepth++;
+                break;
+            case 0x06:
+            case 0x07:
+            case 0x09:
+                if (loopDepth > 0 && --loopDepth < BHV_INSN_MAX_LOOP_DEPTH) {
+                    insn->target = loopStarts[loopDepth] + 1;
+                }
+                break;
+        }
+    }
+
+    if (count == 0) {
+        return NULL;
+    }
+
+    sBhvInsnPoolUsed += count;
+    for (i = 0; i < count - 1; i++) {
+        block[i].next = &block[i + 1];
+    }
+
+    // Also make the places RETURN and loops come back to findable
+    bhv_insn_register(block);
+    for (i = 0; i < count - 1; i++) {
+        switch (block[i].script[0] >> 24) {
+            case 0x02:
+            case 0x05:
+            case 0x08:
+            case 0x26:
+                bhv_insn_register(&block[i + 1]);
+                break;
+        }
+    }
+
+    return block;
+}
+
+/**
+ * Find the decoded instruction for a script address, decoding it if needed.
+ * Returns NULL if it can't be decoded.
+ */
+static struct BhvInsn *bhv_insn_lookup(const BehaviorScript *script) {
+    struct BhvInsnHashEntry *entry = bhv_insn_hash_find(script);
+
+    if (entry->script == script) {
+        return entry->insn;
+    }
+    if (sBhvInsnHashUsed >= BHV_INSN_HASH_SIZE * 3 / 4) {
+        return NULL;
+    }
+
+    return bhv_decode_block(script);
+}
+
+// Run the current object's behavior script from its decoded instructions.
+static void cur_obj_run_bhv_insns(void) {
+    s32 index = gCurrentObject - gObjectPool;
+    struct BhvInsn *insn = sObjectBhvInsns[index];
+
+    if (insn == NULL || insn->script != gCurBhvCommand) {
+        insn = bhv_insn_lookup(gCurBhvCommand);
+    }
+
+    if (insn == NULL) {
+        cur_obj_run_bhv_commands();
+        sObjectBhvInsns[index] = NULL;
+        return;
+    }
+
+    do {
+        insn = insn->proc(insn);
+    } while (insn != NULL);
+
+    sObjectBhvInsns[index] = sBhvResumeInsn;
+}
+#endif
+
 // Execute the behavior script of the current object, process the object flags, and other miscellaneous code for updating objects.
 void cur_obj_update(void) {
     UNUSED u32 unused;
 
     s16 objFlags = gCurrentObject->oFlags;
     f32 distanceFromMario;
-    BhvCommandProc bhvCmdProc;
-    s32 bhvProcResult;
 
     // Calculate the distance from the object to Mario.
     if (objFlags & OBJ_FLAG_COMPUTE_DIST_TO_MARIO) {
@@ -878,10 +1486,11 @@ void cur_obj_update(void) {
     // Execute the behavior script.
     gCurBhvCommand = gCurrentObject->curBhvCommand;
 
-    do {
-        bhvCmdProc = BehaviorCmdTable[*gCurBhvCommand >> 24];
-        bhvProcResult = bhvCmdProc();
-    } while (bhvProcResult == BHV_PROC_CONTINUE);
+#ifdef PREDECODE_BEHAVIORS
+    cur_obj_run_bhv_insns();
+#else
+    cur_obj_run_bhv_commands();
+#endif
 
     gCurrentObject->curBhvCommand = gCurBhvCommand;
 
@@ -945,4 +1554,22 @@ void cur_obj_update(void) {
             }
         }
     }
+
+#ifdef OBJECT_HASH
+    // Keep the object's collision cell up to date as it moves
+    obj_hash_update_position(gCurrentObject);
+#endif
+}
+
+#ifdef SNAPSHOTS
+/**
+ * Register the behavior state for snapshots. Decoded instructions are only
+ * ever appended to the pool, so the per object pointers into it stay valid.
+ */
+void behavior_script_snapshot_regions(void) {
+    SNAPSHOT_REGION(gRandomSeed16);
+#ifdef PREDECODE_BEHAVIORS
+    SNAPSHOT_REGION(sObjectBhvInsns);
+#endif
 }
+#endif
@@ -22,6 +22,12 @@
 u16 random_u16(void);
 float random_float(void);
 s32 random_sign(void);
+#ifdef HEADLESS
+u16 random_get_seed(void);
+#endif
+#ifdef SNAPSHOTS
+void behavior_script_snapshot_regions(void);
+#endif
 
 void stub_behavior_script_2(void);
 
@@ -24,6 +24,11 @@
 #include "math_util.h"
 #include "surface_collision.h"
 #include "surface_load.h"
+#include "game/snapshot.h"
+
+#ifdef LOAD_PROFILER
+#include <stdio.h>
+#endif
 
 #define CMD_GET(type, offset) (*(type *) (CMD_PROCESS_OFFSET(offset) + (u8 *) sCurrentCmd))
 
@@ -55,6 +60,66 @@ static s16 sScriptStatus;
 static s32 sRegister;
 static struct LevelCommand *sCurrentCmd;
 
+#ifdef SHARED_GEO_LAYOUTS
+/**
+ * Geo layouts processed into the current level pool. Loading a layout again
+ * under another model id shares the graph nodes built the first time, the same
+ * way every object with a given model shares them; the per-object state lives
+ * in the objects' own graph nodes. A level pool's nodes are freed together, so
+ * the entries are dropped when a new level pool is allocated.
+ */
+#define GEO_LAYOUT_CACHE_SIZE 256
+
+static struct {
+    void *layout;
+    struct GraphNode *node;
+    u32 size;
+} sGeoLayoutCache[GEO_LAYOUT_CACHE_SIZE];
+
+static s32 sGeoLayoutCacheCount = 0;
+#endif
+
+#ifdef LOAD_PROFILER
+#define LEVEL_CMD_COUNT 0x3D
+
+struct LoadProfile gLoadProfile;
+
+/**
+ * Time spent in each level command while a level is loading, printed along
+ * with gLoadProfile once the first frame of the level has been drawn.
+ */
+static struct {
+    OSTime cmdTimes[LEVEL_CMD_COUNT];
+    u16 cmdCounts[LEVEL_CMD_COUNT];
+    OSTime startTime;
+    u8 active;
+} sLoadProfile;
+
+static void load_profiler_print(void) {
+    OSTime total = osGetTime() - sLoadProfile.startTime;
+    s32 i;
+
+    // osGetTime ticks in microseconds
+    printf("LOAD: level %d area %d first frame after %u us\n", gCurrLevelNum, gCurrAreaIndex,
+           (unsigned) total);
+    printf("LOAD:   geo layout %u us, terrain %u us (special objects %u us, macro objects %u us), "
+           "spawn info %u us\n",
+           (unsigned) gLoadProfile.geoLayoutTime, (unsigned) gLoadProfile.terrainTime,
+           (unsigned) gLoadProfile.specialObjectTime, (unsigned) gLoadProfile.macroObjectTime,
+           (unsigned) gLoadProfile.spawnInfoTime);
+#ifdef SHARED_GEO_LAYOUTS
+    printf("LOAD:   %u geo layouts shared, %u bytes saved\n", (unsigned) gLoadProfile.geoLayoutsShared,
+           (unsigned) gLoadProfile.geoLayoutBytesSaved);
+#endif
+    for (i = 0; i < LEVEL_CMD_COUNT; i++) {
+        if (sLoadProfile.cmdCounts[i] != 0) {
+            printf("LOAD:   cmd 0x%02X x%u %u us\n", (unsigned) i, (unsigned) sLoadProfile.cmdCounts[i],
+                   (unsigned) sLoadProfile.cmdTimes[i]);
+        }
+    }
+}
+#endif
+
 static s32 eval_script_op(s8 op, s32 arg) {
     s32 result = 0;
 
@@ -306,10 +371,19 @@ static void level_cmd_load_mio0_texture(void) {
 }
 
 static void level_cmd_init_level(void) {
+#ifdef LOAD_PROFILER
+    bzero(&sLoadProfile, sizeof(sLoadProfile));
+    bzero(&gLoadProfile, sizeof(gLoadProfile));
+    sLoadProfile.startTime = osGetTime();
+    sLoadProfile.active = TRUE;
+#endif
     init_graph_node_start(NULL, (struct GraphNodeStart *) &gObjParentGraphNode);
     clear_objects();
     clear_areas();
     main_pool_push_state();
+#ifdef MIO0_CACHE
+    bzero(&gSegmentLoadStats, sizeof(gSegmentLoadStats));
+#endif
 
     sCurrentCmd = CMD_NEXT;
 }
@@ -327,6 +401,9 @@ static void level_cmd_alloc_level_pool(void) {
     if (sLevelPool == NULL) {
         sLevelPool = alloc_only_pool_init(main_pool_available() - sizeof(struct AllocOnlyPool),
                                           MEMORY_POOL_LEFT);
+#ifdef SHARED_GEO_LAYOUTS
+        sGeoLayoutCacheCount = 0;
+#endif
     }
 
     sCurrentCmd = CMD_NEXT;
@@ -353,10 +430,17 @@ static void level_cmd_begin_area(void) {
     void *geoLayoutAddr = CMD_GET(void *, 4);
 
     if (areaIndex < 8) {
+#ifdef LOAD_PROFILER
+        OSTime startTime = osGetTime();
+#endif
         struct GraphNodeRoot *screenArea =
             (struct GraphNodeRoot *) process_geo_layout(sLevelPool, geoLayoutAddr);
         struct GraphNodeCamera *node = (struct GraphNodeCamera *) screenArea->views[0];
 
+#ifdef LOAD_PROFILER
+        gLoadProfile.geoLayoutTime += osGetTime() - startTime;
+#endif
+
         sCurrAreaIndex = areaIndex;
         screenArea->areaIndex = areaIndex;
         gAreas[areaIndex].unk04 = screenArea;
@@ -393,12 +477,56 @@ static void level_cmd_load_model_from_dl(void) {
     sCurrentCmd = CMD_NEXT;
 }
 
+#ifdef SHARED_GEO_LAYOUTS
+/**
+ * Process a model's geo layout into the level pool, or return the graph nodes
+ * already built for it in this pool.
+ */
+static struct GraphNode *process_shared_geo_layout(void *layout) {
+    struct GraphNode *node;
+    s32 usedSpace;
+    s32 i;
+
+    for (i = 0; i < sGeoLayoutCacheCount; i++) {
+        if (sGeoLayoutCache[i].layout == layout) {
+#ifdef LOAD_PROFILER
+            gLoadProfile.geoLayoutsShared++;
+            gLoadProfile.geoLayoutBytesSaved += sGeoLayoutCache[i].size;
+#endif
+            return sGeoLayoutCache[i].node;
+        }
+    }
+
+    usedSpace = sLevelPool->usedSpace;
+    node = process_geo_layout(sLevelPool, layout);
+
+    if (sGeoLayoutCacheCount < GEO_LAYOUT_CACHE_SIZE) {
+        sGeoLayoutCache[sGeoLayoutCacheCount].layout = layout;
+        sGeoLayoutCache[sGeoLayoutCacheCount].node = node;
+        sGeoLayoutCache[sGeoLayoutCacheCount].size = sLevelPool->usedSpace - usedSpace;
+        sGeoLayoutCacheCount++;
+    }
+
+    return node;
+}
+#endif
+
 static void level_cmd_load_model_from_geo(void) {
     s16 arg0 = CMD_GET(s16, 2);
     void *arg1 = CMD_GET(void *, 4);
 
     if (arg0 < 256) {
+#ifdef LOAD_PROFILER
+        OSTime startTime = osGetTime();
+#endif
+#ifdef SHARED_GEO_LAYOUTS
+        gLoadedGraphNodes[arg0] = process_shared_geo_layout(arg1);
+#else
         gLoadedGraphNodes[arg0] = process_geo_layout(sLevelPool, arg1);
+#endif
+#ifdef LOAD_PROFILER
+        gLoadProfile.geoLayoutTime += osGetTime() - startTime;
+#endif
     }
 
     sCurrentCmd = CMD_NEXT;
@@ -649,12 +777,51 @@ static void level_cmd_set_macro_objects(void) {
     sCurrentCmd = CMD_NEXT;
 }
 
+#if defined(TARGET_PSP) && defined(ASYNC_TEXTURES)
+// Queue up decoding of the area's level geometry textures before it is first drawn
+static void prefetch_area_textures(struct GraphNode *node) {
+    extern void gfx_prefetch_textures(const Gfx *dl);
+    struct GraphNode *curr = node;
+
+    do {
+        switch (curr->type) {
+            case GRAPH_NODE_TYPE_DISPLAY_LIST:
+                gfx_prefetch_textures(((struct GraphNodeDisplayList *) curr)->displayList);
+                break;
+            case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+                gfx_prefetch_textures(((struct GraphNodeTranslationRotation *) curr)->displayList);
+                break;
+            case GRAPH_NODE_TYPE_TRANSLATION:
+                gfx_prefetch_textures(((struct GraphNodeTranslation *) curr)->displayList);
+                break;
+            case GRAPH_NODE_TYPE_ROTATION:
+                gfx_prefetch_textures(((struct GraphNodeRotation *) curr)->displayList);
+                break;
+            case GRAPH_NODE_TYPE_SCALE:
+                gfx_prefetch_textures(((struct GraphNodeScale *) curr)->displayList);
+                break;
+            case GRAPH_NODE_TYPE_BILLBOARD:
+                gfx_prefetch_textures(((struct GraphNodeBillboard *) curr)->displayList);
+                break;
+        }
+        if (curr->children != NULL) {
+            prefetch_area_textures(curr->children);
+        }
+    } while ((curr = curr->next) != node);
+}
+#endif
+
 static void level_cmd_load_area(void) {
     s16 areaIndex = CMD_GET(u8, 2);
     UNUSED void *unused = (u8 *) sCurrentCmd + 4;
 
     func_80320890();
     load_area(areaIndex);
+#if defined(TARGET_PSP) && defined(ASYNC_TEXTURES)
+    if (gCurrentArea != NULL && gCurrentArea->unk04 != NULL) {
+        prefetch_area_textures(&gCurrentArea->unk04->node);
+    }
+#endif
 
     sCurrentCmd = CMD_NEXT;
 }
@@ -835,9 +1002,24 @@ struct LevelCommand *level_script_execute(struct LevelCommand *cmd) {
     sScriptStatus = SCRIPT_RUNNING;
     sCurrentCmd = cmd;
 
+#ifdef LOAD_PROFILER
+    while (sScriptStatus == SCRIPT_RUNNING) {
+        if (sLoadProfile.active) {
+            u8 type = sCurrentCmd->type;
+            OSTime startTime = osGetTime();
+
+            LevelScriptJumpTable[type]();
+            sLoadProfile.cmdTimes[type] += osGetTime() - startTime;
+            sLoadProfile.cmdCounts[type]++;
+        } else {
+            LevelScriptJumpTable[sCurrentCmd->type]();
+        }
+    }
+#else
     while (sScriptStatus == SCRIPT_RUNNING) {
         LevelScriptJumpTable[sCurrentCmd->type]();
     }
+#endif
 
     profiler_log_thread5_time(LEVEL_SCRIPT_EXECUTE);
     init_render_image();
@@ -845,5 +1027,32 @@ struct LevelCommand *level_script_execute(struct LevelCommand *cmd) {
     end_master_display_list();
     alloc_display_list(0);
 
+#ifdef LOAD_PROFILER
+    // The level has finished loading once the script yields with an area loaded
+    if (sLoadProfile.active && gCurrentArea != NULL) {
+        load_profiler_print();
+        sLoadProfile.active = FALSE;
+    }
+#endif
+
     return sCurrentCmd;
 }
+
+#ifdef SNAPSHOTS
+void level_script_snapshot_regions(void) {
+    SNAPSHOT_REGION(sStack);
+    SNAPSHOT_REGION(sLevelPool);
+    SNAPSHOT_REGION(sDelayFrames);
+    SNAPSHOT_REGION(sDelayFrames2);
+    SNAPSHOT_REGION(sCurrAreaIndex);
+    SNAPSHOT_REGION(sStackTop);
+    SNAPSHOT_REGION(sStackBase);
+    SNAPSHOT_REGION(sScriptStatus);
+    SNAPSHOT_REGION(sRegister);
+    SNAPSHOT_REGION(sCurrentCmd);
+#ifdef SHARED_GEO_LAYOUTS
+    SNAPSHOT_REGION(sGeoLayoutCache);
+    SNAPSHOT_REGION(sGeoLayoutCacheCount);
+#endif
+}
+#endif
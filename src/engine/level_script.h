@@ -2,11 +2,35 @@
 #define LEVEL_SCRIPT_H
 
 #include <PR/ultratypes.h>
+#ifdef LOAD_PROFILER
+#include <PR/os_time.h>
+#endif
 
 struct LevelCommand;
 
 extern u8 level_script_entry[];
 
+#ifdef LOAD_PROFILER
+/**
+ * Time spent on the larger steps of loading a level, filled in from INIT_LEVEL
+ * until the first frame of the level is drawn.
+ */
+struct LoadProfile {
+    OSTime geoLayoutTime;
+    OSTime terrainTime;
+    OSTime specialObjectTime;
+    OSTime macroObjectTime;
+    OSTime spawnInfoTime;
+    u32 geoLayoutsShared;
+    u32 geoLayoutBytesSaved;
+};
+
+extern struct LoadProfile gLoadProfile;
+#endif
+
 struct LevelCommand *level_script_execute(struct LevelCommand *cmd);
+#ifdef SNAPSHOTS
+void level_script_snapshot_regions(void);
+#endif
 
 #endif // LEVEL_SCRIPT_H
@@ -8,6 +8,91 @@
 #include "surface_collision.h"
 #include "surface_load.h"
 
+#ifdef COLLISION_CACHE
+/**************************************************
+ *                  QUERY CACHE                   *
+ **************************************************/
+
+/**
+ * Floor and ceiling queries only depend on the s16 position, a couple of
+ * flags and the partitions, so their results are kept until a partition
+ * changes. Water queries keep the water box that matched, whose height is
+ * read fresh on every hit since behaviors move it.
+ */
+#define COLLISION_CACHE_SIZE 1024
+
+enum CollisionCacheKind {
+    COLLISION_CACHE_FLOOR = 1,
+    COLLISION_CACHE_CEIL,
+    COLLISION_CACHE_WATER
+};
+
+// Flags that are part of the key
+#define COLLISION_CACHE_CAMERA     (1 << 0)
+#define COLLISION_CACHE_INTANGIBLE (1 << 1)
+#define COLLISION_CACHE_X_FRACTION (1 << 2)
+#define COLLISION_CACHE_Z_FRACTION (1 << 3)
+
+struct CollisionCacheEntry {
+    u32 generation;
+    s16 x, y, z;
+    u8 kind;
+    u8 flags;
+    u8 staticFloorMissed;
+    f32 height;
+    struct Surface *surface;
+    s16 *waterLevel;
+};
+
+static struct CollisionCacheEntry sCollisionCache[COLLISION_CACHE_SIZE];
+
+struct CollisionCacheStats gCollisionCacheStats;
+
+/**
+ * Returns the entry for a query, with a matching key if it's a hit.
+ */
+static struct CollisionCacheEntry *collision_cache_entry(u8 kind, s16 x, s16 y, s16 z, u8 flags, s32 *hit) {
+    u32 hash = (x * 73856093) ^ (y * 19349663) ^ (z * 83492791) ^ (kind * 0x9E37) ^ flags;
+    struct CollisionCacheEntry *entry = &sCollisionCache[(hash ^ (hash >> 10)) & (COLLISION_CACHE_SIZE - 1)];
+
+    gCollisionCacheStats.queries++;
+
+    *hit = entry->generation == gSurfacePartitionGeneration && entry->kind == kind && entry->flags == flags
+           && entry->x == x && entry->y == y && entry->z == z;
+    if (*hit) {
+        gCollisionCacheStats.hits++;
+    }
+
+    return entry;
+}
+
+static void collision_cache_store(struct CollisionCacheEntry *entry, u8 kind, s16 x, s16 y, s16 z, u8 flags) {
+    entry->generation = gSurfacePartitionGeneration;
+    entry->kind = kind;
+    entry->flags = flags;
+    entry->x = x;
+    entry->y = y;
+    entry->z = z;
+}
+
+/**
+ * Only every 16th miss is timed, reading the clock isn't free either.
+ */
+static OSTime collision_cache_start_timing(void) {
+    if ((gCollisionCacheStats.queries & 15) == 0) {
+        return osGetTime();
+    }
+    return 0;
+}
+
+static void collision_cache_end_timing(OSTime startTime) {
+    if (startTime != 0) {
+        gCollisionCacheStats.missTime += osGetTime() - startTime;
+        gCollisionCacheStats.timedMisses++;
+    }
+}
+#endif
+
 /**************************************************
  *                      WALLS                     *
  **************************************************/
@@ -310,6 +395,12 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     f32 height = 20000.0f;
     f32 dynamicHeight = 20000.0f;
     s16 x, y, z;
+#ifdef COLLISION_CACHE
+    struct CollisionCacheEntry *entry;
+    u8 cacheFlags;
+    OSTime startTime;
+    s32 hit;
+#endif
 
     //! (Parallel Universes) Because position is casted to an s16, reaching higher
     // float locations  can return ceilings despite them not existing there.
@@ -326,6 +417,17 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
         return height;
     }
 
+#ifdef COLLISION_CACHE
+    cacheFlags = gCheckingSurfaceCollisionsForCamera != 0 ? COLLISION_CACHE_CAMERA : 0;
+    entry = collision_cache_entry(COLLISION_CACHE_CEIL, x, y, z, cacheFlags, &hit);
+    if (hit) {
+        *pceil = entry->surface;
+        gNumCalls.ceil += 1;
+        return entry->height;
+    }
+    startTime = collision_cache_start_timing();
+#endif
+
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
@@ -345,6 +447,13 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
 
     *pceil = ceil;
 
+#ifdef COLLISION_CACHE
+    collision_cache_store(entry, COLLISION_CACHE_CEIL, x, y, z, cacheFlags);
+    entry->surface = ceil;
+    entry->height = height;
+    collision_cache_end_timing(startTime);
+#endif
+
     // Increment the debug tracker.
     gNumCalls.ceil += 1;
 
@@ -522,6 +631,13 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     s16 y = (s16) yPos;
     s16 z = (s16) zPos;
 
+#ifdef COLLISION_CACHE
+    struct CollisionCacheEntry *entry;
+    u8 cacheFlags;
+    OSTime startTime;
+    s32 hit;
+#endif
+
     *pfloor = NULL;
 
     if (x <= -LEVEL_BOUNDARY_MAX || x >= LEVEL_BOUNDARY_MAX) {
@@ -531,6 +647,24 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         return height;
     }
 
+#ifdef COLLISION_CACHE
+    cacheFlags = gCheckingSurfaceCollisionsForCamera != 0 ? COLLISION_CACHE_CAMERA : 0;
+    if (gFindFloorIncludeSurfaceIntangible) {
+        cacheFlags |= COLLISION_CACHE_INTANGIBLE;
+    }
+    entry = collision_cache_entry(COLLISION_CACHE_FLOOR, x, y, z, cacheFlags, &hit);
+    if (hit) {
+        gFindFloorIncludeSurfaceIntangible = FALSE;
+        if (entry->staticFloorMissed) {
+            gNumFindFloorMisses += 1;
+        }
+        *pfloor = entry->surface;
+        gNumCalls.floor += 1;
+        return entry->height;
+    }
+    startTime = collision_cache_start_timing();
+#endif
+
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & 0xF;
@@ -564,6 +698,10 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         gNumFindFloorMisses += 1;
     }
 
+#ifdef COLLISION_CACHE
+    entry->staticFloorMissed = floor == NULL;
+#endif
+
     if (dynamicHeight > height) {
         floor = dynamicFloor;
         height = dynamicHeight;
@@ -571,6 +709,13 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
 
     *pfloor = floor;
 
+#ifdef COLLISION_CACHE
+    collision_cache_store(entry, COLLISION_CACHE_FLOOR, x, y, z, cacheFlags);
+    entry->surface = floor;
+    entry->height = height;
+    collision_cache_end_timing(startTime);
+#endif
+
     // Increment the debug tracker.
     gNumCalls.floor += 1;
 
@@ -582,14 +727,14 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
  **************************************************/
 
 /**
- * Finds the height of water at a given location.
+ * Finds the water box containing a given location, and returns where its height is stored.
  */
-f32 find_water_level(f32 x, f32 z) {
+static s16 *find_water_level_box(f32 x, f32 z) {
     s32 i;
     s32 numRegions;
     s16 val;
     f32 loX, hiX, loZ, hiZ;
-    f32 waterLevel = -11000.0f;
+    s16 *waterLevel = NULL;
     s16 *p = gEnvironmentRegions;
 
     if (p != NULL) {
@@ -606,7 +751,7 @@ f32 find_water_level(f32 x, f32 z) {
             // Water is less than 50 val only, while above is gas and such.
             if (loX < x && x < hiX && loZ < z && z < hiZ && val < 50) {
                 // Set the water height. Since this breaks, only return the first height.
-                waterLevel = *p;
+                waterLevel = p;
                 break;
             }
             p++;
@@ -616,6 +761,57 @@ f32 find_water_level(f32 x, f32 z) {
     return waterLevel;
 }
 
+/**
+ * Finds the height of water at a given location.
+ */
+f32 find_water_level(f32 x, f32 z) {
+    s16 *waterLevel;
+#ifdef COLLISION_CACHE
+    struct CollisionCacheEntry *entry = NULL;
+    s16 cellX, cellZ;
+    u8 cacheFlags = 0;
+    OSTime startTime = 0;
+    s32 hit;
+
+    // The water box bounds are whole numbers, so the floor of the position and whether
+    // it has a fraction decide which boxes contain it.
+    if (x > -30000.0f && x < 30000.0f && z > -30000.0f && z < 30000.0f) {
+        cellX = (s16) x;
+        cellZ = (s16) z;
+        if (cellX > x) {
+            cellX--;
+        }
+        if (cellZ > z) {
+            cellZ--;
+        }
+        if (cellX != x) {
+            cacheFlags |= COLLISION_CACHE_X_FRACTION;
+        }
+        if (cellZ != z) {
+            cacheFlags |= COLLISION_CACHE_Z_FRACTION;
+        }
+
+        entry = collision_cache_entry(COLLISION_CACHE_WATER, cellX, 0, cellZ, cacheFlags, &hit);
+        if (hit) {
+            return entry->waterLevel != NULL ? *entry->waterLevel : -11000.0f;
+        }
+        startTime = collision_cache_start_timing();
+    }
+#endif
+
+    waterLevel = find_water_level_box(x, z);
+
+#ifdef COLLISION_CACHE
+    if (entry != NULL) {
+        collision_cache_store(entry, COLLISION_CACHE_WATER, cellX, 0, cellZ, cacheFlags);
+        entry->waterLevel = waterLevel;
+        collision_cache_end_timing(startTime);
+    }
+#endif
+
+    return waterLevel != NULL ? *waterLevel : -11000.0f;
+}
+
 /**
  * Finds the height of the poison gas (used only in HMC) at a given location.
  */
@@ -717,6 +913,16 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
     print_debug_top_down_mapinfo("%d", gNumCalls.floor);
     print_debug_top_down_mapinfo("%d", gNumCalls.wall);
     print_debug_top_down_mapinfo("%d", gNumCalls.ceil);
+#ifdef COLLISION_CACHE
+    // Queries answered from the cache, and the time they would have taken judging by the timed misses
+    print_debug_top_down_mapinfo("%d", gCollisionCacheStats.queries);
+    print_debug_top_down_mapinfo("%d", gCollisionCacheStats.queries != 0
+                                           ? gCollisionCacheStats.hits * 100 / gCollisionCacheStats.queries : 0);
+    print_debug_top_down_mapinfo("%d", gCollisionCacheStats.timedMisses != 0
+                                           ? (s32)(gCollisionCacheStats.missTime * gCollisionCacheStats.hits
+                                                   / gCollisionCacheStats.timedMisses) : 0);
+    bzero(&gCollisionCacheStats, sizeof(gCollisionCacheStats));
+#endif
 
     set_text_array_x_y(-80, 0);
 
@@ -724,6 +930,10 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
     print_debug_top_down_mapinfo("listal %d", gSurfaceNodesAllocated);
     print_debug_top_down_mapinfo("statbg %d", gNumStaticSurfaces);
     print_debug_top_down_mapinfo("movebg %d", gSurfacesAllocated - gNumStaticSurfaces);
+#ifdef DYNAMIC_SURFACE_REUSE
+    print_debug_top_down_mapinfo("rebld %d", gNumDynamicSurfacesRebuilt);
+    print_debug_top_down_mapinfo("reuse %d", gNumDynamicSurfacesReused);
+#endif
 
     gNumCalls.floor = 0;
     gNumCalls.ceil = 0;
@@ -29,6 +29,18 @@ struct FloorGeometry
 
 s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 radius);
 s32 find_wall_collisions(struct WallCollisionData *colData);
+#ifdef COLLISION_CACHE
+struct CollisionCacheStats
+{
+    s32 queries;
+    s32 hits;
+    s32 timedMisses;
+    OSTime missTime;
+};
+
+extern struct CollisionCacheStats gCollisionCacheStats;
+#endif
+
 f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil);
 f32 find_floor_height_and_data(f32 xPos, f32 yPos, f32 zPos, struct FloorGeometry **floorGeo);
 f32 find_floor_height(f32 x, f32 y, f32 z);
@@ -1,10 +1,14 @@
 #include <PR/ultratypes.h>
+#ifndef TARGET_N64
+#include <string.h>
+#endif
 
 #include "prevent_bss_reordering.h"
 
 #include "sm64.h"
 #include "game/ingame_menu.h"
 #include "graph_node.h"
+#include "math_util.h"
 #include "behavior_script.h"
 #include "behavior_data.h"
 #include "game/memory.h"
@@ -14,6 +18,8 @@
 #include "game/mario.h"
 #include "game/object_list_processor.h"
 #include "surface_load.h"
+#include "game/snapshot.h"
+#include "level_script.h"
 
 s32 unused8038BE90;
 
@@ -35,8 +41,73 @@ struct Surface *sSurfacePool;
  */
 s16 sSurfacePoolSize;
 
+#ifdef COLLISION_CACHE
+/**
+ * Changes every time a surface is added to or cleared from a partition, so
+ * cached collision queries know when they are out of date.
+ */
+u32 gSurfacePartitionGeneration = 1;
+#endif
+
 u8 unused8038EEA8[0x30];
 
+#ifdef DYNAMIC_SURFACE_REUSE
+/**
+ * Object surfaces are kept between frames. While an object's transform stays
+ * the same, its surfaces and nodes are taken over as they were built instead of
+ * being transformed and binned again; they only get linked back into the
+ * dynamic partition, at the same place a rebuild would put them.
+ */
+struct DynamicSurfaceCache {
+    struct Object *object;
+    const BehaviorScript *behavior;
+    s16 *collisionData;
+    Mat4 transform;
+    s32 firstSurface;
+    s32 numSurfaces;
+    s32 firstNode;
+    s32 numNodes;
+    u32 frame;
+    u8 nodesSorted;
+};
+
+static struct DynamicSurfaceCache sDynamicSurfaceCache[OBJECT_POOL_CAPACITY];
+
+/**
+ * Counts the dynamic partition clears, to tell whether a cache entry was built last frame.
+ */
+static u32 sDynamicSurfaceFrame;
+#endif
+
+#if defined(DYNAMIC_SURFACE_REUSE) || defined(STATIC_SURFACE_BINNING)
+/**
+ * The cell and list each dynamic node was added to, as (cellZ << 6) | (cellX << 2) | listIndex.
+ * Static nodes waiting to be binned use the same encoding.
+ */
+static u16 *sDynamicNodeCells;
+
+/**
+ * For each object's nodes, their offsets ordered by cell, list and priority.
+ */
+static u16 *sDynamicNodeOrder;
+#endif
+
+#ifdef STATIC_SURFACE_BINNING
+/**
+ * Static surfaces are not insertion sorted into their cells one by one, which
+ * is quadratic in the number of surfaces per cell. Their nodes are allocated
+ * and tagged with a cell the same way, then bin_static_surfaces sorts all of
+ * them at once and links them in. Nodes from sFirstUnbinnedStaticNode on have
+ * not been linked yet.
+ */
+static s32 sFirstUnbinnedStaticNode;
+
+/**
+ * Scratch space for sorting static nodes, alongside sDynamicNodeOrder.
+ */
+static u16 *sStaticNodeOrder;
+#endif
+
 /**
  * Allocate the part of the surface node pool to contain a surface node.
  */
@@ -85,6 +156,10 @@ static struct Surface *alloc_surface(void) {
 static void clear_spatial_partition(SpatialPartitionCell *cells) {
     register s32 i = 16 * 16;
 
+#ifdef COLLISION_CACHE
+    gSurfacePartitionGeneration++;
+#endif
+
     while (i--) {
         (*cells)[SPATIAL_PARTITION_FLOORS].next = NULL;
         (*cells)[SPATIAL_PARTITION_CEILS].next = NULL;
@@ -141,10 +216,23 @@ static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surfac
 
     newNode->surface = surface;
 
+#ifdef COLLISION_CACHE
+    gSurfacePartitionGeneration++;
+#endif
+
+#if defined(DYNAMIC_SURFACE_REUSE) || defined(STATIC_SURFACE_BINNING)
+    sDynamicNodeCells[newNode - sSurfaceNodePool] = (cellZ << 6) | (cellX << 2) | listIndex;
+#endif
+
     if (dynamic) {
         list = &gDynamicSurfacePartition[cellZ][cellX][listIndex];
     } else {
+#ifdef STATIC_SURFACE_BINNING
+        // Linked in by bin_static_surfaces
+        return;
+#else
         list = &gStaticSurfacePartition[cellZ][cellX][listIndex];
+#endif
     }
 
     // Loop until we find the appropriate place for the surface in the list.
@@ -162,6 +250,118 @@ static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surfac
     list->next = newNode;
 }
 
+#ifdef STATIC_SURFACE_BINNING
+/**
+ * The sort key add_surface_to_cell uses for a surface in the given list.
+ */
+static s16 surface_list_priority(struct Surface *surface, s16 listIndex) {
+    s16 sortDir;
+
+    if (listIndex == SPATIAL_PARTITION_FLOORS) {
+        sortDir = 1;
+    } else if (listIndex == SPATIAL_PARTITION_CEILS) {
+        sortDir = -1;
+    } else {
+        sortDir = 0;
+    }
+
+    return surface->vertex1[1] * sortDir;
+}
+
+/**
+ * Link every static node added since the last call into its cell, leaving the
+ * lists exactly as add_surface_to_cell would have left them. The nodes are
+ * radix sorted by descending priority and then by cell, both passes stable, so
+ * each cell's new nodes come out highest first and in insertion order on ties.
+ * They are then merged into the cell's list, after any earlier node of equal
+ * priority.
+ */
+// Flips the priority so that ascending key order is descending priority
+#define STATIC_NODE_KEY(i) \
+    ((u16) surface_list_priority(sSurfaceNodePool[first + (i)].surface, cells[i] & 3) ^ 0x7FFF)
+
+static void bin_static_surfaces(void) {
+    s32 first = sFirstUnbinnedStaticNode;
+    s32 count = gSurfaceNodesAllocated - first;
+    u16 *cells = &sDynamicNodeCells[first];
+    u16 *order = sDynamicNodeOrder;
+    u16 *temp = sStaticNodeOrder;
+    u16 offsets[1024];
+    struct SurfaceNode *list = NULL;
+    s32 prevCell = -1;
+    s32 cell;
+    s32 shift;
+    s32 i;
+
+    if (count <= 0) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        order[i] = i;
+    }
+
+    for (shift = 0; shift < 16; shift += 8) {
+        bzero(offsets, 256 * sizeof(u16));
+        for (i = 0; i < count; i++) {
+            offsets[(STATIC_NODE_KEY(i) >> shift) & 0xFF]++;
+        }
+        for (i = 0, cell = 0; i < 256; i++) {
+            u16 n = offsets[i];
+
+            offsets[i] = cell;
+            cell += n;
+        }
+        for (i = 0; i < count; i++) {
+            temp[offsets[(STATIC_NODE_KEY(order[i]) >> shift) & 0xFF]++] = order[i];
+        }
+        memcpy(order, temp, count * sizeof(u16));
+    }
+
+    bzero(offsets, sizeof(offsets));
+    for (i = 0; i < count; i++) {
+        offsets[cells[i]]++;
+    }
+    for (i = 0, cell = 0; i < 1024; i++) {
+        u16 n = offsets[i];
+
+        offsets[i] = cell;
+        cell += n;
+    }
+    for (i = 0; i < count; i++) {
+        temp[offsets[cells[order[i]]]++] = order[i];
+    }
+
+    for (i = 0; i < count; i++) {
+        struct SurfaceNode *node = &sSurfaceNodePool[first + temp[i]];
+        s16 listIndex;
+        s16 priority;
+
+        cell = cells[temp[i]];
+        listIndex = cell & 3;
+        priority = surface_list_priority(node->surface, listIndex);
+
+        if (cell != prevCell) {
+            list = &gStaticSurfacePartition[cell >> 6][(cell >> 2) & 0xF][listIndex];
+            prevCell = cell;
+        }
+
+        while (list->next != NULL && surface_list_priority(list->next->surface, listIndex) >= priority) {
+            list = list->next;
+        }
+
+        node->next = list->next;
+        list->next = node;
+        list = node;
+    }
+
+#ifdef COLLISION_CACHE
+    gSurfacePartitionGeneration++;
+#endif
+    sFirstUnbinnedStaticNode = gSurfaceNodesAllocated;
+}
+#endif
+
 /**
  * Returns the lowest of three values.
  */
@@ -524,6 +724,13 @@ void alloc_surface_pools(void) {
     sSurfacePoolSize = 2300;
     sSurfaceNodePool = main_pool_alloc(7000 * sizeof(struct SurfaceNode), MEMORY_POOL_LEFT);
     sSurfacePool = main_pool_alloc(sSurfacePoolSize * sizeof(struct Surface), MEMORY_POOL_LEFT);
+#if defined(DYNAMIC_SURFACE_REUSE) || defined(STATIC_SURFACE_BINNING)
+    sDynamicNodeCells = main_pool_alloc(7000 * sizeof(u16), MEMORY_POOL_LEFT);
+    sDynamicNodeOrder = main_pool_alloc(7000 * sizeof(u16), MEMORY_POOL_LEFT);
+#endif
+#ifdef STATIC_SURFACE_BINNING
+    sStaticNodeOrder = main_pool_alloc(7000 * sizeof(u16), MEMORY_POOL_LEFT);
+#endif
 
     gCCMEnteredSlide = 0;
     reset_red_coins_collected();
@@ -588,12 +795,29 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
     s16 terrainLoadType = 0;
     s16 *vertexData = NULL;
 
+#ifdef DYNAMIC_SURFACE_REUSE
+    s32 i;
+#endif
+
     // Initialize the data for this.
+#ifdef COLLISION_CACHE
+    gSurfacePartitionGeneration++;
+#endif
     gEnvironmentRegions = NULL;
     gSurfaceNodesAllocated = 0;
     gSurfacesAllocated = 0;
 
+#ifdef DYNAMIC_SURFACE_REUSE
+    // The static surface count is about to change, nothing cached can be used.
+    for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+        sDynamicSurfaceCache[i].object = NULL;
+    }
+#endif
+
     clear_static_surfaces();
+#ifdef STATIC_SURFACE_BINNING
+    sFirstUnbinnedStaticNode = 0;
+#endif
 
     // A while loop iterating through each section of the level data. Sections of data
     // are prefixed by a terrain "type." This type is reused for surfaces as the surface
@@ -607,7 +831,20 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
         } else if (terrainLoadType == TERRAIN_LOAD_VERTICES) {
             vertexData = read_vertex_data(&data);
         } else if (terrainLoadType == TERRAIN_LOAD_OBJECTS) {
+#ifdef LOAD_PROFILER
+            OSTime startTime;
+#endif
+#ifdef STATIC_SURFACE_BINNING
+            // Spawned objects snap to the floors loaded so far
+            bin_static_surfaces();
+#endif
+#ifdef LOAD_PROFILER
+            startTime = osGetTime();
+            spawn_special_objects(index, &data);
+            gLoadProfile.specialObjectTime += osGetTime() - startTime;
+#else
             spawn_special_objects(index, &data);
+#endif
         } else if (terrainLoadType == TERRAIN_LOAD_ENVIRONMENT) {
             load_environmental_regions(&data);
         } else if (terrainLoadType == TERRAIN_LOAD_CONTINUE) {
@@ -620,7 +857,15 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
         }
     }
 
+#ifdef STATIC_SURFACE_BINNING
+    bin_static_surfaces();
+#endif
+
     if (macroObjects != NULL && *macroObjects != -1) {
+#ifdef LOAD_PROFILER
+        OSTime startTime = osGetTime();
+
+#endif
         // If the first macro object presetID is within the range [0, 29].
         // Generally an early spawning method, every object is in BBH (the first level).
         if (0 <= *macroObjects && *macroObjects < 30) {
@@ -630,6 +875,9 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
         else {
             spawn_macro_objects(index, macroObjects);
         }
+#ifdef LOAD_PROFILER
+        gLoadProfile.macroObjectTime += osGetTime() - startTime;
+#endif
     }
 
     gNumStaticSurfaceNodes = gSurfaceNodesAllocated;
@@ -645,34 +893,41 @@ void clear_dynamic_surfaces(void) {
         gSurfaceNodesAllocated = gNumStaticSurfaceNodes;
 
         clear_spatial_partition(&gDynamicSurfacePartition[0][0]);
+#ifdef DYNAMIC_SURFACE_REUSE
+        sDynamicSurfaceFrame++;
+        gNumDynamicSurfacesRebuilt = 0;
+        gNumDynamicSurfacesReused = 0;
+#endif
     }
 }
 
 /**
- * Applies an object's transformation to the object's vertices.
+ * Computes the matrix that takes the gCurrentObject's collision vertices to world space.
  */
-void transform_object_vertices(s16 **data, s16 *vertexData) {
+static void get_object_collision_transform(Mat4 m) {
+    Mat4 *objectTransform = &gCurrentObject->transform;
+
+    if (gCurrentObject->header.gfx.throwMatrix == NULL) {
+        gCurrentObject->header.gfx.throwMatrix = objectTransform;
+        obj_build_transform_from_pos_and_angle(gCurrentObject, O_POS_INDEX, O_FACE_ANGLE_INDEX);
+    }
+
+    obj_apply_scale_to_matrix(gCurrentObject, m, *objectTransform);
+}
+
+/**
+ * Applies a transformation to the object's vertices.
+ */
+static void transform_vertices(s16 **data, s16 *vertexData, Mat4 m) {
     register s16 *vertices;
     register f32 vx, vy, vz;
     register s32 numVertices;
 
-    Mat4 *objectTransform;
-    Mat4 m;
-
-    objectTransform = &gCurrentObject->transform;
-
     numVertices = *(*data);
     (*data)++;
 
     vertices = *data;
 
-    if (gCurrentObject->header.gfx.throwMatrix == NULL) {
-        gCurrentObject->header.gfx.throwMatrix = objectTransform;
-        obj_build_transform_from_pos_and_angle(gCurrentObject, O_POS_INDEX, O_FACE_ANGLE_INDEX);
-    }
-
-    obj_apply_scale_to_matrix(gCurrentObject, m, *objectTransform);
-
     // Go through all vertices, rotating and translating them to transform the object.
     while (numVertices--) {
         vx = *(vertices++);
@@ -688,6 +943,16 @@ void transform_object_vertices(s16 **data, s16 *vertexData) {
     *data = vertices;
 }
 
+/**
+ * Applies an object's transformation to the object's vertices.
+ */
+void transform_object_vertices(s16 **data, s16 *vertexData) {
+    Mat4 m;
+
+    get_object_collision_transform(m);
+    transform_vertices(data, vertexData, m);
+}
+
 /**
  * Load in the surfaces for the gCurrentObject. This includes setting the flags, exertion, and room.
  */
@@ -744,12 +1009,161 @@ void load_object_surfaces(s16 **data, s16 *vertexData) {
     }
 }
 
+#ifdef DYNAMIC_SURFACE_REUSE
+/**
+ * Returns the list priority add_surface_to_cell gives a surface.
+ */
+static s16 dynamic_node_priority(struct SurfaceNode *node, s16 listIndex) {
+    switch (listIndex) {
+        case SPATIAL_PARTITION_FLOORS:
+            return node->surface->vertex1[1];
+        case SPATIAL_PARTITION_CEILS:
+            return -node->surface->vertex1[1];
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Stable sort of a cache entry's nodes by cell, list and falling priority, which is
+ * the order they end up in once each cell list is built.
+ */
+static void sort_dynamic_nodes(struct DynamicSurfaceCache *cache) {
+    u16 *order = &sDynamicNodeOrder[cache->firstNode];
+    u16 *cells = &sDynamicNodeCells[cache->firstNode];
+    struct SurfaceNode *nodes = &sSurfaceNodePool[cache->firstNode];
+    s32 i, j;
+    u16 offset;
+
+    for (i = 0; i < cache->numNodes; i++) {
+        offset = i;
+        for (j = i; j > 0; j--) {
+            u16 prev = order[j - 1];
+            if (cells[prev] < cells[offset]
+                || (cells[prev] == cells[offset]
+                    && dynamic_node_priority(&nodes[prev], cells[prev] & 3)
+                           >= dynamic_node_priority(&nodes[offset], cells[offset] & 3))) {
+                break;
+            }
+            order[j] = prev;
+        }
+        order[j] = offset;
+    }
+
+    cache->nodesSorted = TRUE;
+}
+
+/**
+ * Links a cache entry's nodes into the dynamic partition. Each cell list gets the
+ * object's nodes in one walk, which gives the same list as adding them one by one.
+ */
+static void link_dynamic_nodes(struct DynamicSurfaceCache *cache) {
+    struct SurfaceNode *nodes = &sSurfaceNodePool[cache->firstNode];
+    u16 *order = &sDynamicNodeOrder[cache->firstNode];
+    u16 *cells = &sDynamicNodeCells[cache->firstNode];
+    struct SurfaceNode *list = NULL;
+    struct SurfaceNode *node;
+    s32 cell = -1;
+    s16 surfacePriority;
+    s32 i;
+
+#ifdef COLLISION_CACHE
+    gSurfacePartitionGeneration++;
+#endif
+
+    for (i = 0; i < cache->numNodes; i++) {
+        node = &nodes[order[i]];
+
+        if (cells[order[i]] != cell) {
+            cell = cells[order[i]];
+            list = &gDynamicSurfacePartition[cell >> 6][(cell >> 2) & 0x0F][cell & 3];
+        }
+
+        surfacePriority = dynamic_node_priority(node, cell & 3);
+        while (list->next != NULL) {
+            if (surfacePriority > dynamic_node_priority(list->next, cell & 3)) {
+                break;
+            }
+            list = list->next;
+        }
+
+        node->next = list->next;
+        list->next = node;
+        list = node;
+    }
+}
+
+/**
+ * Puts the gCurrentObject's surfaces from last frame back if the object hasn't changed,
+ * moving them down if objects before it now have fewer. Returns FALSE if they have to
+ * be rebuilt.
+ */
+static s32 reuse_object_surfaces(struct DynamicSurfaceCache *cache, s16 *collisionData, Mat4 m) {
+    s32 surfaceShift, nodeShift;
+    s32 i;
+
+    if (cache->object != gCurrentObject || cache->behavior != gCurrentObject->behavior
+        || cache->collisionData != collisionData || cache->frame != sDynamicSurfaceFrame - 1) {
+        return FALSE;
+    }
+
+    // Objects earlier this frame may already have taken over this object's slots.
+    if (gSurfacesAllocated > cache->firstSurface || gSurfaceNodesAllocated > cache->firstNode) {
+        return FALSE;
+    }
+
+    if (memcmp(cache->transform, m, sizeof(Mat4)) != 0) {
+        return FALSE;
+    }
+
+    surfaceShift = cache->firstSurface - gSurfacesAllocated;
+    nodeShift = cache->firstNode - gSurfaceNodesAllocated;
+
+    if (surfaceShift != 0) {
+        memmove(&sSurfacePool[gSurfacesAllocated], &sSurfacePool[cache->firstSurface],
+                cache->numSurfaces * sizeof(struct Surface));
+    }
+    if (nodeShift != 0) {
+        memmove(&sSurfaceNodePool[gSurfaceNodesAllocated], &sSurfaceNodePool[cache->firstNode],
+                cache->numNodes * sizeof(struct SurfaceNode));
+        memmove(&sDynamicNodeCells[gSurfaceNodesAllocated], &sDynamicNodeCells[cache->firstNode],
+                cache->numNodes * sizeof(u16));
+        memmove(&sDynamicNodeOrder[gSurfaceNodesAllocated], &sDynamicNodeOrder[cache->firstNode],
+                cache->numNodes * sizeof(u16));
+    }
+    if (surfaceShift != 0 || nodeShift != 0) {
+        for (i = 0; i < cache->numNodes; i++) {
+            sSurfaceNodePool[gSurfaceNodesAllocated + i].surface -= surfaceShift;
+        }
+    }
+
+    cache->firstSurface = gSurfacesAllocated;
+    cache->firstNode = gSurfaceNodesAllocated;
+    cache->frame = sDynamicSurfaceFrame;
+
+    if (!cache->nodesSorted) {
+        sort_dynamic_nodes(cache);
+    }
+    link_dynamic_nodes(cache);
+
+    gSurfacesAllocated += cache->numSurfaces;
+    gSurfaceNodesAllocated += cache->numNodes;
+    gNumDynamicSurfacesReused += cache->numSurfaces;
+
+    return TRUE;
+}
+#endif
+
 /**
  * Transform an object's vertices, reload them, and render the object.
  */
 void load_object_collision_model(void) {
     UNUSED s32 unused;
     s16 vertexData[600];
+#ifdef DYNAMIC_SURFACE_REUSE
+    struct DynamicSurfaceCache *cache;
+    Mat4 m;
+#endif
 
     s16 *collisionData = gCurrentObject->collisionData;
     f32 marioDist = gCurrentObject->oDistanceToMario;
@@ -771,12 +1185,39 @@ void load_object_collision_model(void) {
     if (!(gTimeStopState & TIME_STOP_ACTIVE) && marioDist < tangibleDist
         && !(gCurrentObject->activeFlags & ACTIVE_FLAG_IN_DIFFERENT_ROOM)) {
         collisionData++;
+#ifdef DYNAMIC_SURFACE_REUSE
+        cache = &sDynamicSurfaceCache[gCurrentObject - gObjectPool];
+        get_object_collision_transform(m);
+
+        if (!reuse_object_surfaces(cache, collisionData, m)) {
+            cache->object = gCurrentObject;
+            cache->behavior = gCurrentObject->behavior;
+            cache->collisionData = collisionData;
+            mtxf_copy(cache->transform, m);
+            cache->firstSurface = gSurfacesAllocated;
+            cache->firstNode = gSurfaceNodesAllocated;
+            cache->frame = sDynamicSurfaceFrame;
+            cache->nodesSorted = FALSE;
+
+            transform_vertices(&collisionData, vertexData, m);
+
+            // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
+            while (*collisionData != TERRAIN_LOAD_CONTINUE) {
+                load_object_surfaces(&collisionData, vertexData);
+            }
+
+            cache->numSurfaces = gSurfacesAllocated - cache->firstSurface;
+            cache->numNodes = gSurfaceNodesAllocated - cache->firstNode;
+            gNumDynamicSurfacesRebuilt += cache->numSurfaces;
+        }
+#else
         transform_object_vertices(&collisionData, vertexData);
 
         // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
         while (*collisionData != TERRAIN_LOAD_CONTINUE) {
             load_object_surfaces(&collisionData, vertexData);
         }
+#endif
     }
 
     if (marioDist < gCurrentObject->oDrawingDistance) {
@@ -785,3 +1226,20 @@ void load_object_collision_model(void) {
         gCurrentObject->header.gfx.node.flags &= ~GRAPH_RENDER_ACTIVE;
     }
 }
+
+#ifdef SNAPSHOTS
+void surface_load_snapshot_regions(void) {
+#ifdef DYNAMIC_SURFACE_REUSE
+    SNAPSHOT_REGION(sDynamicSurfaceCache);
+    SNAPSHOT_REGION(sDynamicSurfaceFrame);
+#endif
+#if defined(DYNAMIC_SURFACE_REUSE) || defined(STATIC_SURFACE_BINNING)
+    SNAPSHOT_REGION(sDynamicNodeCells);
+    SNAPSHOT_REGION(sDynamicNodeOrder);
+#endif
+#ifdef STATIC_SURFACE_BINNING
+    SNAPSHOT_REGION(sFirstUnbinnedStaticNode);
+    SNAPSHOT_REGION(sStaticNodeOrder);
+#endif
+}
+#endif
@@ -28,6 +28,9 @@ extern SpatialPartitionCell gDynamicSurfacePartition[16][16];
 extern struct SurfaceNode *sSurfaceNodePool;
 extern struct Surface *sSurfacePool;
 extern s16 sSurfacePoolSize;
+#ifdef COLLISION_CACHE
+extern u32 gSurfacePartitionGeneration;
+#endif
 
 void alloc_surface_pools(void);
 #ifdef NO_SEGMENTED_MEMORY
@@ -36,5 +39,8 @@ u32 get_area_terrain_size(s16 *data);
 void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects);
 void clear_dynamic_surfaces(void);
 void load_object_collision_model(void);
+#ifdef SNAPSHOTS
+void surface_load_snapshot_regions(void);
+#endif
 
 #endif // SURFACE_LOAD_H
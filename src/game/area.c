@@ -21,6 +21,7 @@
 #include "engine/geo_layout.h"
 #include "save_file.h"
 #include "level_table.h"
+#include "engine/level_script.h"
 
 struct SpawnInfo gPlayerSpawnInfos[1];
 struct GraphNode *D_8033A160[0x100];
@@ -181,6 +182,9 @@ void clear_areas(void) {
     gWarpTransition.isActive = FALSE;
     gWarpTransition.pauseRendering = FALSE;
     gMarioSpawnInfo->areaIndex = -1;
+#ifdef FLAT_RENDER_LIST
+    geo_clear_render_lists();
+#endif
 
     for (i = 0; i < 8; i++) {
         gAreaData[i].index = i;
@@ -223,18 +227,33 @@ void clear_area_graph_nodes(void) {
 }
 
 void load_area(s32 index) {
+#ifdef LOAD_PROFILER
+    OSTime startTime;
+#endif
+
     if (gCurrentArea == NULL && gAreaData[index].unk04 != NULL) {
         gCurrentArea = &gAreaData[index];
         gCurrAreaIndex = gCurrentArea->index;
 
+#ifdef LOAD_PROFILER
+        startTime = osGetTime();
+#endif
+
         if (gCurrentArea->terrainData != NULL) {
             load_area_terrain(index, gCurrentArea->terrainData, gCurrentArea->surfaceRooms,
                               gCurrentArea->macroObjects);
         }
+#ifdef LOAD_PROFILER
+        gLoadProfile.terrainTime += osGetTime() - startTime;
+        startTime = osGetTime();
+#endif
 
         if (gCurrentArea->objectSpawnInfos != NULL) {
             spawn_objects_from_info(0, gCurrentArea->objectSpawnInfos);
         }
+#ifdef LOAD_PROFILER
+        gLoadProfile.spawnInfoTime += osGetTime() - startTime;
+#endif
 
         load_obj_warp_nodes();
         geo_call_global_function_nodes(&gCurrentArea->unk04->node, GEO_CONTEXT_AREA_LOAD);
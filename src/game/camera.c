@@ -28,6 +28,7 @@
 #include "paintings.h"
 #include "engine/graph_node.h"
 #include "level_table.h"
+#include "snapshot.h"
 
 #define CBUTTON_MASK (U_CBUTTONS | D_CBUTTONS | L_CBUTTONS | R_CBUTTONS)
 
@@ -11481,6 +11482,86 @@ void obj_rotate_towards_point(struct Object *o, Vec3f point, s16 pitchOff, s16 y
     o->oMoveAngleYaw = approach_s16_asymptotic(o->oMoveAngleYaw, yaw + yawOff, yawDiv);
 }
 
+#ifdef SNAPSHOTS
+/**
+ * Register the camera state for snapshots. The Camera struct itself lives in
+ * the main pool. Static locals of the camera functions aren't covered.
+ */
+void camera_snapshot_regions(void) {
+    SNAPSHOT_REGION(sOldPosition);
+    SNAPSHOT_REGION(sOldFocus);
+    SNAPSHOT_REGION(gPlayerCameraState);
+    SNAPSHOT_REGION(sPlayer2FocusOffset);
+    SNAPSHOT_REGION(sCreditsPlayer2Pitch);
+    SNAPSHOT_REGION(sCreditsPlayer2Yaw);
+    SNAPSHOT_REGION(sFramesPaused);
+    SNAPSHOT_REGION(gLakituState);
+    SNAPSHOT_REGION(sFOVState);
+    SNAPSHOT_REGION(sModeTransition);
+    SNAPSHOT_REGION(sMarioGeometry);
+    SNAPSHOT_REGION(gCamera);
+    SNAPSHOT_REGION(sAvoidYawVel);
+    SNAPSHOT_REGION(sCameraYawAfterDoorCutscene);
+    SNAPSHOT_REGION(sCurCreditsSplinePos);
+    SNAPSHOT_REGION(sCurCreditsSplineFocus);
+    SNAPSHOT_REGION(sCutsceneSplineSegmentProgress);
+    SNAPSHOT_REGION(sCutsceneSplineSegment);
+    SNAPSHOT_REGION(sHandheldShakeSpline);
+    SNAPSHOT_REGION(sHandheldShakeMag);
+    SNAPSHOT_REGION(sHandheldShakeTimer);
+    SNAPSHOT_REGION(sHandheldShakeInc);
+    SNAPSHOT_REGION(sHandheldShakePitch);
+    SNAPSHOT_REGION(sHandheldShakeYaw);
+    SNAPSHOT_REGION(sHandheldShakeRoll);
+    SNAPSHOT_REGION(gCutsceneObjSpawn);
+    SNAPSHOT_REGION(gObjCutsceneDone);
+    SNAPSHOT_REGION(sSelectionFlags);
+    SNAPSHOT_REGION(gCameraMovementFlags);
+    SNAPSHOT_REGION(sStatusFlags);
+    SNAPSHOT_REGION(s2ndRotateFlags);
+    SNAPSHOT_REGION(sCameraSoundFlags);
+    SNAPSHOT_REGION(sCButtonsPressed);
+    SNAPSHOT_REGION(sCutsceneDialogID);
+    SNAPSHOT_REGION(sCutsceneShot);
+    SNAPSHOT_REGION(gCutsceneTimer);
+    SNAPSHOT_REGION(sAreaYaw);
+    SNAPSHOT_REGION(sAreaYawChange);
+    SNAPSHOT_REGION(sLakituDist);
+    SNAPSHOT_REGION(sLakituPitch);
+    SNAPSHOT_REGION(sZoomAmount);
+    SNAPSHOT_REGION(sCSideButtonYaw);
+    SNAPSHOT_REGION(sBehindMarioSoundTimer);
+    SNAPSHOT_REGION(sZeroZoomDist);
+    SNAPSHOT_REGION(sCUpCameraPitch);
+    SNAPSHOT_REGION(sModeOffsetYaw);
+    SNAPSHOT_REGION(sSpiralStairsYawOffset);
+    SNAPSHOT_REGION(s8DirModeBaseYaw);
+    SNAPSHOT_REGION(s8DirModeYawOffset);
+    SNAPSHOT_REGION(sPanDistance);
+    SNAPSHOT_REGION(sCannonYOffset);
+    SNAPSHOT_REGION(sCutsceneVars);
+    SNAPSHOT_REGION(sModeInfo);
+    SNAPSHOT_REGION(sCastleEntranceOffset);
+    SNAPSHOT_REGION(sParTrackIndex);
+    SNAPSHOT_REGION(sParTrackPath);
+    SNAPSHOT_REGION(sParTrackTransOff);
+    SNAPSHOT_REGION(sCameraStoreCUp);
+    SNAPSHOT_REGION(sCameraStoreCutscene);
+    SNAPSHOT_REGION(gCutsceneFocus);
+    SNAPSHOT_REGION(gSecondCameraFocus);
+    SNAPSHOT_REGION(sYawSpeed);
+    SNAPSHOT_REGION(gCurrLevelArea);
+    SNAPSHOT_REGION(gPrevLevel);
+    SNAPSHOT_REGION(gCameraZoomDist);
+    SNAPSHOT_REGION(sObjectCutscene);
+    SNAPSHOT_REGION(gRecentCutscene);
+    SNAPSHOT_REGION(sFramesSinceCutsceneEnded);
+    SNAPSHOT_REGION(sCutsceneDialogResponse);
+    SNAPSHOT_REGION(sMarioCamState);
+    SNAPSHOT_REGION(sLuigiCamState);
+}
+#endif
+
 #include "behaviors/intro_peach.inc.c"
 #include "behaviors/intro_lakitu.inc.c"
 #include "behaviors/end_birds_1.inc.c"
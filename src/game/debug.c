@@ -246,6 +246,13 @@ void print_surfaceinfo(void) {
 void print_stageinfo(void) {
     print_debug_top_down_normal("stageinfo", 0);
     print_debug_top_down_normal("stage param %d", gTTCSpeedSetting);
+#ifdef MIO0_CACHE
+    // Time spent on MIO0 segments while loading the level (osGetTime counts at 46.875 MHz),
+    // and how many came from the cache
+    print_debug_top_down_normal("load us %d", (s32)(gSegmentLoadStats.time * 64 / 3000));
+    print_debug_top_down_normal("load seg %d", gSegmentLoadStats.loads);
+    print_debug_top_down_normal("load hit %d", gSegmentLoadStats.hits);
+#endif
 }
 
 /*
@@ -0,0 +1,84 @@
+#include <PR/ultratypes.h>
+
+#include "decompress.h"
+
+/**
+ * C MIO0 decoder, used instead of the assembly one in builds with MIO0_CACHE.
+ *
+ * An MIO0 block is a 16 byte header ("MIO0", decompressed size, offset of
+ * the back references, offset of the raw bytes) followed by the layout
+ * bits. A set bit copies the next raw byte, a clear bit copies 3 to 18 bytes
+ * from up to 4096 bytes back. The layout is consumed a byte at a time, and
+ * sLayoutRawRun gives how many raw bytes come first, so runs of raw bytes
+ * are copied without testing every bit.
+ */
+
+static const u8 sLayoutRawRun[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 7, 8,
+};
+
+static u32 read_u32_be(const u8 *p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+void mio0_decompress(void *mio0, void *dest) {
+    const u8 *header = mio0;
+    const u8 *layout = header + 16;
+    const u8 *refs = header + read_u32_be(header + 8);
+    const u8 *raw = header + read_u32_be(header + 12);
+    u8 *out = dest;
+    u8 *end = out + read_u32_be(header + 4);
+    const u8 *copy;
+    u32 bits;
+    u32 bitsLeft;
+    u32 run;
+    u32 ref;
+
+    while (out < end) {
+        bits = *layout++;
+        bitsLeft = 8;
+
+        while (bitsLeft != 0 && out < end) {
+            run = sLayoutRawRun[bits];
+            if (run > bitsLeft) {
+                run = bitsLeft;
+            }
+            if (run > (u32) (end - out)) {
+                run = end - out;
+            }
+            bitsLeft -= run;
+            bits = (bits << run) & 0xFF;
+            while (run-- != 0) {
+                *out++ = *raw++;
+            }
+
+            if (bitsLeft != 0 && out < end) {
+                ref = (refs[0] << 8) | refs[1];
+                refs += 2;
+                copy = out - (ref & 0xFFF) - 1;
+                run = (ref >> 12) + 3;
+                // The source may overlap what's being written, so copy bytewise
+                while (run-- != 0) {
+                    *out++ = *copy++;
+                }
+                bitsLeft--;
+                bits = (bits << 1) & 0xFF;
+            }
+        }
+    }
+}
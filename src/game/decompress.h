@@ -2,5 +2,6 @@
 #define DECOMPRESS_H
 
 void decompress(void *mio0, void *dest);
+void mio0_decompress(void *mio0, void *dest);
 
 #endif // DECOMPRESS_H
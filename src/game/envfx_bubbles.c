@@ -501,6 +501,10 @@ void envfx_set_bubble_texture(s32 mode, s16 index) {
  */
 Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
     s32 i;
+#ifdef ENVFX_BATCH
+    s32 j;
+    Vtx *verts;
+#endif
     s16 radius, pitch, yaw;
 
     Vec3s vertex1;
@@ -523,6 +527,26 @@ Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFro
 
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D38);
 
+#ifdef ENVFX_BATCH
+    verts = envfx_make_particle_vertices(sBubbleParticleMaxCount, vertex1, vertex2, vertex3,
+                                         (Vtx *) gBubbleTempVtx);
+    if (verts != NULL) {
+        // Each group of 5 particles takes the texture of its first particle. Draw runs of groups
+        // that end up with the same texture together.
+        for (i = 0; i < sBubbleParticleMaxCount; i = j) {
+            for (j = i + 5; j < sBubbleParticleMaxCount; j += 5) {
+                if (mode != ENVFX_WHIRLPOOL_BUBBLES && mode != ENVFX_JETSTREAM_BUBBLES
+                    && (gEnvFxBuffer + j)->animFrame != (gEnvFxBuffer + i)->animFrame) {
+                    break;
+                }
+            }
+            gDPPipeSync(sGfxCursor++);
+            envfx_set_bubble_texture(mode, i);
+            sGfxCursor = envfx_draw_particle_vertices(sGfxCursor, verts + i * 3,
+                                                      MIN(j, sBubbleParticleMaxCount) - i);
+        }
+    }
+#else
     for (i = 0; i < sBubbleParticleMaxCount; i += 5) {
         gDPPipeSync(sGfxCursor++);
         envfx_set_bubble_texture(mode, i);
@@ -533,6 +557,7 @@ Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFro
         gSP1Triangle(sGfxCursor++, 9, 10, 11, 0);
         gSP1Triangle(sGfxCursor++, 12, 13, 14, 0);
     }
+#endif
 
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006AB0);
     gSPEndDisplayList(sGfxCursor++);
@@ -50,6 +50,31 @@ struct SnowFlakeVertex gSnowFlakeVertex1 = { -5, 5, 0 };
 struct SnowFlakeVertex gSnowFlakeVertex2 = { -5, -5, 0 };
 struct SnowFlakeVertex gSnowFlakeVertex3 = { 5, 5, 0 };
 
+#ifdef ENVFX_BATCH
+// Particles per vertex load: the F3DEX microcodes cache 32 vertices, Fast3D only 16
+#ifdef F3DEX_GBI
+#define ENVFX_BATCH_PARTICLES 10
+#else
+#define ENVFX_BATCH_PARTICLES 5
+#endif
+#endif
+
+#ifdef ENVFX_BENCHMARK
+#include <stdio.h>
+
+/**
+ * Time spent updating and building the display list of environment effects,
+ * printed every ENVFX_BENCHMARK_FRAMES frames.
+ */
+#define ENVFX_BENCHMARK_FRAMES 300
+
+static struct {
+    OSTime time;
+    u32 particles;
+    u32 frames;
+} sEnvFxBenchmark;
+#endif
+
 extern void *tiny_bubble_dl_0B006AB0;
 extern void *tiny_bubble_dl_0B006A50;
 extern void *tiny_bubble_dl_0B006CD8;
@@ -382,12 +407,78 @@ void append_snowflake_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s ve
     gSPVertex(gfx, VIRTUAL_TO_PHYSICAL(vertBuf), 15, 0);
 }
 
+#ifdef ENVFX_BATCH
+/**
+ * Build the triangles of the first `count` particles in gEnvFxBuffer into one
+ * vertex buffer: the rotated triangle (vertex1, vertex2, vertex3) moved to each
+ * particle's position, with the texture coordinates and colors of `template`.
+ */
+Vtx *envfx_make_particle_vertices(s32 count, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3, Vtx *template) {
+    Vtx *vertBuf = alloc_display_list(count * 3 * sizeof(Vtx));
+    struct EnvFxParticle *particle = gEnvFxBuffer;
+    Vtx *v = vertBuf;
+    s32 i;
+
+    if (vertBuf == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++, particle++, v += 3) {
+        v[0] = template[0];
+        v[0].v.ob[0] = particle->xPos + vertex1[0];
+        v[0].v.ob[1] = particle->yPos + vertex1[1];
+        v[0].v.ob[2] = particle->zPos + vertex1[2];
+
+        v[1] = template[1];
+        v[1].v.ob[0] = particle->xPos + vertex2[0];
+        v[1].v.ob[1] = particle->yPos + vertex2[1];
+        v[1].v.ob[2] = particle->zPos + vertex2[2];
+
+        v[2] = template[2];
+        v[2].v.ob[0] = particle->xPos + vertex3[0];
+        v[2].v.ob[1] = particle->yPos + vertex3[1];
+        v[2].v.ob[2] = particle->zPos + vertex3[2];
+    }
+
+    return vertBuf;
+}
+
+/**
+ * Append commands drawing `count` particle triangles from `verts`, loading as
+ * many as fit in the vertex cache at once. Needs no more commands than the
+ * 5 particles per load the unbatched path uses.
+ */
+Gfx *envfx_draw_particle_vertices(Gfx *gfx, Vtx *verts, s32 count) {
+    s32 batch;
+    s32 i;
+
+    while (count > 0) {
+        batch = MIN(count, ENVFX_BATCH_PARTICLES);
+        gSPVertex(gfx++, VIRTUAL_TO_PHYSICAL(verts), batch * 3, 0);
+        for (i = 0; i + 1 < batch; i += 2) {
+            gSP2Triangles(gfx++, i * 3, i * 3 + 1, i * 3 + 2, 0, i * 3 + 3, i * 3 + 4, i * 3 + 5, 0);
+        }
+        if (i < batch) {
+            gSP1Triangle(gfx++, i * 3, i * 3 + 1, i * 3 + 2, 0);
+        }
+        verts += batch * 3;
+        count -= batch;
+    }
+
+    return gfx;
+}
+#endif
+
 /**
  * Updates positions of snow particles and returns a pointer to a display list
  * drawing all snowflakes.
  */
 Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
+#ifdef ENVFX_BATCH
+    Vtx *verts;
+#else
     s32 i;
+#endif
     s16 radius, pitch, yaw;
     Vec3s snowCylinderPos;
     struct SnowFlakeVertex vertex1, vertex2, vertex3;
@@ -454,6 +545,13 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
         gSPDisplayList(gfx++, &tiny_bubble_dl_0B006CD8); // snowflake with blue edge
     }
 
+#ifdef ENVFX_BATCH
+    verts = envfx_make_particle_vertices(gSnowParticleCount, (s16 *) &vertex1, (s16 *) &vertex2,
+                                         (s16 *) &vertex3, gSnowTempVtx);
+    if (verts != NULL) {
+        gfx = envfx_draw_particle_vertices(gfx, verts, gSnowParticleCount);
+    }
+#else
     for (i = 0; i < gSnowParticleCount; i += 5) {
         append_snowflake_vertex_buffer(gfx++, i, (s16 *) &vertex1, (s16 *) &vertex2, (s16 *) &vertex3);
 
@@ -463,6 +561,7 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
         gSP1Triangle(gfx++, 9, 10, 11, 0);
         gSP1Triangle(gfx++, 12, 13, 14, 0);
     }
+#endif
 
     gSPDisplayList(gfx++, &tiny_bubble_dl_0B006AB0) gSPEndDisplayList(gfx++);
 
@@ -473,7 +572,31 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
  * Updates the environment effects (snow, flowers, bubbles)
  * and returns a display list drawing them.
  */
+#ifdef ENVFX_BENCHMARK
+static Gfx *envfx_update_particles_inner(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom);
+
+Gfx *envfx_update_particles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom) {
+    OSTime start = osGetTime();
+    Gfx *gfx = envfx_update_particles_inner(mode, marioPos, camTo, camFrom);
+
+    sEnvFxBenchmark.time += osGetTime() - start;
+    if (gfx != NULL && mode > ENVFX_MODE_NONE && mode < ENVFX_BUBBLE_START) {
+        sEnvFxBenchmark.particles += gSnowParticleCount;
+    }
+
+    if (++sEnvFxBenchmark.frames == ENVFX_BENCHMARK_FRAMES) {
+        // osGetTime ticks in microseconds
+        printf("ENVFX: %u snowflakes in %u us of particle updates\n",
+               (unsigned) sEnvFxBenchmark.particles, (unsigned) sEnvFxBenchmark.time);
+        bzero(&sEnvFxBenchmark, sizeof(sEnvFxBenchmark));
+    }
+    return gfx;
+}
+
+static Gfx *envfx_update_particles_inner(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom) {
+#else
 Gfx *envfx_update_particles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom) {
+#endif
     Gfx *gfx;
 
     if (get_dialog_id() != -1) {
@@ -18,6 +18,7 @@
 #include "print.h"
 #include "segment2.h"
 #include "segment_symbols.h"
+#include "snapshot.h"
 #include "thread6.h"
 #include <prevent_bss_reordering.h>
 
@@ -655,6 +656,9 @@ void setup_game_memory(void) {
     func_80278A78(&gDemo, gDemoInputs, D_80339CF4);
     load_segment(0x10, _entrySegmentRomStart, _entrySegmentRomEnd, MEMORY_POOL_LEFT);
     load_segment_decompress(2, _segment2_mio0SegmentRomStart, _segment2_mio0SegmentRomEnd);
+#ifdef MIO0_CACHE
+    mio0_cache_init();
+#endif
 }
 
 #ifndef TARGET_N64
@@ -734,3 +738,9 @@ void game_loop_one_iteration(void) {
     }
 #endif
 }
+
+#ifdef SNAPSHOTS
+void game_init_snapshot_regions(void) {
+    SNAPSHOT_REGION(levelCommandAddr);
+}
+#endif
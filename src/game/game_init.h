@@ -74,5 +74,8 @@ void end_master_display_list(void);
 void rendering_init(void);
 void config_gfx_pool(void);
 void display_and_vsync(void);
+#ifdef SNAPSHOTS
+void game_init_snapshot_regions(void);
+#endif
 
 #endif // GAME_INIT_H
@@ -20,6 +20,7 @@
 #include "segment7.h"
 #include "seq_ids.h"
 #include "sm64.h"
+#include "snapshot.h"
 #include "text_strings.h"
 #include "types.h"
 
@@ -3075,3 +3076,39 @@ s16 render_menus_and_dialogs() {
     }
     return mode;
 }
+
+#ifdef SNAPSHOTS
+void ingame_menu_snapshot_regions(void) {
+    SNAPSHOT_REGION(gDialogColorFadeTimer);
+    SNAPSHOT_REGION(gLastDialogLineNum);
+    SNAPSHOT_REGION(gDialogVariable);
+    SNAPSHOT_REGION(gDialogTextAlpha);
+    SNAPSHOT_REGION(gCutsceneMsgXOffset);
+    SNAPSHOT_REGION(gCutsceneMsgYOffset);
+    SNAPSHOT_REGION(gRedCoinsCollected);
+    SNAPSHOT_REGION(gDialogBoxState);
+    SNAPSHOT_REGION(gDialogBoxOpenTimer);
+    SNAPSHOT_REGION(gDialogBoxScale);
+    SNAPSHOT_REGION(gDialogScrollOffsetY);
+    SNAPSHOT_REGION(gDialogBoxType);
+    SNAPSHOT_REGION(gDialogID);
+    SNAPSHOT_REGION(gLastDialogPageStrPos);
+    SNAPSHOT_REGION(gDialogTextPos);
+    SNAPSHOT_REGION(gDialogLineNum);
+    SNAPSHOT_REGION(gLastDialogResponse);
+    SNAPSHOT_REGION(gMenuHoldKeyIndex);
+    SNAPSHOT_REGION(gMenuHoldKeyTimer);
+    SNAPSHOT_REGION(gDialogResponse);
+    SNAPSHOT_REGION(gMenuMode);
+    SNAPSHOT_REGION(gCutsceneMsgFade);
+    SNAPSHOT_REGION(gCutsceneMsgIndex);
+    SNAPSHOT_REGION(gCutsceneMsgDuration);
+    SNAPSHOT_REGION(gCutsceneMsgTimer);
+    SNAPSHOT_REGION(gDialogCameraAngleIndex);
+    SNAPSHOT_REGION(gDialogCourseActNum);
+    SNAPSHOT_REGION(gCourseCompleteCoinsEqual);
+    SNAPSHOT_REGION(gCourseDoneMenuTimer);
+    SNAPSHOT_REGION(gCourseCompleteCoins);
+    SNAPSHOT_REGION(gHudFlash);
+}
+#endif
@@ -148,5 +148,8 @@ void do_cutscene_handler(void);
 void render_hud_cannon_reticle(void);
 void reset_red_coins_collected(void);
 s16 render_menus_and_dialogs(void);
+#ifdef SNAPSHOTS
+void ingame_menu_snapshot_regions(void);
+#endif
 
 #endif // INGAME_MENU_H
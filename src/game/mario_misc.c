@@ -24,6 +24,22 @@
 #include "skybox.h"
 #include "sound_init.h"
 
+#ifdef GD_BENCHMARK
+#include <stdio.h>
+
+/**
+ * Time spent building the title screen Mario head and converting its vertices
+ * in gd_vblank, printed every GD_BENCHMARK_FRAMES frames.
+ */
+#define GD_BENCHMARK_FRAMES 300
+
+static struct {
+    OSTime sceneTime;
+    OSTime vblankTime;
+    u32 frames;
+} sGdBenchmark;
+#endif
+
 #define TOAD_STAR_1_REQUIREMENT 12
 #define TOAD_STAR_2_REQUIREMENT 25
 #define TOAD_STAR_3_REQUIREMENT 35
@@ -78,6 +94,24 @@ struct GraphNodeObject gMirrorMario;  // copy of Mario's geo node for drawing mi
 // (message NPC related things, the Mario head geo, and Mario geo
 // functions)
 
+#ifdef GD_BENCHMARK
+static void gd_vblank_benchmark(void) {
+    OSTime start = osGetTime();
+
+    gd_vblank();
+    sGdBenchmark.vblankTime += osGetTime() - start;
+
+    if (++sGdBenchmark.frames == GD_BENCHMARK_FRAMES) {
+        // osGetTime ticks in microseconds
+        printf("GODDARD: %u us per frame (%u us building the scene, %u us in gd_vblank)\n",
+               (unsigned) ((sGdBenchmark.sceneTime + sGdBenchmark.vblankTime) / GD_BENCHMARK_FRAMES),
+               (unsigned) (sGdBenchmark.sceneTime / GD_BENCHMARK_FRAMES),
+               (unsigned) (sGdBenchmark.vblankTime / GD_BENCHMARK_FRAMES));
+        bzero(&sGdBenchmark, sizeof(sGdBenchmark));
+    }
+}
+#endif
+
 /**
  * Geo node script that draws Mario's head on the title screen.
  */
@@ -86,13 +120,23 @@ Gfx *geo_draw_mario_head_goddard(s32 callContext, struct GraphNode *node, Mat4 *
     s16 sfx = 0;
     struct GraphNodeGenerated *asGenerated = (struct GraphNodeGenerated *) node;
     UNUSED Mat4 *transform = c;
+#ifdef GD_BENCHMARK
+    OSTime start;
+#endif
 
     if (callContext == GEO_CONTEXT_RENDER) {
         if (gPlayer1Controller->controllerData != NULL && gWarpTransition.isActive == 0) {
             gd_copy_p1_contpad(gPlayer1Controller->controllerData);
         }
+#ifdef GD_BENCHMARK
+        start = osGetTime();
+        gfx = (Gfx *) PHYSICAL_TO_VIRTUAL(gdm_gettestdl(asGenerated->parameter));
+        sGdBenchmark.sceneTime += osGetTime() - start;
+        D_8032C6A0 = gd_vblank_benchmark;
+#else
         gfx = (Gfx *) PHYSICAL_TO_VIRTUAL(gdm_gettestdl(asGenerated->parameter));
         D_8032C6A0 = gd_vblank;
+#endif
         sfx = gd_sfx_to_play();
         play_menu_sounds(sfx);
     }
@@ -12,8 +12,10 @@
 #include "game_init.h"
 #include "main.h"
 #include "memory.h"
+#include "rendering_graph_node.h"
 #include "segment_symbols.h"
 #include "segments.h"
+#include "snapshot.h"
 
 // round up to the next multiple
 #define ALIGN4(val) (((val) + 0x3) & ~0x3)
@@ -280,6 +282,117 @@ static void *dynamic_dma_read(u8 *srcStart, u8 *srcEnd, u32 side) {
 }
 
 #ifndef NO_SEGMENTED_MEMORY
+#ifdef MIO0_CACHE
+// Needs the expansion pak, or a smaller size
+#ifndef MIO0_CACHE_SIZE
+#define MIO0_CACHE_SIZE 0x80000
+#endif
+#define MIO0_CACHE_ENTRIES 32
+
+/**
+ * Decompressed MIO0 segments, keyed by their ROM range. Loading a level
+ * again (after a death or a warp back to the castle) then copies them
+ * instead of reading and decompressing them. The least recently used
+ * segments are dropped when the pool is full.
+ */
+struct Mio0CacheEntry {
+    u8 *srcStart;
+    u8 *srcEnd;
+    void *data;
+    u32 size;
+    u32 lastUse;
+};
+
+static struct MemoryPool *sMio0CachePool = NULL;
+static struct Mio0CacheEntry sMio0Cache[MIO0_CACHE_ENTRIES];
+static u32 sMio0CacheUses = 0;
+
+struct SegmentLoadStats gSegmentLoadStats;
+
+/**
+ * Allocate the cache. It has to outlive the levels, so this must be called
+ * before the first main_pool_push_state.
+ */
+void mio0_cache_init(void) {
+    sMio0CachePool = mem_pool_init(MIO0_CACHE_SIZE, MEMORY_POOL_LEFT);
+}
+
+static struct Mio0CacheEntry *mio0_cache_find(u8 *srcStart, u8 *srcEnd) {
+    s32 i;
+
+    for (i = 0; i < MIO0_CACHE_ENTRIES; i++) {
+        if (sMio0Cache[i].data != NULL && sMio0Cache[i].srcStart == srcStart
+            && sMio0Cache[i].srcEnd == srcEnd) {
+            sMio0Cache[i].lastUse = ++sMio0CacheUses;
+            return &sMio0Cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Drop the least recently used segment. Return its entry, or NULL if the
+ * cache is empty.
+ */
+static struct Mio0CacheEntry *mio0_cache_evict(void) {
+    struct Mio0CacheEntry *oldest = NULL;
+    s32 i;
+
+    for (i = 0; i < MIO0_CACHE_ENTRIES; i++) {
+        if (sMio0Cache[i].data != NULL
+            && (oldest == NULL || sMio0Cache[i].lastUse < oldest->lastUse)) {
+            oldest = &sMio0Cache[i];
+        }
+    }
+    if (oldest != NULL) {
+        mem_pool_free(sMio0CachePool, oldest->data);
+        oldest->data = NULL;
+    }
+    return oldest;
+}
+
+static void mio0_cache_store(u8 *srcStart, u8 *srcEnd, void *data, u32 size) {
+    struct Mio0CacheEntry *entry = NULL;
+    void *copy;
+    s32 i;
+
+    if (sMio0CachePool == NULL || size >= MIO0_CACHE_SIZE) {
+        return;
+    }
+
+    while ((copy = mem_pool_alloc(sMio0CachePool, size)) == NULL) {
+        if (mio0_cache_evict() == NULL) {
+            return;
+        }
+    }
+
+    for (i = 0; i < MIO0_CACHE_ENTRIES; i++) {
+        if (sMio0Cache[i].data == NULL) {
+            entry = &sMio0Cache[i];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        entry = mio0_cache_evict();
+    }
+
+    bcopy(data, copy, size);
+    entry->srcStart = srcStart;
+    entry->srcEnd = srcEnd;
+    entry->data = copy;
+    entry->size = size;
+    entry->lastUse = ++sMio0CacheUses;
+}
+
+static void mio0_cache_count_load(s32 hit, OSTime startTime) {
+    gSegmentLoadStats.loads++;
+    if (hit) {
+        gSegmentLoadStats.hits++;
+    }
+    gSegmentLoadStats.time += osGetTime() - startTime;
+}
+#endif
+
 /**
  * Load data from ROM into a newly allocated block, and set the segment base
  * address to this block.
@@ -327,38 +440,87 @@ void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd) {
     void *dest = NULL;
 
     u32 compSize = ALIGN16(srcEnd - srcStart);
+#ifdef MIO0_CACHE
+    OSTime startTime = osGetTime();
+    struct Mio0CacheEntry *entry = mio0_cache_find(srcStart, srcEnd);
+    u8 *compressed = entry != NULL ? NULL : main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
+#else
     u8 *compressed = main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
+#endif
 
     // Decompressed size from mio0 header
     u32 *size = (u32 *) (compressed + 4);
 
+#ifdef MIO0_CACHE
+    if (entry != NULL) {
+        dest = main_pool_alloc(entry->size, MEMORY_POOL_LEFT);
+        if (dest != NULL) {
+            bcopy(entry->data, dest, entry->size);
+            set_segment_base_addr(segment, dest);
+        }
+        mio0_cache_count_load(TRUE, startTime);
+        return dest;
+    }
+#endif
+
     if (compressed != NULL) {
         dma_read(compressed, srcStart, srcEnd);
         dest = main_pool_alloc(*size, MEMORY_POOL_LEFT);
         if (dest != NULL) {
+#ifdef MIO0_CACHE
+            mio0_decompress(compressed, dest);
+            mio0_cache_store(srcStart, srcEnd, dest, *size);
+#else
             decompress(compressed, dest);
+#endif
             set_segment_base_addr(segment, dest);
             main_pool_free(compressed);
         } else {
         }
     } else {
     }
+#ifdef MIO0_CACHE
+    mio0_cache_count_load(FALSE, startTime);
+#endif
     return dest;
 }
 
 void *load_segment_decompress_heap(u32 segment, u8 *srcStart, u8 *srcEnd) {
     UNUSED void *dest = NULL;
     u32 compSize = ALIGN16(srcEnd - srcStart);
+#ifdef MIO0_CACHE
+    OSTime startTime = osGetTime();
+    struct Mio0CacheEntry *entry = mio0_cache_find(srcStart, srcEnd);
+    u8 *compressed = entry != NULL ? NULL : main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
+#else
     u8 *compressed = main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
+#endif
     UNUSED u32 *pUncSize = (u32 *) (compressed + 4);
 
+#ifdef MIO0_CACHE
+    if (entry != NULL) {
+        bcopy(entry->data, gDecompressionHeap, entry->size);
+        set_segment_base_addr(segment, gDecompressionHeap);
+        mio0_cache_count_load(TRUE, startTime);
+        return gDecompressionHeap;
+    }
+#endif
+
     if (compressed != NULL) {
         dma_read(compressed, srcStart, srcEnd);
+#ifdef MIO0_CACHE
+        mio0_decompress(compressed, gDecompressionHeap);
+        mio0_cache_store(srcStart, srcEnd, gDecompressionHeap, *pUncSize);
+#else
         decompress(compressed, gDecompressionHeap);
+#endif
         set_segment_base_addr(segment, gDecompressionHeap);
         main_pool_free(compressed);
     } else {
     }
+#ifdef MIO0_CACHE
+    mio0_cache_count_load(FALSE, startTime);
+#endif
     return gDecompressionHeap;
 }
 
@@ -570,8 +732,28 @@ s32 load_patchable_table(struct MarioAnimation *a, u32 index) {
         if (a->currentAnimAddr != addr) {
             dma_read((u8 *) a->targetAnim, addr, addr + size);
             a->currentAnimAddr = addr;
+#ifdef ANIM_POSE_CACHE
+            geo_invalidate_anim_poses();
+#endif
             ret = TRUE;
         }
     }
     return ret;
 }
+
+#ifdef SNAPSHOTS
+/**
+ * Register the whole main pool for snapshots, including the free space in
+ * the middle. That space doesn't change while it's free, so it costs nothing
+ * after the first keyframe.
+ */
+void main_pool_snapshot_regions(void) {
+    snapshot_add_region(sPoolStart - 16, sPoolEnd - sPoolStart + 32);
+    SNAPSHOT_REGION(sPoolFreeSpace);
+    SNAPSHOT_REGION(sPoolListHeadL);
+    SNAPSHOT_REGION(sPoolListHeadR);
+    SNAPSHOT_REGION(gMainPoolState);
+    SNAPSHOT_REGION(gEffectsMemoryPool);
+    SNAPSHOT_REGION(sSegmentTable);
+}
+#endif
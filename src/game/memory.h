@@ -2,6 +2,9 @@
 #define MEMORY_H
 
 #include <PR/ultratypes.h>
+#ifdef MIO0_CACHE
+#include <PR/os_time.h>
+#endif
 
 #include "types.h"
 
@@ -41,6 +44,18 @@ u32 main_pool_push_state(void);
 u32 main_pool_pop_state(void);
 
 #ifndef NO_SEGMENTED_MEMORY
+#ifdef MIO0_CACHE
+struct SegmentLoadStats {
+    u32 loads;
+    u32 hits;
+    OSTime time;
+};
+
+// MIO0 segment loads since the current level started loading
+extern struct SegmentLoadStats gSegmentLoadStats;
+
+void mio0_cache_init(void);
+#endif
 void *load_segment(s32 segment, u8 *srcStart, u8 *srcEnd, u32 side);
 void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd);
 void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd);
@@ -65,5 +80,8 @@ void mem_pool_free(struct MemoryPool *pool, void *addr);
 void *alloc_display_list(u32 size);
 void func_80278A78(struct MarioAnimation *a, void *b, struct Animation *target);
 s32 load_patchable_table(struct MarioAnimation *a, u32 b);
+#ifdef SNAPSHOTS
+void main_pool_snapshot_regions(void);
+#endif
 
 #endif // MEMORY_H
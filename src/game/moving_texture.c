@@ -14,6 +14,11 @@
 #include "rendering_graph_node.h"
 #include "object_list_processor.h"
 
+#ifdef MOVTEX_RETAINED
+#include "buffers/buffers.h"
+#include "game_init.h"
+#endif
+
 /**
  * This file contains functions for generating display lists with moving textures
  * (abbreviated movtex). This is used for water, sand, haze, mist and treadmills.
@@ -394,6 +399,82 @@ struct MovtexQuad {
 /// Variable for a little optimization: only set the texture when it differs from the previous texture
 s16 gMovetexLastTextureId;
 
+#ifdef MOVTEX_RETAINED
+/**
+ * Vertices of the quads drawn last, kept so that a quad's positions and
+ * colors are only written again when its water level changes, and its texture
+ * coordinates only when the texture has rotated. There is one copy per
+ * graphics pool, so the vertices the RSP may still be reading are left alone.
+ */
+#define MOVTEX_QUAD_RETAINED_COUNT 64
+
+struct MovtexQuadRetained {
+    struct MovtexQuad *quad;
+    /// gGlobalTimer when the vertices were last drawn
+    u32 frame;
+    s16 y;
+    s16 rot;
+    s8 vtxColor;
+    /// copy of the quad's shape, in case other level data is loaded in its place
+    s16 scale;
+    s16 x1, z1, x2, z2, x3, z3, x4, z4;
+    s16 rotDir;
+    s16 alpha;
+    Vtx verts[4];
+};
+
+static struct MovtexQuadRetained sMovtexQuadRetained[GFX_NUM_POOLS][MOVTEX_QUAD_RETAINED_COUNT];
+
+/**
+ * Return the retained vertices for a quad, or NULL if its slot already holds
+ * other vertices drawn this frame.
+ */
+static struct MovtexQuadRetained *movtex_get_retained_quad(struct MovtexQuad *quad) {
+    s32 slot = ((uintptr_t) quad / sizeof(struct MovtexQuad)) % MOVTEX_QUAD_RETAINED_COUNT;
+    struct MovtexQuadRetained *retained = &sMovtexQuadRetained[gGfxPool - gGfxPools][slot];
+
+    if (retained->frame == gGlobalTimer && retained->quad != quad) {
+        return NULL;
+    }
+    if (retained->quad != quad || retained->scale != quad->scale || retained->x1 != quad->x1
+        || retained->z1 != quad->z1 || retained->x2 != quad->x2 || retained->z2 != quad->z2
+        || retained->x3 != quad->x3 || retained->z3 != quad->z3 || retained->x4 != quad->x4
+        || retained->z4 != quad->z4 || retained->rotDir != quad->rotDir
+        || retained->alpha != quad->alpha) {
+        retained->quad = quad;
+        retained->frame = gGlobalTimer - 1;
+        retained->vtxColor = -1;
+        retained->scale = quad->scale;
+        retained->x1 = quad->x1;
+        retained->z1 = quad->z1;
+        retained->x2 = quad->x2;
+        retained->z2 = quad->z2;
+        retained->x3 = quad->x3;
+        retained->z3 = quad->z3;
+        retained->x4 = quad->x4;
+        retained->z4 = quad->z4;
+        retained->rotDir = quad->rotDir;
+        retained->alpha = quad->alpha;
+    }
+    return retained;
+}
+
+/**
+ * Rewrite the texture coordinates of a quad's vertices, as made by
+ * movtex_make_quad_vertex, for a new rotation.
+ */
+static void movtex_rotate_quad_texture(Vtx *verts, s16 rot, s16 rotDir, f32 scale) {
+    // Each vertex is a quarter turn further, like in movtex_gen_from_quad.
+    s16 rotStep = rotDir == ROTATE_CLOCKWISE ? 16384 : -16384;
+    s32 i;
+
+    for (i = 0; i < 4; i++) {
+        verts[i].v.tc[0] = (s16)(32.0 * (32.0 * scale - 1.0) * sins(rot + rotStep * i));
+        verts[i].v.tc[1] = (s16)(32.0 * (32.0 * scale - 1.0) * coss(rot + rotStep * i));
+    }
+}
+#endif
+
 /**
  * Generates and returns a display list for a single MovtexQuad at height y.
  */
@@ -412,7 +493,12 @@ Gfx *movtex_gen_from_quad(s16 y, struct MovtexQuad *quad) {
     s16 rotDir = quad->rotDir;
     s16 alpha = quad->alpha;
     s16 textureId = quad->textureId;
+#ifdef MOVTEX_RETAINED
+    struct MovtexQuadRetained *retained = movtex_get_retained_quad(quad);
+    Vtx *verts = retained != NULL ? retained->verts : alloc_display_list(4 * sizeof(*verts));
+#else
     Vtx *verts = alloc_display_list(4 * sizeof(*verts));
+#endif
     Gfx *gfxHead;
     Gfx *gfx;
 
@@ -430,6 +516,22 @@ Gfx *movtex_gen_from_quad(s16 y, struct MovtexQuad *quad) {
         quad->rot += rotspeed;
     }
     rot = quad->rot;
+#ifdef MOVTEX_RETAINED
+    if (retained != NULL && retained->frame == gGlobalTimer
+        && (retained->y != y || retained->rot != rot || retained->vtxColor != gMovtexVtxColor)) {
+        // Already drawn differently this frame, those vertices are still in use.
+        retained = NULL;
+        verts = alloc_display_list(4 * sizeof(*verts));
+        if (verts == NULL) {
+            return NULL;
+        }
+    }
+    if (retained != NULL && retained->y == y && retained->vtxColor == gMovtexVtxColor) {
+        if (retained->rot != rot) {
+            movtex_rotate_quad_texture(verts, rot, rotDir, scale);
+        }
+    } else
+#endif
     if (rotDir == ROTATE_CLOCKWISE) {
         movtex_make_quad_vertex(verts, 0, x1, y, z1, rot, 0, scale, alpha);
         movtex_make_quad_vertex(verts, 1, x2, y, z2, rot, 16384, scale, alpha);
@@ -441,6 +543,14 @@ Gfx *movtex_gen_from_quad(s16 y, struct MovtexQuad *quad) {
         movtex_make_quad_vertex(verts, 2, x3, y, z3, rot, -32768, scale, alpha);
         movtex_make_quad_vertex(verts, 3, x4, y, z4, rot, 16384, scale, alpha);
     }
+#ifdef MOVTEX_RETAINED
+    if (retained != NULL) {
+        retained->frame = gGlobalTimer;
+        retained->y = y;
+        retained->rot = rot;
+        retained->vtxColor = gMovtexVtxColor;
+    }
+#endif
 
     // Only add commands to change the texture when necessary
     if (textureId != gMovetexLastTextureId) {
@@ -799,13 +909,142 @@ void movtex_write_vertex_index(Vtx *verts, s32 index, s16 *movtexVerts, struct M
     }
 }
 
+/// Room for the display list movtex_gen_list makes for a MovtexObject
+#define MOVTEX_LIST_GFX_COUNT 11
+/// Commands movtex_gen_list writes: the begin list, the 5 of gLoadBlockTexture, the vertices, the
+/// tri and end lists and gSPEndDisplayList. Keep it in sync when changing the commands.
+#define MOVTEX_LIST_GFX_USED (1 + 5 + 1 + 2 + 1)
+STATIC_ASSERT(MOVTEX_LIST_GFX_USED <= MOVTEX_LIST_GFX_COUNT, "movtex display list buffer too small");
+
+#ifdef MOVTEX_RETAINED
+/**
+ * Vertices and display list of every MovtexObject, kept from frame to frame.
+ * Only the mesh's texture offset changes, so only the texture coordinates are
+ * rewritten when it moved, and nothing at all when it didn't, e.g. while
+ * paused or for the extra instances of a treadmill. There is one copy per
+ * graphics pool, so the one the RSP may still be reading is left alone.
+ */
+#define MOVTEX_RETAINED_MAX_VERTS 16
+#define MOVTEX_ATTR_S(attrLayout)                                                                  \
+    ((attrLayout) == MOVTEX_LAYOUT_NOCOLOR ? MOVTEX_ATTR_NOCOLOR_S : MOVTEX_ATTR_COLORED_S)
+#define MOVTEX_RETAINED_COUNT                                                                      \
+    (ARRAY_COUNT(gMovtexNonColored) + ARRAY_COUNT(gMovtexColored) + ARRAY_COUNT(gMovtexColored2))
+
+struct MovtexRetained {
+    /// mesh the vertices were made from, NULL if not made yet
+    s16 *movtexVerts;
+    /// gGlobalTimer when the vertices were last drawn
+    u32 frame;
+    /// texture offset of the first vertex when they were made
+    s16 baseS;
+    s16 baseT;
+    Vtx verts[MOVTEX_RETAINED_MAX_VERTS];
+    Gfx gfx[MOVTEX_LIST_GFX_COUNT];
+};
+
+static struct MovtexRetained sMovtexRetained[GFX_NUM_POOLS][MOVTEX_RETAINED_COUNT];
+
+/**
+ * Return the retained buffers of a MovtexObject in one of the movtex lists.
+ */
+static struct MovtexRetained *movtex_get_retained(struct MovtexObject *movtexList) {
+    s32 slot = 0;
+
+    if (movtexList >= gMovtexNonColored
+        && movtexList < gMovtexNonColored + ARRAY_COUNT(gMovtexNonColored)) {
+        return &sMovtexRetained[gGfxPool - gGfxPools][slot + (movtexList - gMovtexNonColored)];
+    }
+    slot += ARRAY_COUNT(gMovtexNonColored);
+
+    if (movtexList >= gMovtexColored && movtexList < gMovtexColored + ARRAY_COUNT(gMovtexColored)) {
+        return &sMovtexRetained[gGfxPool - gGfxPools][slot + (movtexList - gMovtexColored)];
+    }
+    slot += ARRAY_COUNT(gMovtexColored);
+
+    if (movtexList >= gMovtexColored2
+        && movtexList < gMovtexColored2 + ARRAY_COUNT(gMovtexColored2)) {
+        return &sMovtexRetained[gGfxPool - gGfxPools][slot + (movtexList - gMovtexColored2)];
+    }
+    return NULL;
+}
+
+/**
+ * Rewrite the texture coordinates of vertices made by movtex_write_vertex_first
+ * and movtex_write_vertex_index after the mesh's texture offset moved.
+ */
+static void movtex_write_texture_coords(Vtx *verts, s16 *movtexVerts, s32 vtxCount, s8 attrLayout) {
+    s32 stride = attrLayout == MOVTEX_LAYOUT_NOCOLOR ? 5 : 8;
+    s16 *st = movtexVerts + MOVTEX_ATTR_S(attrLayout);
+    s16 baseS = st[0];
+    s16 baseT = st[1];
+    s32 i;
+
+    verts[0].v.tc[0] = baseS;
+    verts[0].v.tc[1] = baseT;
+    for (i = 1; i < vtxCount; i++) {
+        st += stride;
+        verts[i].v.tc[0] = baseS + ((st[0] * 32) * 32U);
+        verts[i].v.tc[1] = baseT + ((st[1] * 32) * 32U);
+    }
+}
+
+static Gfx *movtex_gen_list_alloc(s16 *movtexVerts, struct MovtexObject *movtexList,
+                                  s8 attrLayout);
+
+/**
+ * Generate a displaylist for a MovtexObject.
+ * 'attrLayout' is one of MOVTEX_LAYOUT_NOCOLOR and MOVTEX_LAYOUT_COLORED.
+ */
+Gfx *movtex_gen_list(s16 *movtexVerts, struct MovtexObject *movtexList, s8 attrLayout) {
+    struct MovtexRetained *retained = movtex_get_retained(movtexList);
+    s16 *st = movtexVerts + MOVTEX_ATTR_S(attrLayout);
+    Gfx *gfx;
+    s32 i;
+
+    if (retained == NULL || movtexList->vtx_count > MOVTEX_RETAINED_MAX_VERTS) {
+        return movtex_gen_list_alloc(movtexVerts, movtexList, attrLayout);
+    }
+
+    if (retained->movtexVerts != movtexVerts) {
+        movtex_write_vertex_first(retained->verts, movtexVerts, movtexList, attrLayout);
+        for (i = 1; i < movtexList->vtx_count; i++) {
+            movtex_write_vertex_index(retained->verts, i, movtexVerts, movtexList, attrLayout);
+        }
+
+        gfx = retained->gfx;
+        gSPDisplayList(gfx++, movtexList->beginDl);
+        gLoadBlockTexture(gfx++, 32, 32, G_IM_FMT_RGBA, gMovtexIdToTexture[movtexList->textureId]);
+        gSPVertex(gfx++, VIRTUAL_TO_PHYSICAL2(retained->verts), movtexList->vtx_count, 0);
+        gSPDisplayList(gfx++, movtexList->triDl);
+        gSPDisplayList(gfx++, movtexList->endDl);
+        gSPEndDisplayList(gfx++);
+        retained->movtexVerts = movtexVerts;
+    } else if (retained->baseS != st[0] || retained->baseT != st[1]) {
+        if (retained->frame == gGlobalTimer) {
+            // Already drawn with another offset this frame, those vertices are still in use.
+            return movtex_gen_list_alloc(movtexVerts, movtexList, attrLayout);
+        }
+        movtex_write_texture_coords(retained->verts, movtexVerts, movtexList->vtx_count,
+                                    attrLayout);
+    }
+
+    retained->frame = gGlobalTimer;
+    retained->baseS = st[0];
+    retained->baseT = st[1];
+    return retained->gfx;
+}
+
+static Gfx *movtex_gen_list_alloc(s16 *movtexVerts, struct MovtexObject *movtexList,
+                                  s8 attrLayout) {
+#else
 /**
  * Generate a displaylist for a MovtexObject.
  * 'attrLayout' is one of MOVTEX_LAYOUT_NOCOLOR and MOVTEX_LAYOUT_COLORED.
  */
 Gfx *movtex_gen_list(s16 *movtexVerts, struct MovtexObject *movtexList, s8 attrLayout) {
+#endif
     Vtx *verts = alloc_display_list(movtexList->vtx_count * sizeof(*verts));
-    Gfx *gfxHead = alloc_display_list(11 * sizeof(*gfxHead));
+    Gfx *gfxHead = alloc_display_list(MOVTEX_LIST_GFX_COUNT * sizeof(*gfxHead));
     Gfx *gfx = gfxHead;
     s32 i;
 
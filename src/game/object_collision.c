@@ -4,9 +4,322 @@
 #include "debug.h"
 #include "interaction.h"
 #include "mario.h"
+#include "object_collision.h"
 #include "object_list_processor.h"
+#include "snapshot.h"
 #include "spawn_object.h"
 
+#ifdef OBJECT_HASH
+/**
+ * Every object in an object list is binned into a grid of 512 unit cells by
+ * its X/Z position, so collision checks only test objects close enough to
+ * touch. Positions wrap around the grid, and objects outside of it go in an
+ * overflow cell that every query visits. Objects are also chained by
+ * behavior for the behavior lookups in object_helpers.c.
+ *
+ * Objects get a number when they spawn. Spawned objects are appended to
+ * their list, so sorting by this number gives the list order and the results
+ * match walking the whole list.
+ */
+#define OBJ_HASH_CELL_SHIFT 9
+#define OBJ_HASH_CELLS 32
+#define OBJ_HASH_OVERFLOW_CELL (OBJ_HASH_CELLS * OBJ_HASH_CELLS)
+#define OBJ_HASH_BEHAVIOR_BUCKETS 64
+#define OBJ_HASH_NONE -1
+
+struct ObjectHashNode {
+    s16 nextInCell;
+    s16 prevInCell;
+    s16 nextInBehavior;
+    s16 prevInBehavior;
+    s16 cell;
+    s16 behaviorBucket;
+    s16 listIndex; // OBJ_HASH_NONE if the object isn't in a list
+    u32 order;
+};
+
+static struct ObjectHashNode sObjectHashNodes[OBJECT_POOL_CAPACITY];
+static s16 sObjectHashCells[OBJ_HASH_OVERFLOW_CELL + 1];
+static s16 sObjectHashBehaviors[OBJ_HASH_BEHAVIOR_BUCKETS];
+static u32 sObjectHashOrder;
+static f32 sObjectHashMaxHitboxRadius;
+static struct Object *sObjectHashCandidates[OBJECT_POOL_CAPACITY];
+
+static s16 obj_hash_cell(struct Object *obj) {
+    f32 x = obj->oPosX + 32768.0f;
+    f32 z = obj->oPosZ + 32768.0f;
+
+    // Also catches NaN
+    if (!(x > 0.0f && x < 65536.0f && z > 0.0f && z < 65536.0f)) {
+        return OBJ_HASH_OVERFLOW_CELL;
+    }
+
+    return (((s32) z >> OBJ_HASH_CELL_SHIFT) & (OBJ_HASH_CELLS - 1)) * OBJ_HASH_CELLS
+           + (((s32) x >> OBJ_HASH_CELL_SHIFT) & (OBJ_HASH_CELLS - 1));
+}
+
+static s16 obj_hash_behavior_bucket(const BehaviorScript *behavior) {
+    uintptr_t addr = (uintptr_t) behavior;
+
+    return ((addr >> 2) ^ (addr >> 8)) & (OBJ_HASH_BEHAVIOR_BUCKETS - 1);
+}
+
+static void obj_hash_link_cell(s16 index) {
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+
+    node->prevInCell = OBJ_HASH_NONE;
+    node->nextInCell = sObjectHashCells[node->cell];
+    if (node->nextInCell != OBJ_HASH_NONE) {
+        sObjectHashNodes[node->nextInCell].prevInCell = index;
+    }
+    sObjectHashCells[node->cell] = index;
+}
+
+static void obj_hash_unlink_cell(s16 index) {
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+
+    if (node->prevInCell != OBJ_HASH_NONE) {
+        sObjectHashNodes[node->prevInCell].nextInCell = node->nextInCell;
+    } else {
+        sObjectHashCells[node->cell] = node->nextInCell;
+    }
+    if (node->nextInCell != OBJ_HASH_NONE) {
+        sObjectHashNodes[node->nextInCell].prevInCell = node->prevInCell;
+    }
+}
+
+/**
+ * Behavior chains are kept in spawn order, so insert after the last object
+ * that spawned earlier.
+ */
+static void obj_hash_link_behavior(s16 index) {
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+    s16 prev = OBJ_HASH_NONE;
+    s16 next = sObjectHashBehaviors[node->behaviorBucket];
+
+    while (next != OBJ_HASH_NONE && sObjectHashNodes[next].order < node->order) {
+        prev = next;
+        next = sObjectHashNodes[next].nextInBehavior;
+    }
+
+    node->prevInBehavior = prev;
+    node->nextInBehavior = next;
+    if (prev != OBJ_HASH_NONE) {
+        sObjectHashNodes[prev].nextInBehavior = index;
+    } else {
+        sObjectHashBehaviors[node->behaviorBucket] = index;
+    }
+    if (next != OBJ_HASH_NONE) {
+        sObjectHashNodes[next].prevInBehavior = index;
+    }
+}
+
+static void obj_hash_unlink_behavior(s16 index) {
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+
+    if (node->prevInBehavior != OBJ_HASH_NONE) {
+        sObjectHashNodes[node->prevInBehavior].nextInBehavior = node->nextInBehavior;
+    } else {
+        sObjectHashBehaviors[node->behaviorBucket] = node->nextInBehavior;
+    }
+    if (node->nextInBehavior != OBJ_HASH_NONE) {
+        sObjectHashNodes[node->nextInBehavior].prevInBehavior = node->prevInBehavior;
+    }
+}
+
+/**
+ * Forget every object, used when the object lists are cleared.
+ */
+void obj_hash_clear(void) {
+    s32 i;
+
+    for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+        sObjectHashNodes[i].listIndex = OBJ_HASH_NONE;
+    }
+    for (i = 0; i < OBJ_HASH_OVERFLOW_CELL + 1; i++) {
+        sObjectHashCells[i] = OBJ_HASH_NONE;
+    }
+    for (i = 0; i < OBJ_HASH_BEHAVIOR_BUCKETS; i++) {
+        sObjectHashBehaviors[i] = OBJ_HASH_NONE;
+    }
+
+    sObjectHashOrder = 0;
+    sObjectHashMaxHitboxRadius = 0.0f;
+}
+
+/**
+ * Add an object that was just appended to the given object list.
+ */
+void obj_hash_insert(struct Object *obj, s32 listIndex) {
+    s16 index = obj - gObjectPool;
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+
+    obj_hash_remove(obj);
+
+    node->listIndex = listIndex;
+    node->order = ++sObjectHashOrder;
+    node->cell = obj_hash_cell(obj);
+    node->behaviorBucket = obj_hash_behavior_bucket(obj->behavior);
+    obj_hash_link_cell(index);
+    obj_hash_link_behavior(index);
+}
+
+void obj_hash_remove(struct Object *obj) {
+    s16 index = obj - gObjectPool;
+
+    if (sObjectHashNodes[index].listIndex != OBJ_HASH_NONE) {
+        obj_hash_unlink_cell(index);
+        obj_hash_unlink_behavior(index);
+        sObjectHashNodes[index].listIndex = OBJ_HASH_NONE;
+    }
+}
+
+/**
+ * Move the object to the cell for its current position.
+ */
+void obj_hash_update_position(struct Object *obj) {
+    s16 index = obj - gObjectPool;
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+    s16 cell;
+
+    if (node->listIndex != OBJ_HASH_NONE && (cell = obj_hash_cell(obj)) != node->cell) {
+        obj_hash_unlink_cell(index);
+        node->cell = cell;
+        obj_hash_link_cell(index);
+    }
+}
+
+/**
+ * Move the object to the chain for its current behavior.
+ */
+void obj_hash_update_behavior(struct Object *obj) {
+    s16 index = obj - gObjectPool;
+    struct ObjectHashNode *node = &sObjectHashNodes[index];
+    s16 bucket;
+
+    if (node->listIndex != OBJ_HASH_NONE
+        && (bucket = obj_hash_behavior_bucket(obj->behavior)) != node->behaviorBucket) {
+        obj_hash_unlink_behavior(index);
+        node->behaviorBucket = bucket;
+        obj_hash_link_behavior(index);
+    }
+}
+
+/**
+ * Return the object after obj (or the first one if obj is NULL) in the given
+ * object list that has the given behavior, in list order.
+ */
+struct Object *obj_hash_next_with_behavior(struct Object *obj, const BehaviorScript *behavior,
+                                           s32 listIndex) {
+    s16 index;
+
+    if (obj == NULL) {
+        index = sObjectHashBehaviors[obj_hash_behavior_bucket(behavior)];
+    } else {
+        index = sObjectHashNodes[obj - gObjectPool].nextInBehavior;
+    }
+
+    while (index != OBJ_HASH_NONE) {
+        if (gObjectPool[index].behavior == behavior && sObjectHashNodes[index].listIndex == listIndex) {
+            return &gObjectPool[index];
+        }
+        index = sObjectHashNodes[index].nextInBehavior;
+    }
+
+    return NULL;
+}
+
+/**
+ * Objects also get moved by other objects, Mario and platforms, so catch up
+ * on those before testing collisions. Also find the largest hitbox, which
+ * decides how far from an object the candidates need to be looked for.
+ */
+static void obj_hash_sync(void) {
+    f32 maxRadius = 0.0f;
+    s32 i;
+
+    for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+        if (sObjectHashNodes[i].listIndex != OBJ_HASH_NONE) {
+            obj_hash_update_position(&gObjectPool[i]);
+            // A NaN radius never overlaps anything, so it can be skipped
+            if (gObjectPool[i].hitboxRadius > maxRadius) {
+                maxRadius = gObjectPool[i].hitboxRadius;
+            }
+        }
+    }
+
+    sObjectHashMaxHitboxRadius = maxRadius;
+}
+
+static s32 obj_hash_collect_cell(s16 index, struct Object *a, s32 listIndex, s32 count) {
+    struct ObjectHashNode *aNode = &sObjectHashNodes[a - gObjectPool];
+
+    while (index != OBJ_HASH_NONE) {
+        // Objects earlier in a's own list already checked against a
+        if (sObjectHashNodes[index].listIndex == listIndex
+            && (aNode->listIndex != listIndex || sObjectHashNodes[index].order > aNode->order)) {
+            sObjectHashCandidates[count++] = &gObjectPool[index];
+        }
+        index = sObjectHashNodes[index].nextInCell;
+    }
+
+    return count;
+}
+
+/**
+ * Gather the objects in the given list whose hitbox could reach a's, in list
+ * order. Returns -1 if a is too big or too far out for the grid.
+ */
+static s32 obj_hash_find_nearby(struct Object *a, s32 listIndex) {
+    f32 reach = a->hitboxRadius + sObjectHashMaxHitboxRadius + 1.0f;
+    f32 x = a->oPosX + 32768.0f;
+    f32 z = a->oPosZ + 32768.0f;
+    s32 loX, hiX, loZ, hiZ;
+    s32 cellX, cellZ;
+    s32 count = 0;
+    s32 i, j;
+    struct Object *obj;
+    u32 order;
+
+    if (sObjectHashNodes[a - gObjectPool].listIndex == OBJ_HASH_NONE) {
+        return -1;
+    }
+    if (reach < 0.0f) {
+        reach = 0.0f;
+    }
+    // Keep the range under half the grid so no cell gets visited twice
+    if (!(reach < 4096.0f && x - reach > 0.0f && x + reach < 65536.0f && z - reach > 0.0f
+          && z + reach < 65536.0f)) {
+        return -1;
+    }
+
+    loX = (s32)(x - reach) >> OBJ_HASH_CELL_SHIFT;
+    hiX = (s32)(x + reach) >> OBJ_HASH_CELL_SHIFT;
+    loZ = (s32)(z - reach) >> OBJ_HASH_CELL_SHIFT;
+    hiZ = (s32)(z + reach) >> OBJ_HASH_CELL_SHIFT;
+
+    for (cellZ = loZ; cellZ <= hiZ; cellZ++) {
+        for (cellX = loX; cellX <= hiX; cellX++) {
+            count = obj_hash_collect_cell(sObjectHashCells[(cellZ & (OBJ_HASH_CELLS - 1)) * OBJ_HASH_CELLS
+                                                           + (cellX & (OBJ_HASH_CELLS - 1))],
+                                          a, listIndex, count);
+        }
+    }
+    count = obj_hash_collect_cell(sObjectHashCells[OBJ_HASH_OVERFLOW_CELL], a, listIndex, count);
+
+    for (i = 1; i < count; i++) {
+        obj = sObjectHashCandidates[i];
+        order = sObjectHashNodes[obj - gObjectPool].order;
+        for (j = i; j > 0 && sObjectHashNodes[sObjectHashCandidates[j - 1] - gObjectPool].order > order; j--) {
+            sObjectHashCandidates[j] = sObjectHashCandidates[j - 1];
+        }
+        sObjectHashCandidates[j] = obj;
+    }
+
+    return count;
+}
+#endif
+
 struct Object *debug_print_obj_collision(struct Object *a) {
     struct Object *sp24;
     UNUSED s32 unused;
@@ -115,6 +428,78 @@ void check_collision_in_list(struct Object *a, struct Object *b, struct Object *
     }
 }
 
+#ifdef OBJECT_HASH
+/**
+ * Same as check_collision_in_list for the rest of a's list (or all of another
+ * list), but only visiting the objects near a.
+ */
+static void check_collision_in_list_near(struct Object *a, s32 listIndex) {
+    struct Object *listHead = (struct Object *) &gObjectLists[listIndex];
+    struct Object *b;
+    s32 count;
+    s32 i;
+
+    if (a->oIntangibleTimer == 0) {
+        count = obj_hash_find_nearby(a, listIndex);
+        if (count < 0) {
+            b = sObjectHashNodes[a - gObjectPool].listIndex == listIndex ? (struct Object *) a->header.next
+                                                                        : (struct Object *) listHead->header.next;
+            check_collision_in_list(a, b, listHead);
+            return;
+        }
+
+        for (i = 0; i < count; i++) {
+            b = sObjectHashCandidates[i];
+            if (b->oIntangibleTimer == 0) {
+                if (detect_object_hitbox_overlap(a, b) && b->hurtboxRadius != 0.0f) {
+                    detect_object_hurtbox_overlap(a, b);
+                }
+            }
+        }
+    }
+}
+
+void check_player_object_collision(void) {
+    struct Object *sp1C = (struct Object *) &gObjectLists[OBJ_LIST_PLAYER];
+    struct Object *sp18 = (struct Object *) sp1C->header.next;
+
+    while (sp18 != sp1C) {
+        check_collision_in_list_near(sp18, OBJ_LIST_PLAYER);
+        check_collision_in_list_near(sp18, OBJ_LIST_POLELIKE);
+        check_collision_in_list_near(sp18, OBJ_LIST_LEVEL);
+        check_collision_in_list_near(sp18, OBJ_LIST_GENACTOR);
+        check_collision_in_list_near(sp18, OBJ_LIST_PUSHABLE);
+        check_collision_in_list_near(sp18, OBJ_LIST_SURFACE);
+        check_collision_in_list_near(sp18, OBJ_LIST_DESTRUCTIVE);
+        sp18 = (struct Object *) sp18->header.next;
+    }
+}
+
+void check_pushable_object_collision(void) {
+    struct Object *sp1C = (struct Object *) &gObjectLists[OBJ_LIST_PUSHABLE];
+    struct Object *sp18 = (struct Object *) sp1C->header.next;
+
+    while (sp18 != sp1C) {
+        check_collision_in_list_near(sp18, OBJ_LIST_PUSHABLE);
+        sp18 = (struct Object *) sp18->header.next;
+    }
+}
+
+void check_destructive_object_collision(void) {
+    struct Object *sp1C = (struct Object *) &gObjectLists[OBJ_LIST_DESTRUCTIVE];
+    struct Object *sp18 = (struct Object *) sp1C->header.next;
+
+    while (sp18 != sp1C) {
+        if (sp18->oDistanceToMario < 2000.0f && !(sp18->activeFlags & ACTIVE_FLAG_UNK9)) {
+            check_collision_in_list_near(sp18, OBJ_LIST_DESTRUCTIVE);
+            check_collision_in_list_near(sp18, OBJ_LIST_GENACTOR);
+            check_collision_in_list_near(sp18, OBJ_LIST_PUSHABLE);
+            check_collision_in_list_near(sp18, OBJ_LIST_SURFACE);
+        }
+        sp18 = (struct Object *) sp18->header.next;
+    }
+}
+#else
 void check_player_object_collision(void) {
     struct Object *sp1C = (struct Object *) &gObjectLists[OBJ_LIST_PLAYER];
     struct Object *sp18 = (struct Object *) sp1C->header.next;
@@ -164,6 +549,7 @@ void check_destructive_object_collision(void) {
         sp18 = (struct Object *) sp18->header.next;
     }
 }
+#endif
 
 void detect_object_collisions(void) {
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_POLELIKE]);
@@ -173,7 +559,20 @@ void detect_object_collisions(void) {
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_LEVEL]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_SURFACE]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_DESTRUCTIVE]);
+#ifdef OBJECT_HASH
+    obj_hash_sync();
+#endif
     check_player_object_collision();
     check_destructive_object_collision();
     check_pushable_object_collision();
 }
+
+#if defined(OBJECT_HASH) && defined(SNAPSHOTS)
+void obj_hash_snapshot_regions(void) {
+    SNAPSHOT_REGION(sObjectHashNodes);
+    SNAPSHOT_REGION(sObjectHashCells);
+    SNAPSHOT_REGION(sObjectHashBehaviors);
+    SNAPSHOT_REGION(sObjectHashOrder);
+    SNAPSHOT_REGION(sObjectHashMaxHitboxRadius);
+}
+#endif
@@ -2,5 +2,17 @@
 #define OBJECT_COLLISION_H
 
 void detect_object_collisions(void);
+#ifdef OBJECT_HASH
+void obj_hash_clear(void);
+void obj_hash_insert(struct Object *obj, s32 listIndex);
+void obj_hash_remove(struct Object *obj);
+void obj_hash_update_position(struct Object *obj);
+void obj_hash_update_behavior(struct Object *obj);
+struct Object *obj_hash_next_with_behavior(struct Object *obj, const BehaviorScript *behavior,
+                                           s32 listIndex);
+#ifdef SNAPSHOTS
+void obj_hash_snapshot_regions(void);
+#endif
+#endif
 
 #endif // OBJECT_COLLISION_H
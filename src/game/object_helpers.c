@@ -21,6 +21,7 @@
 #include "mario_actions_cutscene.h"
 #include "memory.h"
 #include "obj_behaviors.h"
+#include "object_collision.h"
 #include "object_helpers.h"
 #include "object_list_processor.h"
 #include "rendering_graph_node.h"
@@ -849,9 +850,24 @@ struct Object *cur_obj_find_nearest_object_with_behavior(const BehaviorScript *b
     uintptr_t *behaviorAddr = segmented_to_virtual(behavior);
     struct Object *closestObj = NULL;
     struct Object *obj;
-    struct ObjectNode *listHead;
     f32 minDist = 0x20000;
 
+#ifdef OBJECT_HASH
+    s32 listIndex = get_object_list_from_behavior(behaviorAddr);
+
+    for (obj = obj_hash_next_with_behavior(NULL, (BehaviorScript *) behaviorAddr, listIndex); obj != NULL;
+         obj = obj_hash_next_with_behavior(obj, (BehaviorScript *) behaviorAddr, listIndex)) {
+        if (obj->activeFlags != ACTIVE_FLAG_DEACTIVATED && obj != o) {
+            f32 objDist = dist_between_objects(o, obj);
+            if (objDist < minDist) {
+                closestObj = obj;
+                minDist = objDist;
+            }
+        }
+    }
+#else
+    struct ObjectNode *listHead;
+
     listHead = &gObjectLists[get_object_list_from_behavior(behaviorAddr)];
     obj = (struct Object *) listHead->next;
 
@@ -867,6 +883,7 @@ struct Object *cur_obj_find_nearest_object_with_behavior(const BehaviorScript *b
         }
         obj = (struct Object *) obj->header.next;
     }
+#endif
 
     *dist = minDist;
     return closestObj;
@@ -898,6 +915,18 @@ s32 count_unimportant_objects(void) {
 
 s32 count_objects_with_behavior(const BehaviorScript *behavior) {
     uintptr_t *behaviorAddr = segmented_to_virtual(behavior);
+#ifdef OBJECT_HASH
+    s32 listIndex = get_object_list_from_behavior(behaviorAddr);
+    struct Object *obj = obj_hash_next_with_behavior(NULL, (BehaviorScript *) behaviorAddr, listIndex);
+    s32 count = 0;
+
+    while (obj != NULL) {
+        count++;
+        obj = obj_hash_next_with_behavior(obj, (BehaviorScript *) behaviorAddr, listIndex);
+    }
+
+    return count;
+#else
     struct ObjectNode *listHead = &gObjectLists[get_object_list_from_behavior(behaviorAddr)];
     struct ObjectNode *obj = listHead->next;
     s32 count = 0;
@@ -911,6 +940,7 @@ s32 count_objects_with_behavior(const BehaviorScript *behavior) {
     }
 
     return count;
+#endif
 }
 
 struct Object *cur_obj_find_nearby_held_actor(const BehaviorScript *behavior, f32 maxDist) {
@@ -1466,10 +1496,16 @@ s32 obj_check_if_collided_with_object(struct Object *obj1, struct Object *obj2)
 
 void cur_obj_set_behavior(const BehaviorScript *behavior) {
     o->behavior = segmented_to_virtual(behavior);
+#ifdef OBJECT_HASH
+    obj_hash_update_behavior(o);
+#endif
 }
 
 void obj_set_behavior(struct Object *obj, const BehaviorScript *behavior) {
     obj->behavior = segmented_to_virtual(behavior);
+#ifdef OBJECT_HASH
+    obj_hash_update_behavior(obj);
+#endif
 }
 
 s32 cur_obj_has_behavior(const BehaviorScript *behavior) {
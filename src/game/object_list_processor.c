@@ -20,6 +20,21 @@
 #include "profiler.h"
 #include "spawn_object.h"
 
+#ifdef BEHAVIOR_BENCHMARK
+#include <stdio.h>
+
+/**
+ * Time spent updating objects, printed as objects per millisecond every
+ * BEHAVIOR_BENCHMARK_FRAMES frames.
+ */
+#define BEHAVIOR_BENCHMARK_FRAMES 300
+
+static struct {
+    OSTime time;
+    u32 objects;
+    u32 frames;
+} sBehaviorBenchmark;
+#endif
 
 /**
  * Flags controlling what debug info is displayed.
@@ -138,6 +153,15 @@ s32 gNumStaticSurfaceNodes;
  */
 s32 gNumStaticSurfaces;
 
+#ifdef DYNAMIC_SURFACE_REUSE
+/**
+ * The number of object surfaces built from collision data this frame, and the
+ * number carried over from last frame because their object didn't move.
+ */
+s32 gNumDynamicSurfacesRebuilt;
+s32 gNumDynamicSurfacesReused;
+#endif
+
 /**
  * A pool used by chain chomp and wiggler to allocate their body parts.
  */
@@ -298,6 +322,9 @@ s32 update_objects_starting_at(struct ObjectNode *objList, struct ObjectNode *fi
 
         gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
         cur_obj_update();
+#ifdef BEHAVIOR_BENCHMARK
+        sBehaviorBenchmark.objects++;
+#endif
 
         firstObj = firstObj->next;
         count += 1;
@@ -345,6 +372,9 @@ s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNod
         if (unfrozen) {
             gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
             cur_obj_update();
+#ifdef BEHAVIOR_BENCHMARK
+            sBehaviorBenchmark.objects++;
+#endif
         } else {
             gCurrentObject->header.gfx.node.flags &= ~GRAPH_RENDER_HAS_ANIMATION;
         }
@@ -542,6 +572,9 @@ void clear_objects(void) {
 
     init_free_object_list();
     clear_object_lists(gObjectListArray);
+#ifdef OBJECT_HASH
+    obj_hash_clear();
+#endif
 
     stub_behavior_script_2();
     stub_obj_list_processor_1();
@@ -605,6 +638,9 @@ void unload_deactivated_objects(void) {
  */
 void update_objects(UNUSED s32 unused) {
     s64 cycleCounts[30];
+#ifdef BEHAVIOR_BENCHMARK
+    OSTime benchmarkStart;
+#endif
 
     cycleCounts[0] = get_current_clock();
 
@@ -625,7 +661,13 @@ void update_objects(UNUSED s32 unused) {
 
     // Update spawners and objects with surfaces
     cycleCounts[2] = get_clock_difference(cycleCounts[0]);
+#ifdef BEHAVIOR_BENCHMARK
+    benchmarkStart = osGetTime();
+    update_terrain_objects();
+    sBehaviorBenchmark.time += osGetTime() - benchmarkStart;
+#else
     update_terrain_objects();
+#endif
 
     // If Mario was touching a moving platform at the end of last frame, apply
     // displacement now
@@ -639,7 +681,22 @@ void update_objects(UNUSED s32 unused) {
 
     // Update all other objects that haven't been updated yet
     cycleCounts[4] = get_clock_difference(cycleCounts[0]);
+#ifdef BEHAVIOR_BENCHMARK
+    benchmarkStart = osGetTime();
+    update_non_terrain_objects();
+    sBehaviorBenchmark.time += osGetTime() - benchmarkStart;
+
+    if (++sBehaviorBenchmark.frames == BEHAVIOR_BENCHMARK_FRAMES) {
+        // osGetTime ticks in microseconds
+        printf("BHV: %u objects updated in %u us, %u objects/ms\n", (unsigned) sBehaviorBenchmark.objects,
+               (unsigned) sBehaviorBenchmark.time,
+               sBehaviorBenchmark.time != 0
+                   ? (unsigned) (sBehaviorBenchmark.objects * 1000ULL / sBehaviorBenchmark.time) : 0);
+        bzero(&sBehaviorBenchmark, sizeof(sBehaviorBenchmark));
+    }
+#else
     update_non_terrain_objects();
+#endif
 
     // Unload any objects that have been deactivated
     cycleCounts[5] = get_clock_difference(cycleCounts[0]);
@@ -95,6 +95,10 @@ extern s32 gSurfaceNodesAllocated;
 extern s32 gSurfacesAllocated;
 extern s32 gNumStaticSurfaceNodes;
 extern s32 gNumStaticSurfaces;
+#ifdef DYNAMIC_SURFACE_REUSE
+extern s32 gNumDynamicSurfacesRebuilt;
+extern s32 gNumDynamicSurfacesReused;
+#endif
 
 extern struct MemoryPool *gObjectMemoryPool;
 
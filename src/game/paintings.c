@@ -154,6 +154,32 @@ struct PaintingMeshVertex *gPaintingMesh;
  */
 Vec3f *gPaintingTriNorms;
 
+#ifdef PAINTING_MESH_CACHE
+/// Size of seg2_painting_triangle_mesh. Bigger meshes are allocated from gEffectsMemoryPool.
+#define PAINTING_MESH_MAX_VTX 157
+#define PAINTING_MESH_MAX_TRIS 264
+#define PAINTING_DISTANCE_CACHE_SIZE 4
+
+/**
+ * How far a painting's ripple has to spread to reach each mesh vertex. This only depends on the
+ * ripple's origin and dispersion, which stay the same for the whole ripple, so the sqrtf and
+ * division per vertex only need to be done when a ripple starts.
+ */
+struct PaintingRippleDistances {
+    struct Painting *painting;
+    f32 size;
+    f32 rippleX;
+    f32 rippleY;
+    f32 dispersionFactor;
+    f32 distance[PAINTING_MESH_MAX_VTX];
+};
+
+static struct PaintingMeshVertex sPaintingMeshBuffer[PAINTING_MESH_MAX_VTX];
+static Vec3f sPaintingTriNormsBuffer[PAINTING_MESH_MAX_TRIS];
+static struct PaintingRippleDistances sPaintingRippleDistances[PAINTING_DISTANCE_CACHE_SIZE];
+static s32 sPaintingRippleDistancesNext;
+#endif
+
 /**
  * The painting that is currently rippling. Only one painting can be rippling at once.
  */
@@ -647,6 +673,62 @@ s16 calculate_ripple_at_point(struct Painting *painting, f32 posX, f32 posY) {
     }
 }
 
+#ifdef PAINTING_MESH_CACHE
+/**
+ * Get the ripple distance of each vertex in `mesh` for the painting's current ripple, computing
+ * them the same way calculate_ripple_at_point does if the ripple changed since the last call.
+ */
+static f32 *painting_ripple_distances(struct Painting *painting, s16 *mesh, s16 numVtx) {
+    struct PaintingRippleDistances *entry;
+    f32 posX;
+    f32 posY;
+    f32 distanceToOrigin;
+    s32 i;
+
+    for (i = 0; i < PAINTING_DISTANCE_CACHE_SIZE; i++) {
+        entry = &sPaintingRippleDistances[i];
+        if (entry->painting == painting && entry->size == painting->size
+            && entry->rippleX == painting->rippleX && entry->rippleY == painting->rippleY
+            && entry->dispersionFactor == painting->dispersionFactor) {
+            return entry->distance;
+        }
+    }
+
+    entry = &sPaintingRippleDistances[sPaintingRippleDistancesNext];
+    sPaintingRippleDistancesNext = (sPaintingRippleDistancesNext + 1) % PAINTING_DISTANCE_CACHE_SIZE;
+    entry->painting = painting;
+    entry->size = painting->size;
+    entry->rippleX = painting->rippleX;
+    entry->rippleY = painting->rippleY;
+    entry->dispersionFactor = painting->dispersionFactor;
+
+    for (i = 0; i < numVtx; i++) {
+        posX = mesh[i * 3 + 1];
+        posY = mesh[i * 3 + 2];
+        posX *= painting->size / PAINTING_SIZE;
+        posY *= painting->size / PAINTING_SIZE;
+        distanceToOrigin = sqrtf((posX - painting->rippleX) * (posX - painting->rippleX)
+                                 + (posY - painting->rippleY) * (posY - painting->rippleY));
+        entry->distance[i] = distanceToOrigin / painting->dispersionFactor;
+    }
+    return entry->distance;
+}
+
+/**
+ * The second half of calculate_ripple_at_point, for a point `rippleDistance` away from the origin.
+ */
+static s16 painting_ripple_at_distance(struct Painting *painting, f32 rippleDistance) {
+    f32 rippleZ;
+
+    if (painting->rippleTimer < rippleDistance) {
+        return 0;
+    }
+    rippleZ = painting->currRippleMag
+              * cosf(painting->currRippleRate * (2 * M_PI) * (painting->rippleTimer - rippleDistance));
+    return round_float(rippleZ);
+}
+#endif
+
 /**
  * If movable, return the ripple function at (posX, posY)
  * else return 0
@@ -681,6 +763,21 @@ s16 ripple_if_movable(struct Painting *painting, s16 movable, s16 posX, s16 posY
  */
 void painting_generate_mesh(struct Painting *painting, s16 *mesh, s16 numTris) {
     s16 i;
+#ifdef PAINTING_MESH_CACHE
+    f32 *distances;
+
+    if (numTris <= PAINTING_MESH_MAX_VTX) {
+        gPaintingMesh = sPaintingMeshBuffer;
+        distances = painting_ripple_distances(painting, mesh, numTris);
+        for (i = 0; i < numTris; i++) {
+            gPaintingMesh[i].pos[0] = mesh[i * 3 + 1];
+            gPaintingMesh[i].pos[1] = mesh[i * 3 + 2];
+            gPaintingMesh[i].pos[2] =
+                mesh[i * 3 + 3] ? painting_ripple_at_distance(painting, distances[i]) : 0;
+        }
+        return;
+    }
+#endif
 
     gPaintingMesh = mem_pool_alloc(gEffectsMemoryPool, numTris * sizeof(struct PaintingMeshVertex));
     if (gPaintingMesh == NULL) {
@@ -714,7 +811,13 @@ void painting_generate_mesh(struct Painting *painting, s16 *mesh, s16 numTris) {
 void painting_calculate_triangle_normals(s16 *mesh, s16 numVtx, s16 numTris) {
     s16 i;
 
+#ifdef PAINTING_MESH_CACHE
+    gPaintingTriNorms = numTris <= PAINTING_MESH_MAX_TRIS
+                            ? sPaintingTriNormsBuffer
+                            : mem_pool_alloc(gEffectsMemoryPool, numTris * sizeof(Vec3f));
+#else
     gPaintingTriNorms = mem_pool_alloc(gEffectsMemoryPool, numTris * sizeof(Vec3f));
+#endif
     if (gPaintingTriNorms == NULL) {
     }
     for (i = 0; i < numTris; i++) {
@@ -1035,8 +1138,17 @@ Gfx *display_painting_rippling(struct Painting *painting) {
     }
 
     // The mesh data is freed every frame.
+#ifdef PAINTING_MESH_CACHE
+    if (gPaintingMesh != sPaintingMeshBuffer) {
+        mem_pool_free(gEffectsMemoryPool, gPaintingMesh);
+    }
+    if (gPaintingTriNorms != sPaintingTriNormsBuffer) {
+        mem_pool_free(gEffectsMemoryPool, gPaintingTriNorms);
+    }
+#else
     mem_pool_free(gEffectsMemoryPool, gPaintingMesh);
     mem_pool_free(gEffectsMemoryPool, gPaintingTriNorms);
+#endif
     return dlist;
 }
 
@@ -1,4 +1,7 @@
 #include <PR/ultratypes.h>
+#ifdef HIGH_FPS
+#include <string.h>
+#endif
 
 #include "area.h"
 #include "engine/math_util.h"
@@ -11,6 +14,23 @@
 #include "shadow.h"
 #include "sm64.h"
 
+#ifdef ANIM_BENCHMARK
+#include <stdio.h>
+
+/**
+ * Bone matrices built and time spent processing the scene graph, printed as
+ * bone matrices per millisecond every ANIM_BENCHMARK_FRAMES frames.
+ */
+#define ANIM_BENCHMARK_FRAMES 300
+
+static struct {
+    OSTime time;
+    u32 bones;
+    u32 cachedBones;
+    u32 frames;
+} sAnimBenchmark;
+#endif
+
 /**
  * This file contains the code that processes the scene graph for rendering.
  * The scene graph is responsible for drawing everything except the HUD / text boxes.
@@ -65,8 +85,77 @@ f32 gCurAnimTranslationMultiplier;
 u16 *gCurrAnimAttribute;
 s16 *gCurAnimData;
 
+#ifdef ANIM_POSE_CACHE
+/**
+ * Decoded poses of animated parts, shared between objects that play the same
+ * animation on the same frame (a room full of Goombas mostly is). Entries are
+ * keyed on the animation's values, the joint's place in its index table, the
+ * frame and the animation type the joint is decoded with. They hold the
+ * unscaled translation and the rotation read from the animation, the rotation
+ * matrix, and where the joint's attributes end, so a hit skips both the
+ * decoding and the trigonometry. The translation row is filled in per object,
+ * so a hit gives exactly the matrix mtxf_rotate_xyz_and_translate builds.
+ * Mario's animations are all loaded into the same buffer, so loading one
+ * starts a new generation and every older entry misses.
+ */
+#define ANIM_POSE_CACHE_SIZE 512
+
+struct AnimPoseCacheEntry {
+    u32 generation;
+    s16 *data;
+    u16 *attribute;
+    u16 *attributeEnd;
+    s16 frame;
+    u8 animType;
+    Vec3s translation;
+    Vec3s rotation;
+    Mat4 matrix;
+};
+
+static struct AnimPoseCacheEntry sAnimPoseCache[ANIM_POSE_CACHE_SIZE];
+static u32 sAnimPoseCacheGeneration = 1;
+#endif
+
 struct AllocOnlyPool *gDisplayListHeap;
 
+#ifdef FLAT_RENDER_LIST
+/**
+ * The children of a camera node, mostly the level geometry of an area, don't
+ * change once the area is loaded. They are compiled into a flat list of
+ * commands that is run in a loop instead of walked recursively. Nodes that
+ * can't be inlined (objects, generated lists, switches, ...) get a command
+ * that hands them to geo_process_node, which walks them the usual way.
+ */
+#define RENDER_LIST_CAPACITY 2048
+#define RENDER_LIST_CAMERAS 8
+
+enum RenderCmdType {
+    RENDER_CMD_NODE,
+    RENDER_CMD_DISPLAY_LIST,
+    RENDER_CMD_PUSH,
+    RENDER_CMD_POP
+};
+
+struct RenderListCmd {
+    struct GraphNode *node;
+    s16 type;
+    s16 end; // index of the first command after this node's children
+};
+
+static struct RenderListCmd sRenderListCmds[RENDER_LIST_CAPACITY];
+static s32 sRenderListCmdsUsed = 0;
+
+static struct {
+    struct GraphNodeCamera *camera;
+    struct GraphNode *children;
+    s32 start;
+    s32 count;
+} sRenderLists[RENDER_LIST_CAMERAS];
+static s32 sNumRenderLists = 0;
+
+static void geo_process_camera_children(struct GraphNodeCamera *node);
+#endif
+
 struct RenderModeContainer {
     u32 modes[8];
 };
@@ -129,6 +218,196 @@ u16 gAreaUpdateCounter = 0;
 LookAt lookAt;
 #endif
 
+#ifdef HIGH_FPS
+/**
+ * Frame interpolation. Every fixed point matrix the traversal writes is recorded
+ * together with its float source, keyed on the node that produced it and the
+ * object it was drawn for (shared geo layouts are reused by many objects).
+ * The previous tick's table is kept around, so between two 30 Hz ticks the
+ * port can rewrite each recorded Mtx with a blend of both ticks and submit the
+ * same display list again. Matrices that jump too far (teleports, object slots
+ * being reused) are left alone, and a camera cut disables the blend entirely.
+ */
+#define INTERP_MTX_MAX 2048
+#define INTERP_HASH_SIZE (INTERP_MTX_MAX * 2)
+#define INTERP_SNAP_DIST 1000.0f
+#define INTERP_SNAP_ROT 0.5f
+
+struct InterpMtxEntry {
+    const void *node;
+    const void *ctx;
+    Mtx *dest;
+    s16 prev;  // index into the previous tick's table, -1 if there is nothing to blend from
+    s16 dup;   // key was seen more than once this tick
+    Mat4 mtx;
+};
+
+struct InterpMtxTable {
+    s32 count;
+    s16 hash[INTERP_HASH_SIZE];
+    struct InterpMtxEntry entries[INTERP_MTX_MAX];
+};
+
+static struct InterpMtxTable sInterpTables[2];
+static struct InterpMtxTable *sInterpCur = &sInterpTables[0];
+static struct InterpMtxTable *sInterpPrev = &sInterpTables[1];
+static u8 sInterpInited = FALSE;
+static u8 sInterpSnap = FALSE;
+static u8 sInterpPatched = FALSE;
+
+static u32 geo_interp_hash(const void *node, const void *ctx) {
+    uintptr_t h = (uintptr_t) node * 31 + (uintptr_t) ctx;
+
+    h ^= h >> 15;
+    h *= 0x2C1B3C6D;
+    h ^= h >> 12;
+    return (u32) h & (INTERP_HASH_SIZE - 1);
+}
+
+static s32 geo_interp_find(struct InterpMtxTable *table, const void *node, const void *ctx, u32 *slot) {
+    u32 i = geo_interp_hash(node, ctx);
+
+    while (table->hash[i] >= 0) {
+        struct InterpMtxEntry *e = &table->entries[table->hash[i]];
+
+        if (e->node == node && e->ctx == ctx) {
+            break;
+        }
+        i = (i + 1) & (INTERP_HASH_SIZE - 1);
+    }
+    if (slot != NULL) {
+        *slot = i;
+    }
+    return table->hash[i];
+}
+
+static s32 geo_interp_is_snap(Mat4 a, Mat4 b, s32 checkRotation) {
+    s32 i, j;
+    f32 dist = sqr(a[3][0] - b[3][0]) + sqr(a[3][1] - b[3][1]) + sqr(a[3][2] - b[3][2]);
+
+    if (dist > sqr(INTERP_SNAP_DIST)) {
+        return TRUE;
+    }
+    if (checkRotation) {
+        for (i = 0; i < 3; i++) {
+            for (j = 0; j < 3; j++) {
+                f32 d = a[i][j] - b[i][j];
+
+                if (d > INTERP_SNAP_ROT || d < -INTERP_SNAP_ROT) {
+                    return TRUE;
+                }
+            }
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Remember the float matrix that was just converted into 'dest', so it can be
+ * blended with last tick's value for the same node.
+ */
+static void geo_interp_record(void *node, Mtx *dest, Mat4 mtx) {
+    const void *ctx = gCurGraphNodeHeldObject != NULL ? (void *) gCurGraphNodeHeldObject->objNode
+                                                      : (void *) gCurGraphNodeObject;
+    struct InterpMtxEntry *e;
+    s32 isCamera = ((struct GraphNode *) node)->type == GRAPH_NODE_TYPE_CAMERA;
+    s32 index;
+    u32 slot;
+
+    if (!sInterpInited || dest == NULL || sInterpCur->count >= INTERP_MTX_MAX) {
+        return;
+    }
+
+    index = geo_interp_find(sInterpCur, node, ctx, &slot);
+    if (index >= 0) {
+        // Same node drawn twice in one tick, there is no telling which is which
+        sInterpCur->entries[index].dup = TRUE;
+        return;
+    }
+
+    index = sInterpCur->count++;
+    sInterpCur->hash[slot] = index;
+    e = &sInterpCur->entries[index];
+    e->node = node;
+    e->ctx = ctx;
+    e->dest = dest;
+    e->dup = FALSE;
+    mtxf_copy(e->mtx, mtx);
+
+    e->prev = geo_interp_find(sInterpPrev, node, ctx, NULL);
+    if (e->prev >= 0) {
+        struct InterpMtxEntry *p = &sInterpPrev->entries[e->prev];
+
+        if (p->dup || geo_interp_is_snap(p->mtx, mtx, isCamera)) {
+            e->prev = -1;
+        }
+    }
+    if (isCamera && e->prev < 0) {
+        sInterpSnap = TRUE;
+    }
+}
+
+/**
+ * Rewrite every matrix of the current tick as prev + (cur - prev) * t.
+ */
+void geo_interp_patch(f32 t) {
+    s32 i, j, k;
+    Mat4 blend;
+
+    if (!sInterpInited || sInterpSnap) {
+        return;
+    }
+    for (i = 0; i < sInterpCur->count; i++) {
+        struct InterpMtxEntry *e = &sInterpCur->entries[i];
+        struct InterpMtxEntry *p;
+
+        if (e->prev < 0 || e->dup) {
+            continue;
+        }
+        p = &sInterpPrev->entries[e->prev];
+        for (j = 0; j < 4; j++) {
+            for (k = 0; k < 4; k++) {
+                blend[j][k] = p->mtx[j][k] + (e->mtx[j][k] - p->mtx[j][k]) * t;
+            }
+        }
+        mtxf_to_mtx(e->dest, blend);
+    }
+    sInterpPatched = TRUE;
+}
+
+/**
+ * Put the current tick's matrices back in place and start recording the next tick.
+ */
+void geo_interp_end_tick(void) {
+    struct InterpMtxTable *swap;
+    s32 i;
+
+    if (sInterpInited && sInterpPatched && !sInterpSnap) {
+        for (i = 0; i < sInterpCur->count; i++) {
+            struct InterpMtxEntry *e = &sInterpCur->entries[i];
+
+            if (e->prev >= 0 && !e->dup) {
+                mtxf_to_mtx(e->dest, e->mtx);
+            }
+        }
+    }
+
+    swap = sInterpPrev;
+    sInterpPrev = sInterpCur;
+    sInterpCur = swap;
+    if (!sInterpInited) {
+        memset(sInterpPrev->hash, 0xFF, sizeof(sInterpPrev->hash));
+        sInterpInited = TRUE;
+    }
+    sInterpCur->count = 0;
+    memset(sInterpCur->hash, 0xFF, sizeof(sInterpCur->hash));
+    sInterpSnap = FALSE;
+    sInterpPatched = FALSE;
+}
+#else
+#define geo_interp_record(node, dest, mtx)
+#endif
+
 /**
  * Process a master list node.
  */
@@ -329,22 +608,24 @@ static void geo_process_camera(struct GraphNodeCamera *node) {
     gMatStackIndex++;
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
+    geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
     if (node->fnNode.node.children != 0) {
         gCurGraphNodeCamera = node;
         node->matrixPtr = &gMatStack[gMatStackIndex];
+#ifdef FLAT_RENDER_LIST
+        geo_process_camera_children(node);
+#else
         geo_process_node_and_siblings(node->fnNode.node.children);
+#endif
         gCurGraphNodeCamera = NULL;
     }
     gMatStackIndex--;
 }
 
 /**
- * Process a translation / rotation node. A transformation matrix based
- * on the node's translation and rotation is created and pushed on both
- * the float and fixed point matrix stacks.
- * For the rest it acts as a normal display list node.
+ * Push the transformation of a translation / rotation node and append its display list.
  */
-static void geo_process_translation_rotation(struct GraphNodeTranslationRotation *node) {
+static void geo_push_translation_rotation(struct GraphNodeTranslationRotation *node) {
     Mat4 mtxf;
     Vec3f translation;
     Mtx *mtx = alloc_display_list(sizeof(*mtx));
@@ -355,9 +636,20 @@ static void geo_process_translation_rotation(struct GraphNodeTranslationRotation
     gMatStackIndex++;
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
+    geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
+}
+
+/**
+ * Process a translation / rotation node. A transformation matrix based
+ * on the node's translation and rotation is created and pushed on both
+ * the float and fixed point matrix stacks.
+ * For the rest it acts as a normal display list node.
+ */
+static void geo_process_translation_rotation(struct GraphNodeTranslationRotation *node) {
+    geo_push_translation_rotation(node);
     if (node->node.children != NULL) {
         geo_process_node_and_siblings(node->node.children);
     }
@@ -365,11 +657,9 @@ static void geo_process_translation_rotation(struct GraphNodeTranslationRotation
 }
 
 /**
- * Process a translation node. A transformation matrix based on the node's
- * translation is created and pushed on both the float and fixed point matrix stacks.
- * For the rest it acts as a normal display list node.
+ * Push the transformation of a translation node and append its display list.
  */
-static void geo_process_translation(struct GraphNodeTranslation *node) {
+static void geo_push_translation(struct GraphNodeTranslation *node) {
     Mat4 mtxf;
     Vec3f translation;
     Mtx *mtx = alloc_display_list(sizeof(*mtx));
@@ -380,9 +670,19 @@ static void geo_process_translation(struct GraphNodeTranslation *node) {
     gMatStackIndex++;
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
+    geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
+}
+
+/**
+ * Process a translation node. A transformation matrix based on the node's
+ * translation is created and pushed on both the float and fixed point matrix stacks.
+ * For the rest it acts as a normal display list node.
+ */
+static void geo_process_translation(struct GraphNodeTranslation *node) {
+    geo_push_translation(node);
     if (node->node.children != NULL) {
         geo_process_node_and_siblings(node->node.children);
     }
@@ -390,11 +690,9 @@ static void geo_process_translation(struct GraphNodeTranslation *node) {
 }
 
 /**
- * Process a rotation node. A transformation matrix based on the node's
- * rotation is created and pushed on both the float and fixed point matrix stacks.
- * For the rest it acts as a normal display list node.
+ * Push the transformation of a rotation node and append its display list.
  */
-static void geo_process_rotation(struct GraphNodeRotation *node) {
+static void geo_push_rotation(struct GraphNodeRotation *node) {
     Mat4 mtxf;
     Mtx *mtx = alloc_display_list(sizeof(*mtx));
 
@@ -403,9 +701,19 @@ static void geo_process_rotation(struct GraphNodeRotation *node) {
     gMatStackIndex++;
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
+    geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
+}
+
+/**
+ * Process a rotation node. A transformation matrix based on the node's
+ * rotation is created and pushed on both the float and fixed point matrix stacks.
+ * For the rest it acts as a normal display list node.
+ */
+static void geo_process_rotation(struct GraphNodeRotation *node) {
+    geo_push_rotation(node);
     if (node->node.children != NULL) {
         geo_process_node_and_siblings(node->node.children);
     }
@@ -413,11 +721,9 @@ static void geo_process_rotation(struct GraphNodeRotation *node) {
 }
 
 /**
- * Process a scaling node. A transformation matrix based on the node's
- * scale is created and pushed on both the float and fixed point matrix stacks.
- * For the rest it acts as a normal display list node.
+ * Push the transformation of a scale node and append its display list.
  */
-static void geo_process_scale(struct GraphNodeScale *node) {
+static void geo_push_scale(struct GraphNodeScale *node) {
     UNUSED Mat4 transform;
     Vec3f scaleVec;
     Mtx *mtx = alloc_display_list(sizeof(*mtx));
@@ -427,9 +733,19 @@ static void geo_process_scale(struct GraphNodeScale *node) {
     gMatStackIndex++;
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
+    geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
+}
+
+/**
+ * Process a scaling node. A transformation matrix based on the node's
+ * scale is created and pushed on both the float and fixed point matrix stacks.
+ * For the rest it acts as a normal display list node.
+ */
+static void geo_process_scale(struct GraphNodeScale *node) {
+    geo_push_scale(node);
     if (node->node.children != NULL) {
         geo_process_node_and_siblings(node->node.children);
     }
@@ -460,6 +776,7 @@ static void geo_process_billboard(struct GraphNodeBillboard *node) {
 
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
+    geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
@@ -539,6 +856,51 @@ static void geo_process_background(struct GraphNodeBackground *node) {
     }
 }
 
+#ifdef ANIM_POSE_CACHE
+/**
+ * Read the current animated part's translation, unscaled and 0 on the axes
+ * the animation type doesn't animate, and its rotation, advancing the
+ * animation globals past them the same way geo_process_animated_part does.
+ */
+static void geo_decode_animated_part(Vec3s translation, Vec3s rotation) {
+    vec3s_copy(translation, gVec3sZero);
+    vec3s_copy(rotation, gVec3sZero);
+    if (gCurAnimType == ANIM_TYPE_TRANSLATION) {
+        translation[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        translation[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        translation[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurAnimType == ANIM_TYPE_LATERAL_TRANSLATION) {
+        translation[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimAttribute += 2;
+        translation[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurAnimType == ANIM_TYPE_VERTICAL_TRANSLATION) {
+        gCurrAnimAttribute += 2;
+        translation[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimAttribute += 2;
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurAnimType == ANIM_TYPE_NO_TRANSLATION) {
+        gCurrAnimAttribute += 6;
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    }
+
+    if (gCurAnimType == ANIM_TYPE_ROTATION) {
+        rotation[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        rotation[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        rotation[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    }
+}
+
+/**
+ * Make every cached pose miss, for when animation data is loaded over an
+ * older animation.
+ */
+void geo_invalidate_anim_poses(void) {
+    sAnimPoseCacheGeneration++;
+}
+#endif
+
 /**
  * Render an animated part. The current animation state is not part of the node
  * but set in global variables. If an animated part is skipped, everything afterwards desyncs.
@@ -548,9 +910,42 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
     Vec3s rotation;
     Vec3f translation;
     Mtx *matrixPtr = alloc_display_list(sizeof(*matrixPtr));
+#ifdef ANIM_POSE_CACHE
+    struct AnimPoseCacheEntry *entry;
+#endif
 
     vec3s_copy(rotation, gVec3sZero);
     vec3f_set(translation, node->translation[0], node->translation[1], node->translation[2]);
+#ifdef ANIM_POSE_CACHE
+    if (gCurAnimType != ANIM_TYPE_NONE) {
+        entry = &sAnimPoseCache[(((uintptr_t) gCurrAnimAttribute >> 2) ^ (gCurrAnimFrame * 37))
+                                % ANIM_POSE_CACHE_SIZE];
+        if (entry->generation == sAnimPoseCacheGeneration && entry->data == gCurAnimData
+            && entry->attribute == gCurrAnimAttribute && entry->frame == gCurrAnimFrame
+            && entry->animType == gCurAnimType) {
+            gCurrAnimAttribute = entry->attributeEnd;
+            gCurAnimType = ANIM_TYPE_ROTATION;
+#ifdef ANIM_BENCHMARK
+            sAnimBenchmark.cachedBones++;
+#endif
+        } else {
+            entry->generation = sAnimPoseCacheGeneration;
+            entry->data = gCurAnimData;
+            entry->attribute = gCurrAnimAttribute;
+            entry->frame = gCurrAnimFrame;
+            entry->animType = gCurAnimType;
+            geo_decode_animated_part(entry->translation, entry->rotation);
+            entry->attributeEnd = gCurrAnimAttribute;
+            mtxf_rotate_xyz_and_translate(entry->matrix, gVec3fZero, entry->rotation);
+        }
+        mtxf_copy(matrix, entry->matrix);
+        matrix[3][0] = translation[0] + entry->translation[0] * gCurAnimTranslationMultiplier;
+        matrix[3][1] = translation[1] + entry->translation[1] * gCurAnimTranslationMultiplier;
+        matrix[3][2] = translation[2] + entry->translation[2] * gCurAnimTranslationMultiplier;
+    } else {
+        mtxf_rotate_xyz_and_translate(matrix, translation, rotation);
+    }
+#else
     if (gCurAnimType == ANIM_TYPE_TRANSLATION) {
         translation[0] += gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
                           * gCurAnimTranslationMultiplier;
@@ -590,10 +985,15 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
         rotation[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
     }
     mtxf_rotate_xyz_and_translate(matrix, translation, rotation);
+#endif
+#ifdef ANIM_BENCHMARK
+    sAnimBenchmark.bones++;
+#endif
     mtxf_mul(gMatStack[gMatStackIndex + 1], matrix, gMatStack[gMatStackIndex]);
     gMatStackIndex++;
     mtxf_to_mtx(matrixPtr, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = matrixPtr;
+    geo_interp_record(node, matrixPtr, gMatStack[gMatStackIndex]);
     if (node->displayList != NULL) {
         geo_append_display_list(node->displayList, node->node.flags >> 8);
     }
@@ -699,6 +1099,7 @@ static void geo_process_shadow(struct GraphNodeShadow *node) {
             mtxf_mul(gMatStack[gMatStackIndex], mtxf, *gCurGraphNodeCamera->matrixPtr);
             mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
             gMatStackFixed[gMatStackIndex] = mtx;
+            geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
             if (gShadowAboveWaterOrLava == 1) {
                 geo_append_display_list((void *) VIRTUAL_TO_PHYSICAL(shadowList), 4);
             } else if (gMarioOnIceOrCarpet == 1) {
@@ -838,6 +1239,7 @@ static void geo_process_object(struct Object *node) {
 
             mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
             gMatStackFixed[gMatStackIndex] = mtx;
+            geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
             if (node->header.gfx.sharedChild != NULL) {
                 gCurGraphNodeObject = (struct GraphNodeObject *) node;
                 node->header.gfx.sharedChild->parent = &node->header.gfx.node;
@@ -909,6 +1311,7 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gMatStackIndex++;
         mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
         gMatStackFixed[gMatStackIndex] = mtx;
+        geo_interp_record(node, mtx, gMatStack[gMatStackIndex]);
         gGeoTempState.type = gCurAnimType;
         gGeoTempState.enabled = gCurAnimEnabled;
         gGeoTempState.frame = gCurrAnimFrame;
@@ -946,6 +1349,85 @@ void geo_try_process_children(struct GraphNode *node) {
     }
 }
 
+/**
+ * Process a single node, without its siblings.
+ */
+static void geo_process_node(struct GraphNode *curGraphNode) {
+    if (curGraphNode->flags & GRAPH_RENDER_ACTIVE) {
+        if (curGraphNode->flags & GRAPH_RENDER_CHILDREN_FIRST) {
+            geo_try_process_children(curGraphNode);
+        } else {
+            switch (curGraphNode->type) {
+                case GRAPH_NODE_TYPE_ORTHO_PROJECTION:
+                    geo_process_ortho_projection((struct GraphNodeOrthoProjection *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_PERSPECTIVE:
+                    geo_process_perspective((struct GraphNodePerspective *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_MASTER_LIST:
+                    geo_process_master_list((struct GraphNodeMasterList *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_LEVEL_OF_DETAIL:
+                    geo_process_level_of_detail((struct GraphNodeLevelOfDetail *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_SWITCH_CASE:
+                    geo_process_switch((struct GraphNodeSwitchCase *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_CAMERA:
+                    geo_process_camera((struct GraphNodeCamera *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+                    geo_process_translation_rotation(
+                        (struct GraphNodeTranslationRotation *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_TRANSLATION:
+                    geo_process_translation((struct GraphNodeTranslation *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_ROTATION:
+                    geo_process_rotation((struct GraphNodeRotation *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_OBJECT:
+                    geo_process_object((struct Object *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_ANIMATED_PART:
+                    geo_process_animated_part((struct GraphNodeAnimatedPart *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_BILLBOARD:
+                    geo_process_billboard((struct GraphNodeBillboard *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_DISPLAY_LIST:
+                    geo_process_display_list((struct GraphNodeDisplayList *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_SCALE:
+                    geo_process_scale((struct GraphNodeScale *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_SHADOW:
+                    geo_process_shadow((struct GraphNodeShadow *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_OBJECT_PARENT:
+                    geo_process_object_parent((struct GraphNodeObjectParent *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_GENERATED_LIST:
+                    geo_process_generated_list((struct GraphNodeGenerated *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_BACKGROUND:
+                    geo_process_background((struct GraphNodeBackground *) curGraphNode);
+                    break;
+                case GRAPH_NODE_TYPE_HELD_OBJ:
+                    geo_process_held_object((struct GraphNodeHeldObject *) curGraphNode);
+                    break;
+                default:
+                    geo_try_process_children((struct GraphNode *) curGraphNode);
+                    break;
+            }
+        }
+    } else {
+        if (curGraphNode->type == GRAPH_NODE_TYPE_OBJECT) {
+            ((struct GraphNodeObject *) curGraphNode)->throwMatrix = NULL;
+        }
+    }
+}
+
 /**
  * Process a generic geo node and its siblings.
  * The first argument is the start node, and all its siblings will
@@ -963,82 +1445,160 @@ void geo_process_node_and_siblings(struct GraphNode *firstNode) {
     }
 
     do {
-        if (curGraphNode->flags & GRAPH_RENDER_ACTIVE) {
-            if (curGraphNode->flags & GRAPH_RENDER_CHILDREN_FIRST) {
-                geo_try_process_children(curGraphNode);
-            } else {
-                switch (curGraphNode->type) {
-                    case GRAPH_NODE_TYPE_ORTHO_PROJECTION:
-                        geo_process_ortho_projection((struct GraphNodeOrthoProjection *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_PERSPECTIVE:
-                        geo_process_perspective((struct GraphNodePerspective *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_MASTER_LIST:
-                        geo_process_master_list((struct GraphNodeMasterList *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_LEVEL_OF_DETAIL:
-                        geo_process_level_of_detail((struct GraphNodeLevelOfDetail *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_SWITCH_CASE:
-                        geo_process_switch((struct GraphNodeSwitchCase *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_CAMERA:
-                        geo_process_camera((struct GraphNodeCamera *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
-                        geo_process_translation_rotation(
-                            (struct GraphNodeTranslationRotation *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_TRANSLATION:
-                        geo_process_translation((struct GraphNodeTranslation *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_ROTATION:
-                        geo_process_rotation((struct GraphNodeRotation *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_OBJECT:
-                        geo_process_object((struct Object *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_ANIMATED_PART:
-                        geo_process_animated_part((struct GraphNodeAnimatedPart *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_BILLBOARD:
-                        geo_process_billboard((struct GraphNodeBillboard *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_DISPLAY_LIST:
-                        geo_process_display_list((struct GraphNodeDisplayList *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_SCALE:
-                        geo_process_scale((struct GraphNodeScale *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_SHADOW:
-                        geo_process_shadow((struct GraphNodeShadow *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_OBJECT_PARENT:
-                        geo_process_object_parent((struct GraphNodeObjectParent *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_GENERATED_LIST:
-                        geo_process_generated_list((struct GraphNodeGenerated *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_BACKGROUND:
-                        geo_process_background((struct GraphNodeBackground *) curGraphNode);
-                        break;
-                    case GRAPH_NODE_TYPE_HELD_OBJ:
-                        geo_process_held_object((struct GraphNodeHeldObject *) curGraphNode);
-                        break;
-                    default:
-                        geo_try_process_children((struct GraphNode *) curGraphNode);
-                        break;
-                }
+        geo_process_node(curGraphNode);
+    } while (iterateChildren && (curGraphNode = curGraphNode->next) != firstNode);
+}
+
+#ifdef FLAT_RENDER_LIST
+/**
+ * Append the commands for firstNode and its siblings to sRenderListCmds.
+ * Display list and fixed transformation nodes become commands of their own,
+ * with their children inlined after them; anything else is left to
+ * geo_process_node. Returns FALSE if the list ran out of space.
+ */
+static s32 geo_compile_render_list(struct GraphNode *firstNode) {
+    struct GraphNode *curGraphNode = firstNode;
+    struct RenderListCmd *cmd;
+    s32 index;
+
+    do {
+        if (sRenderListCmdsUsed >= RENDER_LIST_CAPACITY) {
+            return FALSE;
+        }
+
+        index = sRenderListCmdsUsed++;
+        cmd = &sRenderListCmds[index];
+        cmd->node = curGraphNode;
+        cmd->type = RENDER_CMD_NODE;
+
+        if (!(curGraphNode->flags & GRAPH_RENDER_CHILDREN_FIRST)) {
+            switch (curGraphNode->type) {
+                case GRAPH_NODE_TYPE_DISPLAY_LIST:
+                    cmd->type = RENDER_CMD_DISPLAY_LIST;
+                    break;
+                case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+                case GRAPH_NODE_TYPE_TRANSLATION:
+                case GRAPH_NODE_TYPE_ROTATION:
+                case GRAPH_NODE_TYPE_SCALE:
+                    cmd->type = RENDER_CMD_PUSH;
+                    break;
+            }
+        }
+
+        if (cmd->type != RENDER_CMD_NODE && curGraphNode->children != NULL
+            && !geo_compile_render_list(curGraphNode->children)) {
+            return FALSE;
+        }
+        if (cmd->type == RENDER_CMD_PUSH) {
+            if (sRenderListCmdsUsed >= RENDER_LIST_CAPACITY) {
+                return FALSE;
             }
+            sRenderListCmds[sRenderListCmdsUsed].node = curGraphNode;
+            sRenderListCmds[sRenderListCmdsUsed].type = RENDER_CMD_POP;
+            sRenderListCmdsUsed++;
+        }
+        sRenderListCmds[index].end = sRenderListCmdsUsed;
+    } while ((curGraphNode = curGraphNode->next) != firstNode);
+
+    return TRUE;
+}
+
+/**
+ * Run the render list compiled for a camera's children. Every node's
+ * GRAPH_RENDER_ACTIVE flag is checked when its command is reached, like the
+ * recursive traversal does, and an inactive node's inlined children are skipped.
+ */
+static void geo_process_render_list(struct RenderListCmd *cmds, s32 count) {
+    struct RenderListCmd *cmd = cmds;
+    struct RenderListCmd *end = cmds + count;
+    struct GraphNode *node;
+
+    while (cmd < end) {
+        node = cmd->node;
+
+        if (cmd->type == RENDER_CMD_POP) {
+            gMatStackIndex--;
+        } else if (cmd->type == RENDER_CMD_NODE) {
+            geo_process_node(node);
+        } else if (!(node->flags & GRAPH_RENDER_ACTIVE)) {
+            cmd = cmds + cmd->end;
+            continue;
         } else {
-            if (curGraphNode->type == GRAPH_NODE_TYPE_OBJECT) {
-                ((struct GraphNodeObject *) curGraphNode)->throwMatrix = NULL;
+            switch (cmd->type) {
+                case RENDER_CMD_DISPLAY_LIST:
+                    if (((struct GraphNodeDisplayList *) node)->displayList != NULL) {
+                        geo_append_display_list(((struct GraphNodeDisplayList *) node)->displayList,
+                                                node->flags >> 8);
+                    }
+                    break;
+                case RENDER_CMD_PUSH:
+                    switch (node->type) {
+                        case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+                            geo_push_translation_rotation((struct GraphNodeTranslationRotation *) node);
+                            break;
+                        case GRAPH_NODE_TYPE_TRANSLATION:
+                            geo_push_translation((struct GraphNodeTranslation *) node);
+                            break;
+                        case GRAPH_NODE_TYPE_ROTATION:
+                            geo_push_rotation((struct GraphNodeRotation *) node);
+                            break;
+                        case GRAPH_NODE_TYPE_SCALE:
+                            geo_push_scale((struct GraphNodeScale *) node);
+                            break;
+                    }
+                    break;
             }
         }
-    } while (iterateChildren && (curGraphNode = curGraphNode->next) != firstNode);
+        cmd++;
+    }
 }
 
+/**
+ * Process the children of a camera node from its render list, compiling the
+ * list the first time the camera is drawn. Falls back to the recursive
+ * traversal if the list does not fit.
+ */
+static void geo_process_camera_children(struct GraphNodeCamera *node) {
+    struct GraphNode *children = node->fnNode.node.children;
+    s32 i;
+
+    for (i = 0; i < sNumRenderLists; i++) {
+        if (sRenderLists[i].camera == node && sRenderLists[i].children == children) {
+            break;
+        }
+    }
+
+    if (i == sNumRenderLists && sNumRenderLists < RENDER_LIST_CAMERAS) {
+        s32 start = sRenderListCmdsUsed;
+
+        if (geo_compile_render_list(children)) {
+            sRenderLists[i].camera = node;
+            sRenderLists[i].children = children;
+            sRenderLists[i].start = start;
+            sRenderLists[i].count = sRenderListCmdsUsed - start;
+            sNumRenderLists++;
+        } else {
+            sRenderListCmdsUsed = start;
+        }
+    }
+
+    if (i < sNumRenderLists) {
+        geo_process_render_list(&sRenderListCmds[sRenderLists[i].start], sRenderLists[i].count);
+    } else {
+        geo_process_node_and_siblings(children);
+    }
+}
+
+/**
+ * Forget every compiled render list, for when the graph nodes they were built
+ * from are freed.
+ */
+void geo_clear_render_lists(void) {
+    sNumRenderLists = 0;
+    sRenderListCmdsUsed = 0;
+}
+#endif
+
 /**
  * Process a root node. This is the entry point for processing the scene graph.
  * The root node itself sets up the viewport, then all its children are processed
@@ -1050,6 +1610,9 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
     if (node->node.flags & GRAPH_RENDER_ACTIVE) {
         Mtx *initialMatrix;
         Vp *viewport = alloc_display_list(sizeof(*viewport));
+#ifdef ANIM_BENCHMARK
+        OSTime benchmarkStart = osGetTime();
+#endif
 
         gDisplayListHeap = alloc_only_pool_init(main_pool_available() - sizeof(struct AllocOnlyPool),
                                                 MEMORY_POOL_LEFT);
@@ -1080,6 +1643,19 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
             geo_process_node_and_siblings(node->node.children);
         }
         gCurGraphNodeRoot = NULL;
+#ifdef ANIM_BENCHMARK
+        sAnimBenchmark.time += osGetTime() - benchmarkStart;
+
+        if (++sAnimBenchmark.frames == ANIM_BENCHMARK_FRAMES) {
+            // osGetTime ticks in microseconds
+            printf("ANIM: %u bone matrices (%u cached) in %u us of graph processing, %u bones/ms\n",
+                   (unsigned) sAnimBenchmark.bones, (unsigned) sAnimBenchmark.cachedBones,
+                   (unsigned) sAnimBenchmark.time,
+                   sAnimBenchmark.time != 0
+                       ? (unsigned) (sAnimBenchmark.bones * 1000ULL / sAnimBenchmark.time) : 0);
+            bzero(&sAnimBenchmark, sizeof(sAnimBenchmark));
+        }
+#endif
         if (gShowDebugText) {
             print_text_fmt_int(180, 36, "MEM %d",
                                gDisplayListHeap->totalSpace - gDisplayListHeap->usedSpace);
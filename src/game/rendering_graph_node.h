@@ -29,5 +29,16 @@ extern u16 gAreaUpdateCounter;
 
 void geo_process_node_and_siblings(struct GraphNode *firstNode);
 void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor);
+#ifdef FLAT_RENDER_LIST
+void geo_clear_render_lists(void);
+#endif
+#ifdef ANIM_POSE_CACHE
+void geo_invalidate_anim_poses(void);
+#endif
+
+#ifdef HIGH_FPS
+void geo_interp_patch(f32 t);
+void geo_interp_end_tick(void);
+#endif
 
 #endif // RENDERING_GRAPH_NODE_H
@@ -4,6 +4,7 @@
 
 #include "engine/math_util.h"
 #include "engine/surface_collision.h"
+#include "engine/surface_load.h"
 #include "geo_misc.h"
 #include "level_table.h"
 #include "memory.h"
@@ -13,7 +14,16 @@
 #include "shadow.h"
 #include "sm64.h"
 
-#ifndef TARGET_N64
+#ifdef SHADOW_BENCHMARK
+#include <ultra64.h>
+#include <stdio.h>
+#include "game_init.h"
+#endif
+
+#ifdef SHADOW_FLOOR_CACHE
+// Queries below the shadow's center reuse the floor found there
+#define find_floor_height_and_data find_shadow_floor_height_and_data
+#elif !defined(TARGET_N64)
 // Avoid Z-fighting
 #define find_floor_height_and_data 0.4 + find_floor_height_and_data
 #endif
@@ -111,6 +121,205 @@ s8 gMarioOnIceOrCarpet;
 s8 sMarioOnFlyingCarpet;
 s16 sSurfaceTypeBelowShadow;
 
+#ifdef SHADOW_BENCHMARK
+/**
+ * Shadows drawn, the floor and water queries made for them and the time spent
+ * building them, printed every SHADOW_BENCHMARK_FRAMES frames with shadows.
+ */
+#define SHADOW_BENCHMARK_FRAMES 300
+
+static struct {
+    OSTime time;
+    u32 shadows;
+    u32 floorQueries;
+    u32 waterQueries;
+    u32 planeVertices;
+    u32 lastTimer;
+    u32 frames;
+} sShadowBenchmark;
+#endif
+
+#ifdef SHADOW_FLOOR_CACHE
+/**
+ * The floor below the shadow's center. It's found once by
+ * create_shadow_below_xyz, and the functions it dispatches to query the same
+ * point again.
+ */
+static struct {
+    f32 x, y, z;
+    f32 height;
+    struct Surface *floor;
+} sShadowCenterFloor;
+
+static struct FloorGeometry sShadowFloorGeo;
+
+/**
+ * Whether the center floor is the only floor in reach of the current 9 vertex
+ * shadow, so that its vertices can be put on that floor's plane.
+ */
+static s8 sShadowOnSingleFloor;
+
+static f32 find_shadow_center_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+    sShadowCenterFloor.x = xPos;
+    sShadowCenterFloor.y = yPos;
+    sShadowCenterFloor.z = zPos;
+    sShadowCenterFloor.height = find_floor(xPos, yPos, zPos, &sShadowCenterFloor.floor);
+
+    *pfloor = sShadowCenterFloor.floor;
+    return sShadowCenterFloor.height;
+}
+
+/**
+ * Same as find_floor_height_and_data, except that a query at the shadow's
+ * center is answered from the floor already found there.
+ */
+static f32 find_shadow_floor_height_and_data(f32 xPos, f32 yPos, f32 zPos,
+                                             struct FloorGeometry **floorGeo) {
+    struct Surface *floor;
+    f32 floorHeight;
+
+    if (xPos == sShadowCenterFloor.x && yPos == sShadowCenterFloor.y && zPos == sShadowCenterFloor.z) {
+        floor = sShadowCenterFloor.floor;
+        floorHeight = sShadowCenterFloor.height;
+    } else {
+        floorHeight = find_floor(xPos, yPos, zPos, &floor);
+    }
+
+    *floorGeo = NULL;
+
+    if (floor != NULL) {
+        sShadowFloorGeo.normalX = floor->normal.x;
+        sShadowFloorGeo.normalY = floor->normal.y;
+        sShadowFloorGeo.normalZ = floor->normal.z;
+        sShadowFloorGeo.originOffset = floor->originOffset;
+
+        *floorGeo = &sShadowFloorGeo;
+    }
+
+#ifndef TARGET_N64
+    // Avoid Z-fighting
+    return 0.4 + floorHeight;
+#else
+    return floorHeight;
+#endif
+}
+
+/**
+ * Check whether the center floor is the only floor below a 9 vertex shadow.
+ * find_floor returns the first floor in a cell's list that holds the point,
+ * so any other floor overlapping the shadow could be the one found below one
+ * of its vertices instead.
+ */
+static void check_shadow_single_floor(struct Shadow *s) {
+    struct Surface *floor = sShadowCenterFloor.floor;
+    struct SurfaceNode *node;
+    struct Surface *surf;
+    // The vertices are at most sqrt(2) / 2 * shadowScale away from the center.
+    f32 radius = s->shadowScale * 0.75f + 1.0f;
+    s32 minX = s->parentX - radius;
+    s32 maxX = s->parentX + radius;
+    s32 minZ = s->parentZ - radius;
+    s32 maxZ = s->parentZ + radius;
+    s32 cellX, cellZ;
+    s32 i;
+
+    sShadowOnSingleFloor = FALSE;
+
+    if (floor == NULL || floor->type == SURFACE_INTANGIBLE || s->parentX != sShadowCenterFloor.x
+        || s->parentY != sShadowCenterFloor.y || s->parentZ != sShadowCenterFloor.z) {
+        return;
+    }
+    if (minX <= -LEVEL_BOUNDARY_MAX || maxX >= LEVEL_BOUNDARY_MAX || minZ <= -LEVEL_BOUNDARY_MAX
+        || maxZ >= LEVEL_BOUNDARY_MAX) {
+        return;
+    }
+
+    // Every vertex has to be looked up in the same cell as the center.
+    cellX = (minX + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    cellZ = (minZ + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    if (cellX != (maxX + LEVEL_BOUNDARY_MAX) / CELL_SIZE || cellZ != (maxZ + LEVEL_BOUNDARY_MAX) / CELL_SIZE) {
+        return;
+    }
+
+    for (i = 0; i < 2; i++) {
+        if (i == 0) {
+            node = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
+        } else {
+            node = gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
+        }
+
+        for (; node != NULL; node = node->next) {
+            surf = node->surface;
+            if (surf == floor) {
+                continue;
+            }
+
+            if ((surf->vertex1[0] < minX && surf->vertex2[0] < minX && surf->vertex3[0] < minX)
+                || (surf->vertex1[0] > maxX && surf->vertex2[0] > maxX && surf->vertex3[0] > maxX)
+                || (surf->vertex1[2] < minZ && surf->vertex2[2] < minZ && surf->vertex3[2] < minZ)
+                || (surf->vertex1[2] > maxZ && surf->vertex2[2] > maxZ && surf->vertex3[2] > maxZ)) {
+                continue;
+            }
+            return;
+        }
+    }
+
+    sShadowOnSingleFloor = TRUE;
+}
+
+/**
+ * Put a 9 vertex shadow's vertex on the center floor, with the height
+ * find_floor would return for it. Return FALSE if the vertex isn't over that
+ * floor, or there could be another floor below it, so it has to be queried.
+ */
+static s32 find_shadow_vertex_floor_height(struct Shadow *s, f32 xPos, f32 zPos, f32 *height) {
+    struct Surface *surf = sShadowCenterFloor.floor;
+    s32 x = (s16) xPos;
+    s32 y = (s16) s->parentY;
+    s32 z = (s16) zPos;
+    s32 x1, z1, x2, z2, x3, z3;
+    f32 floorHeight;
+
+    if (!sShadowOnSingleFloor) {
+        return FALSE;
+    }
+
+    // Same bounds check as find_floor_from_list.
+    x1 = surf->vertex1[0];
+    z1 = surf->vertex1[2];
+    x2 = surf->vertex2[0];
+    z2 = surf->vertex2[2];
+    x3 = surf->vertex3[0];
+    z3 = surf->vertex3[2];
+
+    if ((z1 - z) * (x2 - x1) - (x1 - x) * (z2 - z1) < 0) {
+        return FALSE;
+    }
+    if ((z2 - z) * (x3 - x2) - (x2 - x) * (z3 - z2) < 0) {
+        return FALSE;
+    }
+    if ((z3 - z) * (x1 - x3) - (x3 - x) * (z1 - z3) < 0) {
+        return FALSE;
+    }
+
+    floorHeight = -(x * surf->normal.x + surf->normal.z * z + surf->originOffset) / surf->normal.y;
+    if (y - (floorHeight + -78.0f) < 0.0f || floorHeight <= -11000.0f) {
+        return FALSE;
+    }
+
+#ifdef SHADOW_BENCHMARK
+    sShadowBenchmark.planeVertices++;
+#endif
+#ifndef TARGET_N64
+    // Avoid Z-fighting
+    *height = 0.4 + floorHeight;
+#else
+    *height = floorHeight;
+#endif
+    return TRUE;
+}
+#endif
+
 /**
  * Let (oldZ, oldX) be the relative coordinates of a point on a rectangle,
  * assumed to be centered at the origin on the standard SM64 X-Z plane. This
@@ -184,6 +393,9 @@ u8 dim_shadow_with_distance(u8 solidity, f32 distFromFloor) {
  */
 f32 get_water_level_below_shadow(struct Shadow *s) {
     f32 waterLevel = find_water_level(s->parentX, s->parentZ);
+#ifdef SHADOW_BENCHMARK
+    sShadowBenchmark.waterQueries++;
+#endif
     if (waterLevel < -10000.0) {
         return 0;
     } else if (s->parentY >= waterLevel && s->floorHeight <= waterLevel) {
@@ -390,6 +602,11 @@ void calculate_vertex_xyz(s8 index, struct Shadow s, f32 *xPosVtx, f32 *yPosVtx,
                 // Clamp this vertex's y-position to that of the floor directly
                 // below it, which may differ from the floor below the center
                 // vertex.
+#ifdef SHADOW_FLOOR_CACHE
+                if (find_shadow_vertex_floor_height(&s, *xPosVtx, *zPosVtx, yPosVtx)) {
+                    break;
+                }
+#endif
                 *yPosVtx = find_floor_height_and_data(*xPosVtx, s.parentY, *zPosVtx, &dummy);
                 break;
             case SHADOW_WITH_4_VERTS:
@@ -619,6 +836,9 @@ Gfx *create_shadow_player(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 soli
 
     correct_lava_shadow_height(&shadow);
 
+#ifdef SHADOW_FLOOR_CACHE
+    check_shadow_single_floor(&shadow);
+#endif
     for (i = 0; i < 9; i++) {
         make_shadow_vertex(verts, i, shadow, SHADOW_WITH_9_VERTS);
     }
@@ -645,6 +865,9 @@ Gfx *create_shadow_circle_9_verts(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
     if (verts == NULL || displayList == NULL) {
         return 0;
     }
+#ifdef SHADOW_FLOOR_CACHE
+    check_shadow_single_floor(&shadow);
+#endif
     for (i = 0; i < 9; i++) {
         make_shadow_vertex(verts, i, shadow, SHADOW_WITH_9_VERTS);
     }
@@ -755,6 +978,9 @@ s32 get_shadow_height_solidity(f32 xPos, f32 yPos, f32 zPos, f32 *shadowHeight,
         return 1;
     } else {
         waterLevel = find_water_level(xPos, zPos);
+#ifdef SHADOW_BENCHMARK
+        sShadowBenchmark.waterQueries++;
+#endif
 
         if (waterLevel < -10000.0) {
             // Dead if-statement. There may have been an assert here.
@@ -835,11 +1061,50 @@ Gfx *create_shadow_hardcoded_rectangle(f32 xPos, f32 yPos, f32 zPos, UNUSED s16
  * Create a shadow at the absolute position given, with the given parameters.
  * Return a pointer to the display list representing the shadow.
  */
+#ifdef SHADOW_BENCHMARK
+static Gfx *create_shadow_below_xyz_inner(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
+                                          u8 shadowSolidity, s8 shadowType);
+
 Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 shadowSolidity,
                              s8 shadowType) {
+    s16 floorQueries = gNumCalls.floor;
+    OSTime start;
+    Gfx *displayList;
+
+    if (gGlobalTimer != sShadowBenchmark.lastTimer) {
+        if (++sShadowBenchmark.frames == SHADOW_BENCHMARK_FRAMES) {
+            // osGetTime ticks in microseconds
+            printf("SHADOW: %u shadows, %u floor and %u water queries, %u vertices on the center "
+                   "floor in %u us\n",
+                   (unsigned) sShadowBenchmark.shadows, (unsigned) sShadowBenchmark.floorQueries,
+                   (unsigned) sShadowBenchmark.waterQueries, (unsigned) sShadowBenchmark.planeVertices,
+                   (unsigned) sShadowBenchmark.time);
+            bzero(&sShadowBenchmark, sizeof(sShadowBenchmark));
+        }
+        sShadowBenchmark.lastTimer = gGlobalTimer;
+    }
+
+    start = osGetTime();
+    displayList = create_shadow_below_xyz_inner(xPos, yPos, zPos, shadowScale, shadowSolidity, shadowType);
+    sShadowBenchmark.time += osGetTime() - start;
+    sShadowBenchmark.shadows++;
+    sShadowBenchmark.floorQueries += (s16)(gNumCalls.floor - floorQueries);
+    return displayList;
+}
+
+static Gfx *create_shadow_below_xyz_inner(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
+                                          u8 shadowSolidity, s8 shadowType) {
+#else
+Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 shadowSolidity,
+                             s8 shadowType) {
+#endif
     Gfx *displayList = NULL;
     struct Surface *pfloor;
+#ifdef SHADOW_FLOOR_CACHE
+    find_shadow_center_floor(xPos, yPos, zPos, &pfloor);
+#else
     find_floor(xPos, yPos, zPos, &pfloor);
+#endif
 
     gShadowAboveWaterOrLava = FALSE;
     gMarioOnIceOrCarpet = 0;
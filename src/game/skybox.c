@@ -14,6 +14,25 @@
 #define BETTER_SKYBOX_POSITION_PRECISION
 #endif
 
+#ifdef SKYBOX_BENCHMARK
+#include <ultra64.h>
+#include <stdio.h>
+
+/**
+ * Skybox tiles drawn, and the texture and vertex loads used to draw them,
+ * printed every SKYBOX_BENCHMARK_FRAMES frames.
+ */
+#define SKYBOX_BENCHMARK_FRAMES 300
+
+static struct {
+    u32 tiles;
+    u32 textureLoads;
+    u32 vertexLoads;
+    u32 commands;
+    u32 frames;
+} sSkyboxBenchmark;
+#endif
+
 /**
  * @file skybox.c
  *
@@ -221,6 +240,23 @@ static int get_top_left_tile_idx(s8 player) {
     return tileRow * SKYBOX_COLS + tileCol;
 }
 
+/**
+ * Writes the vertices of a skybox tile to `verts`. See make_skybox_rect.
+ */
+static void write_skybox_rect(Vtx *verts, s32 tileIndex, s8 colorIndex) {
+    s16 x = tileIndex % SKYBOX_COLS * SKYBOX_TILE_WIDTH;
+    s16 y = SKYBOX_HEIGHT - tileIndex / SKYBOX_COLS * SKYBOX_TILE_HEIGHT;
+
+    make_vertex(verts, 0, x, y, -1, 0, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                sSkyboxColors[colorIndex][2], 255);
+    make_vertex(verts, 1, x, y - SKYBOX_TILE_HEIGHT, -1, 0, 31 << 5, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                sSkyboxColors[colorIndex][2], 255);
+    make_vertex(verts, 2, x + SKYBOX_TILE_WIDTH, y - SKYBOX_TILE_HEIGHT, -1, 31 << 5, 31 << 5, sSkyboxColors[colorIndex][0],
+                sSkyboxColors[colorIndex][1], sSkyboxColors[colorIndex][2], 255);
+    make_vertex(verts, 3, x + SKYBOX_TILE_WIDTH, y, -1, 31 << 5, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                sSkyboxColors[colorIndex][2], 255);
+}
+
 /**
  * Generates vertices for the skybox tile.
  *
@@ -230,23 +266,74 @@ static int get_top_left_tile_idx(s8 player) {
  */
 Vtx *make_skybox_rect(s32 tileIndex, s8 colorIndex) {
     Vtx *verts = alloc_display_list(4 * sizeof(*verts));
-    s16 x = tileIndex % SKYBOX_COLS * SKYBOX_TILE_WIDTH;
-    s16 y = SKYBOX_HEIGHT - tileIndex / SKYBOX_COLS * SKYBOX_TILE_HEIGHT;
 
     if (verts != NULL) {
-        make_vertex(verts, 0, x, y, -1, 0, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
-                    sSkyboxColors[colorIndex][2], 255);
-        make_vertex(verts, 1, x, y - SKYBOX_TILE_HEIGHT, -1, 0, 31 << 5, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
-                    sSkyboxColors[colorIndex][2], 255);
-        make_vertex(verts, 2, x + SKYBOX_TILE_WIDTH, y - SKYBOX_TILE_HEIGHT, -1, 31 << 5, 31 << 5, sSkyboxColors[colorIndex][0],
-                    sSkyboxColors[colorIndex][1], sSkyboxColors[colorIndex][2], 255);
-        make_vertex(verts, 3, x + SKYBOX_TILE_WIDTH, y, -1, 31 << 5, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
-                    sSkyboxColors[colorIndex][2], 255);
+        write_skybox_rect(verts, tileIndex, colorIndex);
     } else {
     }
     return verts;
 }
 
+#ifdef SKYBOX_BATCH
+/**
+ * The number of tiles the grid can reach. calculate_skybox_scaled_y and calculate_skybox_scaled_x
+ * let the upper left tile go as far as row SKYBOX_ROWS - 2 and column SKYBOX_COLS - 2, so the grid's
+ * last rows and its last tile run past the tilemap. Those are given vertices too, at the positions
+ * make_skybox_rect would give them.
+ */
+#define SKYBOX_GRID_TILES ((SKYBOX_ROWS - 2) * SKYBOX_COLS + (SKYBOX_COLS - 2) + 2 * SKYBOX_COLS + 2 + 1)
+
+/**
+ * The vertices of every tile, for both colors. They never change, so instead of making 9 tiles in
+ * the display list pool every frame, they are made once and each row of the grid is loaded with one
+ * gSPVertex. Tiles in a row have consecutive indices, so their vertices are next to each other.
+ */
+static Vtx sSkyboxTileVerts[ARRAY_COUNT(sSkyboxColors)][SKYBOX_GRID_TILES * 4];
+static u8 sSkyboxTileVertsMade[ARRAY_COUNT(sSkyboxColors)];
+
+/**
+ * Draws a 3x3 grid of 32x32 sections of the original skybox image, like the version below, but from
+ * the static tile vertices. Skyboxes point repeated tiles to the same texture, so a tile whose
+ * texture is already loaded is drawn without loading it again.
+ */
+void draw_skybox_tile_grid(Gfx **dlist, s8 background, s8 player, s8 colorIndex) {
+    SkyboxTexture *textures = segmented_to_virtual(sSkyboxTextures[background]);
+    Vtx *verts = sSkyboxTileVerts[colorIndex];
+    const u8 *loadedTexture = NULL;
+    s32 row;
+    s32 col;
+    s32 i;
+
+    if (!sSkyboxTileVertsMade[colorIndex]) {
+        for (i = 0; i < SKYBOX_GRID_TILES; i++) {
+            write_skybox_rect(&verts[i * 4], i, colorIndex);
+        }
+        sSkyboxTileVertsMade[colorIndex] = TRUE;
+    }
+
+    for (row = 0; row < 3; row++) {
+        s32 tileIndex = sSkyBoxInfo[player].upperLeftTile + row * SKYBOX_COLS;
+
+        gSPVertex((*dlist)++, VIRTUAL_TO_PHYSICAL(&verts[tileIndex * 4]), 3 * 4, 0);
+#ifdef SKYBOX_BENCHMARK
+        sSkyboxBenchmark.vertexLoads++;
+#endif
+        for (col = 0; col < 3; col++) {
+            const u8 *const texture = (*textures)[tileIndex + col];
+
+            if (texture != loadedTexture) {
+                gLoadBlockTexture((*dlist)++, 32, 32, G_IM_FMT_RGBA, texture);
+                loadedTexture = texture;
+#ifdef SKYBOX_BENCHMARK
+                sSkyboxBenchmark.textureLoads++;
+#endif
+            }
+            gSP2Triangles((*dlist)++, col * 4, col * 4 + 1, col * 4 + 2, 0x0,
+                                      col * 4, col * 4 + 2, col * 4 + 3, 0x0);
+        }
+    }
+}
+#else
 /**
  * Draws a 3x3 grid of 32x32 sections of the original skybox image.
  * The row and column are converted into an index into the skybox's tile list, which is then drawn in
@@ -266,9 +353,14 @@ void draw_skybox_tile_grid(Gfx **dlist, s8 background, s8 player, s8 colorIndex)
             gLoadBlockTexture((*dlist)++, 32, 32, G_IM_FMT_RGBA, texture);
             gSPVertex((*dlist)++, VIRTUAL_TO_PHYSICAL(vertices), 4, 0);
             gSPDisplayList((*dlist)++, dl_draw_quad_verts_0123);
+#ifdef SKYBOX_BENCHMARK
+            sSkyboxBenchmark.textureLoads++;
+            sSkyboxBenchmark.vertexLoads++;
+#endif
         }
     }
 }
+#endif
 
 void *create_skybox_ortho_matrix(s8 player) {
     f32 left = sSkyBoxInfo[player].scaledX;
@@ -318,6 +410,17 @@ Gfx *init_skybox_display_list(s8 player, s8 background, s8 colorIndex) {
         draw_skybox_tile_grid(&dlist, background, player, colorIndex);
         gSPDisplayList(dlist++, dl_skybox_end);
         gSPEndDisplayList(dlist);
+
+#ifdef SKYBOX_BENCHMARK
+        sSkyboxBenchmark.tiles += 3 * 3;
+        sSkyboxBenchmark.commands += dlist + 1 - (Gfx *) skybox;
+        if (++sSkyboxBenchmark.frames == SKYBOX_BENCHMARK_FRAMES) {
+            printf("SKYBOX: %u tiles with %u texture loads, %u vertex loads and %u commands\n",
+                   (unsigned) sSkyboxBenchmark.tiles, (unsigned) sSkyboxBenchmark.textureLoads,
+                   (unsigned) sSkyboxBenchmark.vertexLoads, (unsigned) sSkyboxBenchmark.commands);
+            bzero(&sSkyboxBenchmark, sizeof(sSkyboxBenchmark));
+        }
+#endif
     }
     return skybox;
 }
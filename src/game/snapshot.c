@@ -0,0 +1,403 @@
+#include <PR/ultratypes.h>
+#ifdef SNAPSHOTS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include "sm64.h"
+#include "area.h"
+#include "audio/external.h"
+#include "buffers/buffers.h"
+#include "camera.h"
+#include "engine/behavior_script.h"
+#include "engine/level_script.h"
+#include "engine/surface_load.h"
+#include "game_init.h"
+#include "ingame_menu.h"
+#include "level_update.h"
+#include "memory.h"
+#include "object_collision.h"
+#include "object_list_processor.h"
+#include "save_file.h"
+#include "snapshot.h"
+#include "sound_init.h"
+
+#ifdef SNAPSHOTS
+
+/**
+ * Snapshots of the mutable game state, for seeking back to an earlier frame
+ * and replaying from there. The state is the list of regions registered in
+ * snapshot_init: the object pool and lists, Mario, the camera, area and
+ * level script state, the RNG seed, the main pool (which holds the surface
+ * pools, object memory and graph nodes) and the audio sequence state.
+ *
+ * The regions are gathered into one buffer, XORed against the previous
+ * snapshot and stored as runs of unchanged words followed by runs of changed
+ * words. Every SNAPSHOT_KEYFRAME_INTERVAL snapshots the state is stored
+ * against zero instead, so a restore only has to apply the deltas since the
+ * last keyframe. When the ring is full, the oldest keyframe is dropped
+ * together with the deltas that depend on it.
+ */
+#define SNAPSHOT_MAX_REGIONS 128
+#define SNAPSHOT_RING_SIZE 128
+#define SNAPSHOT_KEYFRAME_INTERVAL 16
+
+struct SnapshotRegion {
+    void *ptr;
+    u32 size;
+};
+
+struct Snapshot {
+    u32 frame;
+    u8 isKeyframe;
+    u32 length; // in words
+    u32 *data;
+};
+
+static struct SnapshotRegion sSnapshotRegions[SNAPSHOT_MAX_REGIONS];
+static s32 sNumSnapshotRegions;
+static u32 sSnapshotWords;
+
+// State as of the newest snapshot in the ring, which the next one is stored against
+static u32 *sSnapshotState;
+static u32 *sSnapshotGather;
+static u32 *sSnapshotEncoded;
+
+static struct Snapshot sSnapshotRing[SNAPSHOT_RING_SIZE];
+static s32 sSnapshotOldest;
+static s32 sSnapshotCount;
+static s32 sSnapshotsSinceKeyframe;
+static u32 sSnapshotBytesStored;
+
+#define SNAPSHOT_RING_INDEX(n) ((sSnapshotOldest + (n)) % SNAPSHOT_RING_SIZE)
+
+void snapshot_add_region(void *ptr, u32 size) {
+    if (sNumSnapshotRegions >= SNAPSHOT_MAX_REGIONS || sSnapshotState != NULL) {
+        printf("SNAPSHOT: can't add a region now, %u bytes not captured\n", size);
+        return;
+    }
+
+    sSnapshotRegions[sNumSnapshotRegions].ptr = ptr;
+    sSnapshotRegions[sNumSnapshotRegions].size = size;
+    sNumSnapshotRegions++;
+    sSnapshotWords += (size + 3) / 4;
+}
+
+static void snapshot_free_oldest(void) {
+    struct Snapshot *snapshot = &sSnapshotRing[sSnapshotOldest];
+
+    sSnapshotBytesStored -= snapshot->length * sizeof(u32);
+    free(snapshot->data);
+    snapshot->data = NULL;
+    sSnapshotOldest = (sSnapshotOldest + 1) % SNAPSHOT_RING_SIZE;
+    sSnapshotCount--;
+}
+
+static void snapshot_free_newer_than(s32 n) {
+    struct Snapshot *snapshot;
+
+    while (sSnapshotCount > n + 1) {
+        snapshot = &sSnapshotRing[SNAPSHOT_RING_INDEX(sSnapshotCount - 1)];
+        sSnapshotBytesStored -= snapshot->length * sizeof(u32);
+        free(snapshot->data);
+        snapshot->data = NULL;
+        sSnapshotCount--;
+    }
+}
+
+/**
+ * Register the game state. Must be called after the main pool has been
+ * initialized, and again if it's reinitialized. More regions can be added
+ * until the first snapshot is taken.
+ */
+void snapshot_init(void) {
+    while (sSnapshotCount > 0) {
+        snapshot_free_oldest();
+    }
+    free(sSnapshotState);
+    free(sSnapshotGather);
+    free(sSnapshotEncoded);
+    sSnapshotState = NULL;
+
+    sNumSnapshotRegions = 0;
+    sSnapshotWords = 0;
+    sSnapshotsSinceKeyframe = 0;
+
+    // Objects
+    snapshot_add_region(gObjectPool, OBJECT_POOL_CAPACITY * sizeof(struct Object));
+    snapshot_add_region(gObjectListArray, 16 * sizeof(struct ObjectNode));
+    SNAPSHOT_REGION(gFreeObjectList);
+    SNAPSHOT_REGION(gMacroObjectDefaultParent);
+    SNAPSHOT_REGION(gObjectLists);
+    SNAPSHOT_REGION(gMarioObject);
+    SNAPSHOT_REGION(gLuigiObject);
+    SNAPSHOT_REGION(gObjectMemoryPool);
+    SNAPSHOT_REGION(gTimeStopState);
+    SNAPSHOT_REGION(gObjectCounter);
+    SNAPSHOT_REGION(gPrevFrameObjectCount);
+    SNAPSHOT_REGION(gSurfaceNodesAllocated);
+    SNAPSHOT_REGION(gSurfacesAllocated);
+    SNAPSHOT_REGION(gNumStaticSurfaceNodes);
+    SNAPSHOT_REGION(gNumStaticSurfaces);
+    SNAPSHOT_REGION(gEnvironmentRegions);
+    SNAPSHOT_REGION(gEnvironmentLevels);
+    SNAPSHOT_REGION(gDoorAdjacentRooms);
+    SNAPSHOT_REGION(gMarioCurrentRoom);
+    SNAPSHOT_REGION(D_8035FEE2);
+    SNAPSHOT_REGION(D_8035FEE4);
+    SNAPSHOT_REGION(gTHIWaterDrained);
+    SNAPSHOT_REGION(gTTCSpeedSetting);
+    SNAPSHOT_REGION(gMarioShotFromCannon);
+    SNAPSHOT_REGION(gCCMEnteredSlide);
+    SNAPSHOT_REGION(gNumRoomedObjectsInMarioRoom);
+    SNAPSHOT_REGION(gNumRoomedObjectsNotInMarioRoom);
+    SNAPSHOT_REGION(gWDWWaterLevelChanging);
+    SNAPSHOT_REGION(gMarioOnMerryGoRound);
+#ifdef OBJECT_HASH
+    obj_hash_snapshot_regions();
+#endif
+    behavior_script_snapshot_regions();
+
+    // Mario and the level
+    snapshot_add_region(gMarioStates, sizeof(struct MarioState));
+    SNAPSHOT_REGION(gHudDisplay);
+    SNAPSHOT_REGION(sCurrPlayMode);
+    SNAPSHOT_REGION(D_80339ECA);
+    SNAPSHOT_REGION(sTransitionTimer);
+    SNAPSHOT_REGION(sTransitionUpdate);
+    SNAPSHOT_REGION(sWarpDest);
+    SNAPSHOT_REGION(D_80339EE0);
+    SNAPSHOT_REGION(sDelayedWarpOp);
+    SNAPSHOT_REGION(sDelayedWarpTimer);
+    SNAPSHOT_REGION(sSourceWarpNodeId);
+    SNAPSHOT_REGION(sDelayedWarpArg);
+    SNAPSHOT_REGION(sTimerRunning);
+    SNAPSHOT_REGION(gShouldNotPlayCastleMusic);
+    SNAPSHOT_REGION(gCurrCreditsEntry);
+    SNAPSHOT_REGION(gWarpCheckpoint);
+    SNAPSHOT_REGION(gLastCompletedCourseNum);
+    SNAPSHOT_REGION(gLastCompletedStarNum);
+    SNAPSHOT_REGION(gGotFileCoinHiScore);
+    SNAPSHOT_REGION(gCurrCourseStarFlags);
+    SNAPSHOT_REGION(gSpecialTripleJump);
+    SNAPSHOT_REGION(gMainMenuDataModified);
+    SNAPSHOT_REGION(gSaveFileModified);
+    SNAPSHOT_REGION(gSaveBuffer);
+    ingame_menu_snapshot_regions();
+
+    // Areas
+    snapshot_add_region(gPlayerSpawnInfos, sizeof(struct SpawnInfo));
+    snapshot_add_region(D_8033A160, 0x100 * sizeof(struct GraphNode *));
+    snapshot_add_region(gAreaData, 8 * sizeof(struct Area));
+    SNAPSHOT_REGION(gWarpTransition);
+    SNAPSHOT_REGION(gCurrentArea);
+    SNAPSHOT_REGION(gCurrCourseNum);
+    SNAPSHOT_REGION(gCurrActNum);
+    SNAPSHOT_REGION(gCurrAreaIndex);
+    SNAPSHOT_REGION(gSavedCourseNum);
+    SNAPSHOT_REGION(gPauseScreenMode);
+    SNAPSHOT_REGION(gSaveOptSelectIndex);
+    SNAPSHOT_REGION(gCurrSaveFileNum);
+    SNAPSHOT_REGION(gCurrLevelNum);
+    level_script_snapshot_regions();
+
+    // Frame and input state
+    SNAPSHOT_REGION(gGlobalTimer);
+    SNAPSHOT_REGION(gControllers);
+    SNAPSHOT_REGION(gControllerPads);
+    SNAPSHOT_REGION(gCurrDemoInput);
+    SNAPSHOT_REGION(gDemoInputListID);
+    SNAPSHOT_REGION(gRecordedDemoInput);
+    game_init_snapshot_regions();
+
+    camera_snapshot_regions();
+
+    // Surfaces and everything else allocated from the main pool
+    SNAPSHOT_REGION(gStaticSurfacePartition);
+    SNAPSHOT_REGION(gDynamicSurfacePartition);
+    SNAPSHOT_REGION(sSurfaceNodePool);
+    SNAPSHOT_REGION(sSurfacePool);
+    SNAPSHOT_REGION(sSurfacePoolSize);
+    surface_load_snapshot_regions();
+    main_pool_snapshot_regions();
+
+    // Sound
+    sound_init_snapshot_regions();
+    audio_snapshot_regions();
+}
+
+static void snapshot_gather(u32 *state) {
+    s32 i;
+
+    for (i = 0; i < sNumSnapshotRegions; i++) {
+        u32 size = sSnapshotRegions[i].size;
+
+        memcpy(state, sSnapshotRegions[i].ptr, size);
+        if (size % 4 != 0) {
+            memset((u8 *) state + size, 0, 4 - size % 4);
+        }
+        state += (size + 3) / 4;
+    }
+}
+
+static void snapshot_scatter(const u32 *state) {
+    s32 i;
+
+    for (i = 0; i < sNumSnapshotRegions; i++) {
+        memcpy(sSnapshotRegions[i].ptr, state, sSnapshotRegions[i].size);
+        state += (sSnapshotRegions[i].size + 3) / 4;
+    }
+}
+
+/**
+ * Store state XOR prev as pairs of (unchanged word count, changed word count)
+ * followed by the changed words. A NULL prev stores the state against zero.
+ * Return the number of words written.
+ */
+static u32 snapshot_encode(u32 *out, const u32 *state, const u32 *prev) {
+    u32 *start = out;
+    u32 *header;
+    u32 i = 0;
+
+    while (i < sSnapshotWords) {
+        header = out;
+        out += 2;
+
+        header[0] = i;
+        if (prev != NULL) {
+            while (i < sSnapshotWords && state[i] == prev[i]) {
+                i++;
+            }
+        } else {
+            while (i < sSnapshotWords && state[i] == 0) {
+                i++;
+            }
+        }
+        header[0] = i - header[0];
+
+        header[1] = i;
+        if (prev != NULL) {
+            while (i < sSnapshotWords && state[i] != prev[i]) {
+                *out++ = state[i] ^ prev[i];
+                i++;
+            }
+        } else {
+            while (i < sSnapshotWords && state[i] != 0) {
+                *out++ = state[i];
+                i++;
+            }
+        }
+        header[1] = i - header[1];
+    }
+
+    return out - start;
+}
+
+static void snapshot_apply(u32 *state, const u32 *data, u32 length) {
+    const u32 *end = data + length;
+    u32 changed;
+
+    while (data < end) {
+        state += data[0];
+        changed = data[1];
+        data += 2;
+        while (changed-- != 0) {
+            *state++ ^= *data++;
+        }
+    }
+}
+
+/**
+ * Add the current game state to the ring as the state after the given frame.
+ */
+void snapshot_take(u32 frame) {
+    struct Snapshot *snapshot;
+    u32 *swap;
+    u8 isKeyframe;
+
+    if (sSnapshotState == NULL) {
+        sSnapshotState = calloc(sSnapshotWords, sizeof(u32));
+        sSnapshotGather = calloc(sSnapshotWords, sizeof(u32));
+        // Worst case is every other word changed, two header words per changed word
+        sSnapshotEncoded = malloc((sSnapshotWords / 2 * 3 + 4) * sizeof(u32));
+    }
+
+    if (sSnapshotCount == SNAPSHOT_RING_SIZE) {
+        do {
+            snapshot_free_oldest();
+        } while (sSnapshotCount > 0 && !sSnapshotRing[sSnapshotOldest].isKeyframe);
+    }
+
+    snapshot_gather(sSnapshotGather);
+
+    isKeyframe = sSnapshotCount == 0 || sSnapshotsSinceKeyframe >= SNAPSHOT_KEYFRAME_INTERVAL;
+    snapshot = &sSnapshotRing[SNAPSHOT_RING_INDEX(sSnapshotCount)];
+    snapshot->frame = frame;
+    snapshot->isKeyframe = isKeyframe;
+    snapshot->length =
+        snapshot_encode(sSnapshotEncoded, sSnapshotGather, isKeyframe ? NULL : sSnapshotState);
+    snapshot->data = malloc(snapshot->length * sizeof(u32));
+    memcpy(snapshot->data, sSnapshotEncoded, snapshot->length * sizeof(u32));
+    sSnapshotCount++;
+    sSnapshotBytesStored += snapshot->length * sizeof(u32);
+    sSnapshotsSinceKeyframe = isKeyframe ? 1 : sSnapshotsSinceKeyframe + 1;
+
+    swap = sSnapshotState;
+    sSnapshotState = sSnapshotGather;
+    sSnapshotGather = swap;
+}
+
+/**
+ * Restore the newest snapshot taken at or before the given frame, and drop
+ * the ones after it. Return the frame of the restored snapshot, or -1 if
+ * there is none, in which case the game state is left untouched.
+ */
+s32 snapshot_restore(u32 frame) {
+    s32 target = sSnapshotCount - 1;
+    s32 keyframe;
+    s32 n;
+
+    while (target >= 0 && sSnapshotRing[SNAPSHOT_RING_INDEX(target)].frame > frame) {
+        target--;
+    }
+    if (target < 0) {
+        return -1;
+    }
+
+    keyframe = target;
+    while (!sSnapshotRing[SNAPSHOT_RING_INDEX(keyframe)].isKeyframe) {
+        keyframe--;
+    }
+
+    memset(sSnapshotState, 0, sSnapshotWords * sizeof(u32));
+    for (n = keyframe; n <= target; n++) {
+        struct Snapshot *snapshot = &sSnapshotRing[SNAPSHOT_RING_INDEX(n)];
+
+        snapshot_apply(sSnapshotState, snapshot->data, snapshot->length);
+    }
+    snapshot_scatter(sSnapshotState);
+
+    snapshot_free_newer_than(target);
+    sSnapshotsSinceKeyframe = target - keyframe + 1;
+
+#ifdef COLLISION_CACHE
+    // Not part of the state, the cached results may be stale now
+    gSurfacePartitionGeneration++;
+#endif
+
+    return sSnapshotRing[SNAPSHOT_RING_INDEX(target)].frame;
+}
+
+void snapshot_print_stats(void) {
+    if (sSnapshotCount == 0) {
+        return;
+    }
+
+    printf("SNAPSHOT: %d snapshots of %u KB in %d regions, frames %u-%u, %u KB stored (%.1f%%)\n",
+           sSnapshotCount, sSnapshotWords * 4 / 1024, sNumSnapshotRegions,
+           sSnapshotRing[sSnapshotOldest].frame,
+           sSnapshotRing[SNAPSHOT_RING_INDEX(sSnapshotCount - 1)].frame, sSnapshotBytesStored / 1024,
+           100.0 * sSnapshotBytesStored / ((double) sSnapshotWords * 4 * sSnapshotCount));
+}
+#endif
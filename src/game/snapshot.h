@@ -0,0 +1,16 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <PR/ultratypes.h>
+
+#ifdef SNAPSHOTS
+#define SNAPSHOT_REGION(var) snapshot_add_region(&(var), sizeof(var))
+
+void snapshot_add_region(void *ptr, u32 size);
+void snapshot_init(void);
+void snapshot_take(u32 frame);
+s32 snapshot_restore(u32 frame);
+void snapshot_print_stats(void);
+#endif
+
+#endif // SNAPSHOT_H
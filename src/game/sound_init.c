@@ -13,6 +13,7 @@
 #include "save_file.h"
 #include "seq_ids.h"
 #include "sm64.h"
+#include "snapshot.h"
 #include "sound_init.h"
 #include "thread6.h"
 
@@ -302,3 +303,15 @@ void thread4_sound(UNUSED void *arg) {
         }
     }
 }
+
+#ifdef SNAPSHOTS
+void sound_init_snapshot_regions(void) {
+    SNAPSHOT_REGION(D_8032C6C0);
+    SNAPSHOT_REGION(D_8032C6C4);
+    SNAPSHOT_REGION(sCurrentMusic);
+    SNAPSHOT_REGION(sCurrentShellMusic);
+    SNAPSHOT_REGION(sCurrentCapMusic);
+    SNAPSHOT_REGION(sPlayingInfiniteStairs);
+    SNAPSHOT_REGION(paintingEjectSoundPlayed);
+}
+#endif
@@ -38,5 +38,8 @@ void fadeout_cap_music(void);
 void stop_cap_music(void);
 void audio_game_loop_tick(void);
 void thread4_sound(UNUSED void *arg);
+#ifdef SNAPSHOTS
+void sound_init_snapshot_regions(void);
+#endif
 
 #endif // SOUND_INIT_H
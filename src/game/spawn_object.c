@@ -9,6 +9,7 @@
 #include "object_constants.h"
 #include "object_fields.h"
 #include "object_helpers.h"
+#include "object_collision.h"
 #include "object_list_processor.h"
 #include "spawn_object.h"
 #include "types.h"
@@ -174,6 +175,9 @@ void unload_object(struct Object *obj) {
     obj->header.gfx.node.flags &= ~GRAPH_RENDER_BILLBOARD;
     obj->header.gfx.node.flags &= ~GRAPH_RENDER_ACTIVE;
 
+#ifdef OBJECT_HASH
+    obj_hash_remove(obj);
+#endif
     deallocate_object(&gFreeObjectList, &obj->header);
 }
 
@@ -311,6 +315,10 @@ struct Object *create_object(const BehaviorScript *bhvScript) {
         obj->activeFlags |= ACTIVE_FLAG_UNIMPORTANT;
     }
 
+#ifdef OBJECT_HASH
+    obj_hash_insert(obj, objListIndex);
+#endif
+
     //! They intended to snap certain objects to the floor when they spawn.
     //  However, at this point the object's position is the origin. So this will
     //  place the object at the floor beneath the origin. Typically this
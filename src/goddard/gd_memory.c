@@ -19,6 +19,59 @@ static struct GMemBlock *sFreeBlockListHead;
 static struct GMemBlock *sUsedBlockListHead;
 static struct GMemBlock *sEmptyBlockListHead;
 
+#ifdef GD_SLAB_ALLOC
+/**
+ * Small requests are served from per size class free lists ("slabs") instead of
+ * the block lists. Slab pages are carved out of the block lists, one set per
+ * arena: permanent requests go to one arena and temporary requests to the other.
+ * When an arena has nothing left allocated its pages go back to the free block
+ * list all at once.
+ */
+#define GD_SLAB_CLASS_COUNT 15
+#define GD_SLAB_PAGE_SIZE 0x2000
+#define GD_SLAB_MIN_CHUNKS 4
+#define GD_SLAB_NONE 0xFF
+
+enum GdSlabArenas {
+    GD_SLAB_ARENA_PERM,
+    GD_SLAB_ARENA_TEMP,
+    GD_SLAB_ARENA_COUNT
+};
+
+/// Put in front of every allocation so `gd_free_mem` knows where it came from
+struct GdSlabHeader {
+    u32 size;     ///< bytes the caller asked for
+    u8 sizeClass; ///< index into `sSlabClassSizes`, or `GD_SLAB_NONE` for block list memory
+    u8 arena;
+    u8 pad[2];
+};
+
+struct GdSlabClass {
+    u8 *freeList; ///< free chunks, linked through their first word
+    u32 chunks;   ///< chunks carved from this arena's pages
+    u32 used;
+    u32 peakUsed;
+    u32 requestedBytes; ///< sum of the sizes asked for by the chunks in use
+};
+
+struct GdSlabArena {
+    struct GdSlabClass classes[GD_SLAB_CLASS_COUNT];
+    u8 *pages;      ///< pages carved from the block lists, linked through their first word
+    u32 pageBytes;
+    u32 liveAllocs; ///< slab and block list allocations not yet freed
+    u32 liveBytes;
+    u32 peakBytes;
+    u32 pagesReleased;
+};
+
+static const u16 sSlabClassSizes[GD_SLAB_CLASS_COUNT] = {
+    16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+};
+static const u8 sSlabArenaPermanence[GD_SLAB_ARENA_COUNT] = { PERM_G_MEM_BLOCK, TEMP_G_MEM_BLOCK };
+
+static struct GdSlabArena sSlabArenas[GD_SLAB_ARENA_COUNT];
+#endif
+
 /* Forward Declarations */
 void empty_mem_block(struct GMemBlock *);
 struct GMemBlock *into_free_memblock(struct GMemBlock *);
@@ -149,7 +202,11 @@ struct GMemBlock *make_mem_block(u32 blockType, u8 permFlag) {
  * @returns size of memory freed
  * @retval  0    `ptr` did not point to a valid memory block
  */
+#ifdef GD_SLAB_ALLOC
+static u32 free_block_mem(void *ptr) {
+#else
 u32 gd_free_mem(void *ptr) {
+#endif
     register struct GMemBlock *curBlock;
     u32 bytesFreed;
     register u8 *targetBlock = ptr;
@@ -173,7 +230,11 @@ u32 gd_free_mem(void *ptr) {
  * @return pointer to heap
  * @retval NULL could not fulfill the request
  */
+#ifdef GD_SLAB_ALLOC
+static void *request_block_mem(u32 size, u8 permanence) {
+#else
 void *gd_request_mem(u32 size, u8 permanence) {
+#endif
     struct GMemBlock *foundBlock = NULL;
     struct GMemBlock *curBlock;
     struct GMemBlock *newBlock;
@@ -220,6 +281,160 @@ void *gd_request_mem(u32 size, u8 permanence) {
     return newBlock->ptr;
 }
 
+#ifdef GD_SLAB_ALLOC
+/**
+ * Carve a new page of chunks for size class `sizeClass` out of the block lists.
+ *
+ * @returns `FALSE` if the block lists had no room for the page
+ */
+static s32 add_slab_page(struct GdSlabArena *arena, s32 arenaIndex, s32 sizeClass) {
+    struct GdSlabClass *slabClass = &arena->classes[sizeClass];
+    u32 chunkSize = sizeof(struct GdSlabHeader) + sSlabClassSizes[sizeClass];
+    u32 chunkCount = GD_SLAB_PAGE_SIZE / chunkSize;
+    u32 pageSize;
+    u8 *page;
+    u8 *chunk;
+    u32 i;
+
+    if (chunkCount < GD_SLAB_MIN_CHUNKS) {
+        chunkCount = GD_SLAB_MIN_CHUNKS;
+    }
+    // the first word of the page links it into the arena's page list
+    pageSize = sizeof(struct GdSlabHeader) + chunkSize * chunkCount;
+
+    page = request_block_mem(pageSize, sSlabArenaPermanence[arenaIndex]);
+    if (page == NULL) {
+        return FALSE;
+    }
+
+    *(u8 **) page = arena->pages;
+    arena->pages = page;
+    arena->pageBytes += pageSize;
+
+    chunk = page + sizeof(struct GdSlabHeader);
+    for (i = 0; i < chunkCount; i++, chunk += chunkSize) {
+        *(u8 **) chunk = slabClass->freeList;
+        slabClass->freeList = chunk;
+    }
+    slabClass->chunks += chunkCount;
+
+    return TRUE;
+}
+
+/**
+ * Give all of `arena`'s pages back to the block lists. Only called once
+ * nothing is allocated from the arena anymore.
+ */
+static void release_slab_pages(struct GdSlabArena *arena) {
+    u8 *page;
+    u8 *next;
+    s32 i;
+
+    for (page = arena->pages; page != NULL; page = next) {
+        next = *(u8 **) page;
+        free_block_mem(page);
+        arena->pagesReleased++;
+    }
+    arena->pages = NULL;
+    arena->pageBytes = 0;
+
+    for (i = 0; i < GD_SLAB_CLASS_COUNT; i++) {
+        arena->classes[i].freeList = NULL;
+        arena->classes[i].chunks = 0;
+    }
+}
+
+/**
+ * Request a pointer to goddard heap memory of at least `size` and
+ * of the same `permanence`. Requests that fit a size class are served from
+ * that class' free chunks; larger ones fall back to the block lists.
+ *
+ * @return pointer to heap
+ * @retval NULL could not fulfill the request
+ */
+void *gd_request_mem(u32 size, u8 permanence) {
+    s32 arenaIndex = (permanence & PERM_G_MEM_BLOCK) ? GD_SLAB_ARENA_PERM : GD_SLAB_ARENA_TEMP;
+    struct GdSlabArena *arena = &sSlabArenas[arenaIndex];
+    struct GdSlabClass *slabClass;
+    struct GdSlabHeader *header = NULL;
+    s32 sizeClass;
+
+    for (sizeClass = 0; sizeClass < GD_SLAB_CLASS_COUNT; sizeClass++) {
+        if (size <= sSlabClassSizes[sizeClass]) {
+            break;
+        }
+    }
+
+    if (sizeClass < GD_SLAB_CLASS_COUNT) {
+        slabClass = &arena->classes[sizeClass];
+        if (slabClass->freeList != NULL || add_slab_page(arena, arenaIndex, sizeClass)) {
+            header = (struct GdSlabHeader *) slabClass->freeList;
+            slabClass->freeList = *(u8 **) slabClass->freeList;
+            if (++slabClass->used > slabClass->peakUsed) {
+                slabClass->peakUsed = slabClass->used;
+            }
+            slabClass->requestedBytes += size;
+        }
+    }
+
+    if (header == NULL) {
+        header = request_block_mem(sizeof(struct GdSlabHeader) + size, permanence);
+        if (header == NULL) {
+            return NULL;
+        }
+        sizeClass = GD_SLAB_NONE;
+    }
+
+    header->size = size;
+    header->sizeClass = sizeClass;
+    header->arena = arenaIndex;
+
+    arena->liveAllocs++;
+    arena->liveBytes += size;
+    if (arena->liveBytes > arena->peakBytes) {
+        arena->peakBytes = arena->liveBytes;
+    }
+
+    return header + 1;
+}
+
+/**
+ * Free memory allocated on the goddard heap.
+ *
+ * @param ptr pointer to heap allocated memory
+ * @returns size of memory freed
+ */
+u32 gd_free_mem(void *ptr) {
+    struct GdSlabHeader *header = (struct GdSlabHeader *) ptr - 1;
+    struct GdSlabArena *arena;
+    struct GdSlabClass *slabClass;
+    u32 size = header->size;
+
+    if (header->arena >= GD_SLAB_ARENA_COUNT
+        || (header->sizeClass >= GD_SLAB_CLASS_COUNT && header->sizeClass != GD_SLAB_NONE)) {
+        fatal_printf("Free() Not a valid memory block");
+    }
+    arena = &sSlabArenas[header->arena];
+
+    if (header->sizeClass == GD_SLAB_NONE) {
+        free_block_mem(header);
+    } else {
+        slabClass = &arena->classes[header->sizeClass];
+        *(u8 **) header = slabClass->freeList;
+        slabClass->freeList = (u8 *) header;
+        slabClass->used--;
+        slabClass->requestedBytes -= size;
+    }
+
+    arena->liveBytes -= size;
+    if (--arena->liveAllocs == 0) {
+        release_slab_pages(arena);
+    }
+
+    return size;
+}
+#endif
+
 /**
  * Add memory of `size` at `addr` to the goddard heap for later allocation.
  *
@@ -242,6 +457,15 @@ struct GMemBlock *gd_add_mem_to_heap(u32 size, void *addr, u8 permanence) {
  * NULL the various `GMemBlock` list heads
  */
 void init_mem_block_lists(void) {
+#ifdef GD_SLAB_ALLOC
+    u8 *arenaBytes = (u8 *) sSlabArenas;
+    u32 i;
+
+    // the pages went away with the heap, so just forget about them
+    for (i = 0; i < sizeof(sSlabArenas); i++) {
+        arenaBytes[i] = 0;
+    }
+#endif
     sFreeBlockListHead = NULL;
     sUsedBlockListHead = NULL;
     sEmptyBlockListHead = NULL;
@@ -281,6 +505,65 @@ u32 print_list_stats(struct GMemBlock *block, s32 printBlockInfo, s32 permanence
     return entries;
 }
 
+#ifdef GD_SLAB_ALLOC
+/**
+ * Print how much of the free block list memory with this `permanence`
+ * is unusable for a request of the largest free block's size.
+ */
+static void print_free_fragmentation(s32 permanence) {
+    struct GMemBlock *block;
+    u32 totalSize = 0;
+    u32 largest = 0;
+
+    for (block = sFreeBlockListHead; block != NULL; block = block->next) {
+        if (block->permFlag & permanence) {
+            totalSize += block->size;
+            if (block->size > largest) {
+                largest = block->size;
+            }
+        }
+    }
+
+    gd_printf("Free %d bytes, largest block %d bytes (%d%% fragmented)\n", totalSize, largest,
+              totalSize != 0 ? 100 - (s32)((u64) largest * 100 / totalSize) : 0);
+}
+
+/**
+ * Print the high-water mark and the slack in each size class of each arena.
+ */
+static void print_slab_stats(void) {
+    static const char *arenaNames[GD_SLAB_ARENA_COUNT] = { "Perm", "Temp" };
+    struct GdSlabArena *arena;
+    struct GdSlabClass *slabClass;
+    u32 chunkBytes;
+    s32 i;
+    s32 j;
+
+    for (i = 0; i < GD_SLAB_ARENA_COUNT; i++) {
+        arena = &sSlabArenas[i];
+        gd_printf("%s arena: %d bytes live in %d allocations (peak %d bytes)\n", arenaNames[i],
+                  arena->liveBytes, arena->liveAllocs, arena->peakBytes);
+        gd_printf("Slab pages: %d bytes (%d pages released)\n", arena->pageBytes,
+                  arena->pagesReleased);
+
+        for (j = 0; j < GD_SLAB_CLASS_COUNT; j++) {
+            slabClass = &arena->classes[j];
+            if (slabClass->peakUsed == 0) {
+                continue;
+            }
+            chunkBytes = slabClass->used * sSlabClassSizes[j];
+            gd_printf("  %d byte chunks: %d of %d used (peak %d), %d%% unused in used chunks\n",
+                      sSlabClassSizes[j], slabClass->used, slabClass->chunks, slabClass->peakUsed,
+                      chunkBytes != 0 ? 100 - (s32)((u64) slabClass->requestedBytes * 100 / chunkBytes)
+                                      : 0);
+        }
+
+        print_free_fragmentation(sSlabArenaPermanence[i]);
+        gd_printf("\n");
+    }
+}
+#endif
+
 /**
  * Print summary information about all used, free, and empty
  * `GMemBlock`s.
@@ -311,6 +594,10 @@ void mem_stats(void) {
     gd_printf("Empty blocks:\n");
     list = sEmptyBlockListHead;
     print_list_stats(list, FALSE, PERM_G_MEM_BLOCK | TEMP_G_MEM_BLOCK);
+#ifdef GD_SLAB_ALLOC
+    gd_printf("\n");
+    print_slab_stats();
+#endif
 }
 
 /*
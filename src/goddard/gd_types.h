@@ -133,6 +133,9 @@ struct ObjGroup {
     /* 0x30 */ s32 linkType;
     /* 0x34 */ char name[0x40]; ///< possibly, only referenced in old code
     /* 0x74 */ s32 id;
+#ifdef GD_FLAT_SKIN
+    /* 0x78 */ struct GdFlatVtxList *flatVtx; ///< vertices in link1C paired with their GBI vertices
+#endif
 }; /* sizeof = 0x78 */
 
 /* Known linkTypes
@@ -210,6 +213,12 @@ struct ObjJoint {
     /* 0x20C */ struct GdObj *unk20C;       //attached object?
     /* 0x210 */ u8  pad210[0x228-0x210];
     /* 0x228 */ f32 unk228;
+#ifdef GD_FLAT_SKIN
+    /* 0x22C */ struct GdFlatWeight *flatWeights; ///< positive weights in unk1F4, copied by reset_joint_weight
+    /* 0x230 */ s32 numFlatWeights;
+    /* 0x234 */ s32 flatWeightsCapacity;
+    /* 0x238 */ s32 flatWeightsGroupCount; ///< unk1F4->objCount when flatWeights was filled
+#endif
 }; /* sizeof = 0x22C */
 
 /* Particle Types (+60)
@@ -363,6 +372,29 @@ struct VtxLink {
     Vtx *data;
 };
 
+#ifdef GD_FLAT_SKIN
+/// An `ObjWeight` unpacked for the skinning loop in `func_80181894`
+struct GdFlatWeight {
+    struct GdVec3f pos;    ///< ObjWeight::vec20
+    f32 weight;            ///< ObjWeight::unk38
+    struct ObjVertex *vtx; ///< ObjWeight::unk3C
+};
+
+/// One of the GBI vertices made from an `ObjVertex`
+struct GdFlatVtx {
+    struct ObjVertex *vtx;
+    Vtx *data;
+};
+
+struct GdFlatVtxList {
+    struct GdFlatVtx *entries;
+    s32 count;
+    s32 capacity;
+    s32 groupCount;    ///< ObjGroup::objCount when the list was filled
+    u32 vtxLinkCount;  ///< gGdVtxLinkCount when the list was filled
+};
+#endif
+
 struct ObjFace {
     /* 0x00 */ struct GdObj header;
     /* 0x14 */ struct GdColour colour;
@@ -64,6 +64,9 @@ struct ObjJoint *gGdJointList;  // @ 801B9E84
 struct ObjBone *gGdBoneList;    // @ 801B9E88
 struct GdObj *gGdObjectList;    // @ 801B9E8C
 struct ObjGroup *gGdViewsGroup; // @ 801B9E90
+#ifdef GD_FLAT_SKIN
+u32 gGdVtxLinkCount;
+#endif
 
 /* @ 22A480 for 0x70 */
 void func_8017BCB0(void) { /* Initialize Plane? */
@@ -400,6 +403,9 @@ struct VtxLink *make_vtx_link(struct VtxLink *prevlink, Vtx *data) {
     newLink->prev = prevlink;
     newLink->next = NULL;
     newLink->data = data;
+#ifdef GD_FLAT_SKIN
+    gGdVtxLinkCount++;
+#endif
     // WTF?
     if (((uintptr_t)(newLink)) == 0x3F800000) {
         fatal_printf("bad3\n");
@@ -46,6 +46,9 @@ extern struct ObjJoint* gGdJointList;
 extern struct ObjBone* gGdBoneList;
 extern struct GdObj* gGdObjectList;
 extern struct ObjGroup* gGdViewsGroup;
+#ifdef GD_FLAT_SKIN
+extern u32 gGdVtxLinkCount;            /* bumped by make_vtx_link */
+#endif
 
 // functions
 void func_8017BCB0(void);
@@ -297,6 +297,124 @@ void func_80192CCC(struct ObjNet *net) {
     }
 }
 
+#ifdef GD_FLAT_SKIN
+/**
+ * Get `grp`'s vertices paired with each of their GBI vertices, in the order the
+ * link walks in `convert_gd_verts_to_Vn` visit them. The list is refilled if the
+ * group gained objects or any GBI vertices were made since it was last filled.
+ */
+static struct GdFlatVtxList *get_flat_vtx_list(struct ObjGroup *grp) {
+    struct GdFlatVtxList *list;
+    struct GdFlatVtx *fv;
+    struct VtxLink *vtxlink;
+    struct ObjVertex *vtx;
+    struct Links *link;
+    s32 count;
+
+    if ((list = grp->flatVtx) == NULL) {
+        list = gd_malloc_perm(sizeof(struct GdFlatVtxList));
+        if (list == NULL) {
+            return NULL;
+        }
+        list->entries = NULL;
+        list->count = list->capacity = 0;
+        list->groupCount = -1;
+        grp->flatVtx = list;
+    } else if (list->groupCount == grp->objCount && list->vtxLinkCount == gGdVtxLinkCount) {
+        return list;
+    }
+
+    count = 0;
+    for (link = grp->link1C; link != NULL; link = link->next) {
+        vtx = (struct ObjVertex *) link->obj;
+        for (vtxlink = vtx->gbiVerts; vtxlink != NULL; vtxlink = vtxlink->prev) {
+            count++;
+        }
+    }
+
+    if (count > list->capacity) {
+        list->entries = gd_malloc_perm(count * sizeof(struct GdFlatVtx));
+        if (list->entries == NULL) {
+            list->capacity = 0;
+            list->groupCount = -1;
+            return NULL;
+        }
+        list->capacity = count;
+    }
+
+    fv = list->entries;
+    for (link = grp->link1C; link != NULL; link = link->next) {
+        vtx = (struct ObjVertex *) link->obj;
+        for (vtxlink = vtx->gbiVerts; vtxlink != NULL; vtxlink = vtxlink->prev) {
+            fv->vtx = vtx;
+            fv->data = vtxlink->data;
+            fv++;
+        }
+    }
+    list->count = count;
+    list->groupCount = grp->objCount;
+    list->vtxLinkCount = gGdVtxLinkCount;
+
+    return list;
+}
+
+/**
+ * `convert_gd_verts_to_Vn` over a flattened vertex list. Entries made from the
+ * same `ObjVertex` are adjacent, so each vertex is only converted once.
+ */
+static void convert_flat_verts_to_Vn(struct GdFlatVtxList *list) {
+    struct GdFlatVtx *fv = list->entries;
+    struct GdFlatVtx *end = fv + list->count;
+    struct ObjVertex *vtx = NULL;
+    s16 x = 0, y = 0, z = 0;
+    u8 nx = 0, ny = 0, nz = 0;
+    Vtx *vn;
+
+    for (; fv < end; fv++) {
+        if (fv->vtx != vtx) {
+            vtx = fv->vtx;
+            x = (s16) vtx->pos.x;
+            y = (s16) vtx->pos.y;
+            z = (s16) vtx->pos.z;
+            nx = (u8)(vtx->normal.x * 255.0f);
+            ny = (u8)(vtx->normal.y * 255.0f);
+            nz = (u8)(vtx->normal.z * 255.0f);
+        }
+        vn = fv->data;
+        vn->n.ob[0] = x;
+        vn->n.ob[1] = y;
+        vn->n.ob[2] = z;
+        vn->n.n[0] = nx;
+        vn->n.n[1] = ny;
+        vn->n.n[2] = nz;
+    }
+}
+
+/**
+ * `convert_gd_verts_to_Vtx` over a flattened vertex list.
+ */
+static void convert_flat_verts_to_Vtx(struct GdFlatVtxList *list) {
+    struct GdFlatVtx *fv = list->entries;
+    struct GdFlatVtx *end = fv + list->count;
+    struct ObjVertex *vtx = NULL;
+    s16 x = 0, y = 0, z = 0;
+    Vtx *v;
+
+    for (; fv < end; fv++) {
+        if (fv->vtx != vtx) {
+            vtx = fv->vtx;
+            x = (s16) vtx->pos.x;
+            y = (s16) vtx->pos.y;
+            z = (s16) vtx->pos.z;
+        }
+        v = fv->data;
+        v->v.ob[0] = x;
+        v->v.ob[1] = y;
+        v->v.ob[2] = z;
+    }
+}
+#endif
+
 /* 241768 -> 241AB4; orig name: func_80192F98 */
 void convert_gd_verts_to_Vn(struct ObjGroup *grp) {
     UNUSED u8 pad[0x40 - 0x2c];
@@ -313,6 +431,14 @@ void convert_gd_verts_to_Vn(struct ObjGroup *grp) {
     register struct ObjVertex *vtx;   // t2
     register struct Links *link;      // t3
     struct GdObj *obj;                // sp4
+#ifdef GD_FLAT_SKIN
+    struct GdFlatVtxList *flatList;
+
+    if ((flatList = get_flat_vtx_list(grp)) != NULL) {
+        convert_flat_verts_to_Vn(flatList);
+        return;
+    }
+#endif
 
     for (link = grp->link1C; link != NULL; link = link->next) {
         obj = link->obj;
@@ -358,6 +484,14 @@ void convert_gd_verts_to_Vtx(struct ObjGroup *grp) {
     register struct ObjVertex *vtx;   // t2
     register struct Links *link;      // t3
     struct GdObj *obj;                // sp4
+#ifdef GD_FLAT_SKIN
+    struct GdFlatVtxList *flatList;
+
+    if ((flatList = get_flat_vtx_list(grp)) != NULL) {
+        convert_flat_verts_to_Vtx(flatList);
+        return;
+    }
+#endif
 
     for (link = grp->link1C; link != NULL; link = link->next) {
         obj = link->obj;
@@ -6,6 +6,9 @@
 #include "joints.h"
 #include "macros.h"
 #include "objects.h"
+#ifdef GD_FLAT_SKIN
+#include "renderer.h"
+#endif
 #include "skin.h"
 #include "skin_movement.h"
 
@@ -73,6 +76,70 @@ void move_skin(struct ObjNet *net) {
     }
 }
 
+#ifdef GD_FLAT_SKIN
+/**
+ * Same as the weight group walk in `func_80181894`, but over the weights
+ * copied out by `flatten_joint_weights`. The transform is spelled out in the
+ * order `gd_rotate_and_translate_vec3f` uses so the skin comes out identical.
+ */
+static void move_flat_weights(struct ObjJoint *joint) {
+    const Mat4f *mtx = (const Mat4f *) &joint->matE8;
+    struct GdFlatWeight *fw = joint->flatWeights;
+    struct GdFlatWeight *end = fw + joint->numFlatWeights;
+    struct ObjVertex *vtx;
+    f32 x, y, z;
+
+    for (; fw < end; fw++) {
+        x = (*mtx)[0][0] * fw->pos.x + (*mtx)[1][0] * fw->pos.y + (*mtx)[2][0] * fw->pos.z;
+        y = (*mtx)[0][1] * fw->pos.x + (*mtx)[1][1] * fw->pos.y + (*mtx)[2][1] * fw->pos.z;
+        z = (*mtx)[0][2] * fw->pos.x + (*mtx)[1][2] * fw->pos.y + (*mtx)[2][2] * fw->pos.z;
+        x += (*mtx)[3][0];
+        y += (*mtx)[3][1];
+        z += (*mtx)[3][2];
+
+        vtx = fw->vtx;
+        vtx->pos.x += x * fw->weight;
+        vtx->pos.y += y * fw->weight;
+        vtx->pos.z += z * fw->weight;
+    }
+}
+
+/**
+ * Copy the weights in `joint`'s weight group that `func_80181894` would apply
+ * into a contiguous array, so the per frame skinning doesn't chase links.
+ */
+static void flatten_joint_weights(struct ObjJoint *joint) {
+    struct ObjGroup *group = joint->unk1F4;
+    struct ObjWeight *weight;
+    struct GdFlatWeight *fw;
+    struct Links *link;
+
+    if (joint->flatWeightsCapacity < group->objCount) {
+        joint->flatWeights = gd_malloc_perm(group->objCount * sizeof(struct GdFlatWeight));
+        if (joint->flatWeights == NULL) {
+            joint->flatWeightsCapacity = 0;
+            return;
+        }
+        joint->flatWeightsCapacity = group->objCount;
+    }
+
+    fw = joint->flatWeights;
+    for (link = group->link1C; link != NULL; link = link->next) {
+        weight = (struct ObjWeight *) link->obj;
+        if (weight->unk38 > 0.0) {
+            fw->pos.x = weight->vec20.x;
+            fw->pos.y = weight->vec20.y;
+            fw->pos.z = weight->vec20.z;
+            fw->weight = weight->unk38;
+            fw->vtx = weight->unk3C;
+            fw++;
+        }
+    }
+    joint->numFlatWeights = fw - joint->flatWeights;
+    joint->flatWeightsGroupCount = group->objCount;
+}
+#endif
+
 /* @ 230064 for 0x13C*/
 void func_80181894(struct ObjJoint *joint) {
     register struct ObjGroup *weightGroup; // baseGroup? weights Only?
@@ -84,6 +151,13 @@ void func_80181894(struct ObjJoint *joint) {
     struct GdObj *linkedObj;
 
     weightGroup = joint->unk1F4;
+#ifdef GD_FLAT_SKIN
+    if (weightGroup != NULL && joint->flatWeights != NULL
+        && joint->flatWeightsGroupCount == weightGroup->objCount) {
+        move_flat_weights(joint);
+        return;
+    }
+#endif
     if (weightGroup != NULL) {
         for (link = weightGroup->link1C; link != NULL; link = link->next) {
             linkedObj = link->obj;
@@ -155,5 +229,8 @@ void func_80181B88(struct ObjJoint *joint) {
     D_801B9EE8 = joint;
     if ((group = joint->unk1F4) != NULL) {
         apply_to_obj_types_in_group(OBJ_TYPE_WEIGHTS, (applyproc_t) reset_weight, group);
+#ifdef GD_FLAT_SKIN
+        flatten_joint_weights(joint);
+#endif
     }
 }
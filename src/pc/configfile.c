@@ -50,6 +50,10 @@ unsigned int configKeyStickDown  = 0x1F;
 unsigned int configKeyStickLeft  = 0x1E;
 unsigned int configKeyStickRight = 0x20;
 unsigned int configDeadzone      = 0x20;
+#ifdef HIGH_FPS
+// Rendered frames per second, in-between frames are interpolated
+unsigned int configFrameRate     = 60;
+#endif
 
 
 static const struct ConfigOption options[] = {
@@ -69,6 +73,9 @@ static const struct ConfigOption options[] = {
     {.name = "key_stickleft",  .type = CONFIG_TYPE_UINT, .uintValue = &configKeyStickLeft},
     {.name = "key_stickright", .type = CONFIG_TYPE_UINT, .uintValue = &configKeyStickRight},
     {.name = "deadzone",       .type = CONFIG_TYPE_UINT, .uintValue = &configDeadzone},
+#ifdef HIGH_FPS
+    {.name = "frame_rate",     .type = CONFIG_TYPE_UINT, .uintValue = &configFrameRate},
+#endif
 };
 
 // Reads an entire line from a file (excluding the newline character) and returns an allocated string
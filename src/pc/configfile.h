@@ -17,6 +17,9 @@ extern unsigned int configKeyStickDown;
 extern unsigned int configKeyStickLeft;
 extern unsigned int configKeyStickRight;
 extern unsigned int configDeadzone;
+#ifdef HIGH_FPS
+extern unsigned int configFrameRate;
+#endif
 
 void configfile_load(const char *filename);
 void configfile_save(const char *filename);
@@ -24,6 +24,10 @@
 #endif
 
 static struct ControllerAPI *controller_implementations[] = {
+#ifdef HEADLESS
+    // Only the recording drives headless runs
+    &controller_recorded_tas,
+#else
 #if !defined(TARGET_PSP) && !defined(TARGET_DC)
     &controller_recorded_tas,
     &controller_keyboard,
@@ -40,6 +44,7 @@ static struct ControllerAPI *controller_implementations[] = {
 #ifdef __linux__
     &controller_wup,
 #endif
+#endif
 };
 
 s32 osContInit(UNUSED OSMesgQueue *mq, u8 *controllerBits, UNUSED OSContStatus *status) {
@@ -2,12 +2,21 @@
 #include <ultra64.h>
 
 #include "controller_api.h"
+#include "controller_recorded_tas.h"
+#include "game/snapshot.h"
 
 static FILE *fp = NULL;
+static const char *sInputPath = "cont.m64";
+
+#ifdef SNAPSHOTS
+// The input to read next, restored along with the game state, and the one the file is at
+static uint32_t sInputIndex = 0;
+static uint32_t sFileIndex = 0;
+#endif
 
 static void tas_init(void) {
 #if !defined(TARGET_DC)
-    fp = fopen("cont.m64", "rb");
+    fp = fopen(sInputPath, "rb");
     if (fp != NULL) {
         uint8_t buf[0x400];
         fread(buf, 1, sizeof(buf), fp);
@@ -18,6 +27,12 @@ static void tas_init(void) {
 static void tas_read(OSContPad *pad) {
     if (fp != NULL) {
         uint8_t bytes[4] = {0};
+#ifdef SNAPSHOTS
+        if (sFileIndex != sInputIndex) {
+            fseek(fp, 0x400 + 4 * sInputIndex, SEEK_SET);
+        }
+        sFileIndex = ++sInputIndex;
+#endif
         fread(bytes, 1, 4, fp);
         pad->button = (bytes[0] << 8) | bytes[1];
         pad->stick_x = bytes[2];
@@ -25,6 +40,18 @@ static void tas_read(OSContPad *pad) {
     }
 }
 
+#ifdef HEADLESS
+void controller_tas_set_input(const char *path) {
+    sInputPath = path;
+}
+#endif
+
+#ifdef SNAPSHOTS
+void controller_tas_snapshot_regions(void) {
+    SNAPSHOT_REGION(sInputIndex);
+}
+#endif
+
 struct ControllerAPI controller_recorded_tas = {
     tas_init,
     tas_read
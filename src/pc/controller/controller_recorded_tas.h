@@ -4,5 +4,11 @@
 #include "controller_api.h"
 
 extern struct ControllerAPI controller_recorded_tas;
+#ifdef HEADLESS
+void controller_tas_set_input(const char *path);
+#endif
+#ifdef SNAPSHOTS
+void controller_tas_snapshot_regions(void);
+#endif
 
 #endif
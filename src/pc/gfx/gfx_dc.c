@@ -102,7 +102,7 @@ static void gfx_dc_handle_events(void) {
 
 float cpu_time = 0.f, gpu_time = 0.f;
 uint8_t skip_debounce = 0;
-const unsigned int FRAME_TIME_MS = 30; // hopefully get right on target @ 33.3
+static unsigned int frame_time_ms = 30; // hopefully get right on target @ 33.3
 
 static bool gfx_dc_start_frame(void) {
     const unsigned int cur_time = GetSystemTimeLow();
@@ -113,7 +113,7 @@ static bool gfx_dc_start_frame(void) {
         return true;
     }
     // skip if frame took longer than 1 / 30 = 33.3 ms
-    if (elapsed > FRAME_TIME_MS) {
+    if (elapsed > frame_time_ms) {
         skip_debounce = 3; // skip a max of once every 4 frames
         last_time = cur_time;
         return false;
@@ -130,12 +130,12 @@ static void gfx_dc_swap_buffers_end(void) {
     const unsigned int elapsed = cur_time - last_time;
     last_time = cur_time;
 
-    if (force_30fps && elapsed < FRAME_TIME_MS) {
+    if (force_30fps && elapsed < frame_time_ms) {
 #ifdef DEBUG
-        printf("elapsed %d ms fps %f delay %d \n", elapsed, 1000.0f / elapsed, FRAME_TIME_MS - elapsed);
+        printf("elapsed %d ms fps %f delay %d \n", elapsed, 1000.0f / elapsed, frame_time_ms - elapsed);
 #endif
-        DelayThread(FRAME_TIME_MS - elapsed);
-        last_time += (FRAME_TIME_MS - elapsed);
+        DelayThread(frame_time_ms - elapsed);
+        last_time += (frame_time_ms - elapsed);
     }
 
     /* Lets us yield to other threads*/
@@ -147,6 +147,11 @@ static double gfx_dc_get_time(void) {
     return 0.0;
 }
 
+static void gfx_dc_set_target_fps(uint32_t fps) {
+    // Same 10% headroom as the default 30 ms for 33.3 ms
+    frame_time_ms = 900 / fps;
+}
+
 struct GfxWindowManagerAPI gfx_dc = { gfx_dc_init,
                                       gfx_dc_set_keyboard_callbacks,
                                       gfx_dc_set_fullscreen_changed_callback,
@@ -157,7 +162,8 @@ struct GfxWindowManagerAPI gfx_dc = { gfx_dc_init,
                                       gfx_dc_start_frame,
                                       gfx_dc_swap_buffers_begin,
                                       gfx_dc_swap_buffers_end,
-                                      gfx_dc_get_time };
+                                      gfx_dc_get_time,
+                                      gfx_dc_set_target_fps };
 
 
 /* Last ditch 118kb saver, less after VMU */
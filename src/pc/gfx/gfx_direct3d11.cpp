@@ -703,6 +703,13 @@ static void gfx_d3d11_finish_render(void) {
 
 } // namespace
 
+static uint32_t gfx_d3d11_get_vertex_formats(void) {
+    return GFX_VERTEX_FORMAT_FULL;
+}
+
+static void gfx_d3d11_set_vertex_format(uint32_t) {
+}
+
 struct GfxRenderingAPI gfx_direct3d11_api = {
     gfx_d3d11_z_is_from_0_to_1,
     gfx_d3d11_unload_shader,
@@ -721,6 +728,8 @@ struct GfxRenderingAPI gfx_direct3d11_api = {
     gfx_d3d11_set_scissor,
     gfx_d3d11_set_use_alpha,
     gfx_d3d11_draw_triangles,
+    gfx_d3d11_get_vertex_formats,
+    gfx_d3d11_set_vertex_format,
     gfx_d3d11_init,
     gfx_d3d11_on_resize,
     gfx_d3d11_start_frame,
@@ -938,6 +938,13 @@ static void gfx_direct3d12_finish_render(void) {
 
 } // namespace
 
+static uint32_t gfx_direct3d12_get_vertex_formats(void) {
+    return GFX_VERTEX_FORMAT_FULL;
+}
+
+static void gfx_direct3d12_set_vertex_format(uint32_t) {
+}
+
 struct GfxRenderingAPI gfx_direct3d12_api = {
     gfx_direct3d12_z_is_from_0_to_1,
     gfx_direct3d12_unload_shader,
@@ -956,6 +963,8 @@ struct GfxRenderingAPI gfx_direct3d12_api = {
     gfx_direct3d12_set_scissor,
     gfx_direct3d12_set_use_alpha,
     gfx_direct3d12_draw_triangles,
+    gfx_direct3d12_get_vertex_formats,
+    gfx_direct3d12_set_vertex_format,
     gfx_direct3d12_init,
     gfx_direct3d12_on_resize,
     gfx_direct3d12_start_frame,
@@ -62,6 +62,7 @@ static struct {
     HANDLE waitable_object;
     uint64_t qpc_init, qpc_freq;
     uint64_t frame_timestamp; // in units of 1/FRAME_INTERVAL_US_DENOMINATOR microseconds
+    uint64_t frame_interval; // in units of 1/FRAME_INTERVAL_US_DENOMINATOR microseconds
     std::map<UINT, DXGI_FRAME_STATISTICS> frame_stats;
     std::set<std::pair<UINT, UINT>> pending_frame_stats;
     bool dropped_frame;
@@ -263,6 +264,9 @@ static void gfx_dxgi_init(const char *game_name, bool start_in_fullscreen) {
     QueryPerformanceFrequency(&qpc_freq);
     dxgi.qpc_init = qpc_init.QuadPart;
     dxgi.qpc_freq = qpc_freq.QuadPart;
+    if (dxgi.frame_interval == 0) {
+        dxgi.frame_interval = FRAME_INTERVAL_US_NUMERATOR;
+    }
 
     // Prepare window title
 
@@ -378,7 +382,7 @@ static bool gfx_dxgi_start_frame(void) {
         dxgi.pending_frame_stats.erase(dxgi.pending_frame_stats.begin());
     }
 
-    dxgi.frame_timestamp += FRAME_INTERVAL_US_NUMERATOR;
+    dxgi.frame_timestamp += dxgi.frame_interval;
 
     if (dxgi.frame_stats.size() >= 2) {
         DXGI_FRAME_STATISTICS *first = &dxgi.frame_stats.begin()->second;
@@ -422,7 +426,7 @@ static bool gfx_dxgi_start_frame(void) {
 
             if ((int64_t)(dxgi.frame_timestamp / FRAME_INTERVAL_US_DENOMINATOR - last_end_us) < -66666) {
                 // The application must have been paused or similar
-                vsyncs_to_wait = round(((double)FRAME_INTERVAL_US_NUMERATOR / FRAME_INTERVAL_US_DENOMINATOR) / estimated_vsync_interval_us);
+                vsyncs_to_wait = round(((double)dxgi.frame_interval / FRAME_INTERVAL_US_DENOMINATOR) / estimated_vsync_interval_us);
                 if (vsyncs_to_wait < 1) {
                     vsyncs_to_wait = 1;
                 }
@@ -437,7 +441,7 @@ static bool gfx_dxgi_start_frame(void) {
         if (floor(vsyncs_to_wait) != vsyncs_to_wait) {
             uint64_t left = last_end_us + floor(vsyncs_to_wait) * estimated_vsync_interval_us;
             uint64_t right = last_end_us + ceil(vsyncs_to_wait) * estimated_vsync_interval_us;
-            uint64_t adjusted_desired_time = dxgi.frame_timestamp / FRAME_INTERVAL_US_DENOMINATOR + (last_end_us + (FRAME_INTERVAL_US_NUMERATOR / FRAME_INTERVAL_US_DENOMINATOR) > dxgi.frame_timestamp / FRAME_INTERVAL_US_DENOMINATOR ? 2000 : -2000);
+            uint64_t adjusted_desired_time = dxgi.frame_timestamp / FRAME_INTERVAL_US_DENOMINATOR + (last_end_us + (dxgi.frame_interval / FRAME_INTERVAL_US_DENOMINATOR) > dxgi.frame_timestamp / FRAME_INTERVAL_US_DENOMINATOR ? 2000 : -2000);
             int64_t diff_left = adjusted_desired_time - left;
             int64_t diff_right = right - adjusted_desired_time;
             if (diff_left < 0) {
@@ -508,6 +512,10 @@ static double gfx_dxgi_get_time(void) {
     return (double)(t.QuadPart - dxgi.qpc_init) / dxgi.qpc_freq;
 }
 
+static void gfx_dxgi_set_target_fps(uint32_t fps) {
+    dxgi.frame_interval = 1000000ULL * FRAME_INTERVAL_US_DENOMINATOR / fps;
+}
+
 void gfx_dxgi_create_factory_and_device(bool debug, int d3d_version, bool (*create_device_fn)(IDXGIAdapter1 *adapter, bool test_only)) {
     if (dxgi.CreateDXGIFactory2 != nullptr) {
         ThrowIfFailed(dxgi.CreateDXGIFactory2(debug ? DXGI_CREATE_FACTORY_DEBUG : 0, __uuidof(IDXGIFactory2), &dxgi.factory));
@@ -609,6 +617,7 @@ struct GfxWindowManagerAPI gfx_dxgi_api = {
     gfx_dxgi_swap_buffers_begin,
     gfx_dxgi_swap_buffers_end,
     gfx_dxgi_get_time,
+    gfx_dxgi_set_target_fps,
 };
 
 #endif
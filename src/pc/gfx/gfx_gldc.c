@@ -718,6 +718,13 @@ static void gfx_opengl_end_frame(void) {
 static void gfx_opengl_finish_render(void) {
 }
 
+static uint32_t gfx_opengl_get_vertex_formats(void) {
+    return GFX_VERTEX_FORMAT_FULL;
+}
+
+static void gfx_opengl_set_vertex_format(UNUSED uint32_t format) {
+}
+
 struct GfxRenderingAPI gfx_opengl_api = {
     gfx_opengl_z_is_from_0_to_1,
     gfx_opengl_unload_shader,
@@ -736,6 +743,8 @@ struct GfxRenderingAPI gfx_opengl_api = {
     gfx_opengl_set_scissor,
     gfx_opengl_set_use_alpha,
     gfx_opengl_draw_triangles,
+    gfx_opengl_get_vertex_formats,
+    gfx_opengl_set_vertex_format,
     gfx_opengl_init,
     gfx_opengl_on_resize,
     gfx_opengl_start_frame,
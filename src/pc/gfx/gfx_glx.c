@@ -178,6 +178,7 @@ static struct {
     uint64_t ust0;
     int64_t last_msc;
     uint64_t wanted_ust; // multiplied by FRAME_INTERVAL_US_DENOMINATOR
+    uint64_t frame_interval; // multiplied by FRAME_INTERVAL_US_DENOMINATOR
     uint64_t vsync_interval;
     uint64_t last_ust;
     int64_t target_msc;
@@ -360,6 +361,10 @@ static void gfx_glx_init(const char *game_name, bool start_in_fullscreen) {
         glx.glXWaitVideoSyncSGI = (PFNGLXWAITVIDEOSYNCSGIPROC)glXGetProcAddressARB((const GLubyte *)"glXWaitVideoSyncSGI");
     }
     
+    if (glx.frame_interval == 0) {
+        glx.frame_interval = FRAME_INTERVAL_US_NUMERATOR;
+    }
+
     int64_t ust, msc, sbc;
     if (glx.glXGetSyncValuesOML != NULL && glx.glXGetSyncValuesOML(glx.dpy, glx.win, &ust, &msc, &sbc)) {
         glx.has_oml_sync_control = true;
@@ -446,7 +451,7 @@ static bool gfx_glx_start_frame(void) {
 }
 
 static void gfx_glx_swap_buffers_begin(void) {
-    glx.wanted_ust += FRAME_INTERVAL_US_NUMERATOR; // advance 1/30 seconds on JP/US or 1/25 seconds on EU
+    glx.wanted_ust += glx.frame_interval; // advance one frame, 1/30 seconds on JP/US or 1/25 seconds on EU by default
     
     if (!glx.has_oml_sync_control && !glx.has_sgi_video_sync) {
         glFlush();
@@ -460,8 +465,8 @@ static void gfx_glx_swap_buffers_begin(void) {
             }
         }
         
-        if (target + 2 * FRAME_INTERVAL_US_NUMERATOR / FRAME_INTERVAL_US_DENOMINATOR < now) {
-            if (target + 32 * FRAME_INTERVAL_US_NUMERATOR / FRAME_INTERVAL_US_DENOMINATOR >= now) {
+        if (target + 2 * glx.frame_interval / FRAME_INTERVAL_US_DENOMINATOR < now) {
+            if (target + 32 * glx.frame_interval / FRAME_INTERVAL_US_DENOMINATOR >= now) {
                 printf("Dropping frame\n");
                 glx.dropped_frame = true;
                 return;
@@ -486,7 +491,7 @@ static void gfx_glx_swap_buffers_begin(void) {
     if (floor(vsyncs_to_wait) != vsyncs_to_wait) {
         uint64_t left_ust = glx.last_ust + floor(vsyncs_to_wait) * glx.vsync_interval;
         uint64_t right_ust = glx.last_ust + ceil(vsyncs_to_wait) * glx.vsync_interval;
-        uint64_t adjusted_wanted_ust = glx.wanted_ust / FRAME_INTERVAL_US_DENOMINATOR + (glx.last_ust + FRAME_INTERVAL_US_NUMERATOR / FRAME_INTERVAL_US_DENOMINATOR > glx.wanted_ust / FRAME_INTERVAL_US_DENOMINATOR ? 2000 : -2000);
+        uint64_t adjusted_wanted_ust = glx.wanted_ust / FRAME_INTERVAL_US_DENOMINATOR + (glx.last_ust + glx.frame_interval / FRAME_INTERVAL_US_DENOMINATOR > glx.wanted_ust / FRAME_INTERVAL_US_DENOMINATOR ? 2000 : -2000);
         int64_t diff_left = adjusted_wanted_ust - left_ust;
         int64_t diff_right = right_ust - adjusted_wanted_ust;
         if (diff_left < 0) {
@@ -596,6 +601,10 @@ static double gfx_glx_get_time(void) {
     return 0.0;
 }
 
+static void gfx_glx_set_target_fps(uint32_t fps) {
+    glx.frame_interval = 1000000ULL * FRAME_INTERVAL_US_DENOMINATOR / fps;
+}
+
 struct GfxWindowManagerAPI gfx_glx = {
     gfx_glx_init,
     gfx_glx_set_keyboard_callbacks,
@@ -607,7 +616,8 @@ struct GfxWindowManagerAPI gfx_glx = {
     gfx_glx_start_frame,
     gfx_glx_swap_buffers_begin,
     gfx_glx_swap_buffers_end,
-    gfx_glx_get_time
+    gfx_glx_get_time,
+    gfx_glx_set_target_fps
 };
 
 #endif
@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 
 #ifndef _LANGUAGE_C
 #define _LANGUAGE_C
@@ -44,8 +46,68 @@ struct ShaderProgram {
 
 static struct ShaderProgram shader_program_pool[64];
 static uint8_t shader_program_pool_size;
+static struct ShaderProgram *opengl_prg;
 static GLuint opengl_vbo;
 
+/* Streaming vertex buffer. Instead of reallocating the VBO storage with
+   glBufferData on every flush, vertices are appended to a ring. With
+   buffer storage the ring is mapped once and split into one slot per
+   frame in flight, each guarded by a fence. Without it, ranges are mapped
+   unsynchronized and the buffer is orphaned when it fills up. Drivers that
+   can't map buffers at all keep using glBufferData, and so do flushes too
+   big for a slot or the whole ring. */
+#define VBO_RING_SLOTS 3
+#define VBO_RING_SLOT_SIZE (4 * 1024 * 1024)
+#define VBO_RING_SIZE (VBO_RING_SLOTS * VBO_RING_SLOT_SIZE)
+
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+#endif
+
+typedef struct __vbo_ring_sync *vbo_ring_sync_t;
+typedef void (APIENTRY *vbo_buffer_storage_t)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void *(APIENTRY *vbo_map_buffer_range_t)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (APIENTRY *vbo_unmap_buffer_t)(GLenum target);
+typedef vbo_ring_sync_t (APIENTRY *vbo_fence_sync_t)(GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRY *vbo_client_wait_sync_t)(vbo_ring_sync_t sync, GLbitfield flags, uint64_t timeout);
+typedef void (APIENTRY *vbo_delete_sync_t)(vbo_ring_sync_t sync);
+
+enum VboRingMode {
+    VBO_RING_BUFFER_DATA,
+    VBO_RING_MAP_RANGE,
+    VBO_RING_PERSISTENT
+};
+
+static struct {
+    enum VboRingMode mode;
+    uint8_t *mapped;
+    size_t offset;
+    size_t end;
+    uint8_t slot;
+    vbo_ring_sync_t fences[VBO_RING_SLOTS];
+    GLuint overflow_vbo; // for flushes bigger than a slot, the ring's storage can't be respecified
+
+    vbo_buffer_storage_t buffer_storage;
+    vbo_map_buffer_range_t map_buffer_range;
+    vbo_unmap_buffer_t unmap_buffer;
+    vbo_fence_sync_t fence_sync;
+    vbo_client_wait_sync_t client_wait_sync;
+    vbo_delete_sync_t delete_sync;
+} vbo_ring;
+
 static uint32_t frame_count;
 static uint32_t current_height;
 
@@ -80,6 +142,7 @@ static void gfx_opengl_unload_shader(struct ShaderProgram *old_prg) {
 }
 
 static void gfx_opengl_load_shader(struct ShaderProgram *new_prg) {
+    opengl_prg = new_prg;
     glUseProgram(new_prg->opengl_program_id);
     gfx_opengl_vertex_array_set_attribs(new_prg);
     gfx_opengl_set_uniforms(new_prg);
@@ -465,10 +528,167 @@ static void gfx_opengl_set_use_alpha(bool use_alpha) {
     }
 }
 
+static void *vbo_ring_proc(const char *name, const char *ext_name) {
+    void *proc = SDL_GL_GetProcAddress(name);
+    return proc != NULL ? proc : SDL_GL_GetProcAddress(ext_name);
+}
+
+// GL_VERSION reads "<major>.<minor> ..." on desktop GL and "OpenGL ES <major>.<minor> ..." on ES
+static int vbo_ring_gl_version(bool *es) {
+    const char *version = (const char *)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+
+    *es = false;
+    if (version == NULL) {
+        return 0;
+    }
+    if (strncmp(version, "OpenGL ES", 9) == 0) {
+        *es = true;
+        while (*version != '\0' && (*version < '0' || *version > '9')) {
+            version++;
+        }
+    }
+    if (sscanf(version, "%d.%d", &major, &minor) != 2) {
+        return 0;
+    }
+    return major * 10 + minor;
+}
+
+static void vbo_ring_init(void) {
+    vbo_ring.buffer_storage = (vbo_buffer_storage_t)vbo_ring_proc("glBufferStorage", "glBufferStorageEXT");
+    vbo_ring.map_buffer_range = (vbo_map_buffer_range_t)vbo_ring_proc("glMapBufferRange", "glMapBufferRangeEXT");
+    vbo_ring.unmap_buffer = (vbo_unmap_buffer_t)vbo_ring_proc("glUnmapBuffer", "glUnmapBufferOES");
+    vbo_ring.fence_sync = (vbo_fence_sync_t)vbo_ring_proc("glFenceSync", "glFenceSyncAPPLE");
+    vbo_ring.client_wait_sync = (vbo_client_wait_sync_t)vbo_ring_proc("glClientWaitSync", "glClientWaitSyncAPPLE");
+    vbo_ring.delete_sync = (vbo_delete_sync_t)vbo_ring_proc("glDeleteSync", "glDeleteSyncAPPLE");
+
+    // Entry points can resolve even where the context doesn't support them, so only trust them
+    // when the version or an extension says the feature is there
+    bool es;
+    int version = vbo_ring_gl_version(&es);
+    bool has_map_range = version >= 30 || SDL_GL_ExtensionSupported("GL_ARB_map_buffer_range") || SDL_GL_ExtensionSupported("GL_EXT_map_buffer_range");
+    bool has_sync = version >= (es ? 30 : 32) || SDL_GL_ExtensionSupported("GL_ARB_sync") || SDL_GL_ExtensionSupported("GL_APPLE_sync");
+    bool has_storage = (!es && version >= 44) || SDL_GL_ExtensionSupported("GL_ARB_buffer_storage") || SDL_GL_ExtensionSupported("GL_EXT_buffer_storage");
+    bool has_fences = has_sync && vbo_ring.fence_sync != NULL && vbo_ring.client_wait_sync != NULL && vbo_ring.delete_sync != NULL;
+
+    has_map_range = has_map_range && vbo_ring.map_buffer_range != NULL;
+    vbo_ring.mode = VBO_RING_BUFFER_DATA;
+    if (has_map_range && has_storage && has_fences && vbo_ring.buffer_storage != NULL) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        vbo_ring.buffer_storage(GL_ARRAY_BUFFER, VBO_RING_SIZE, NULL, flags);
+        vbo_ring.mapped = vbo_ring.map_buffer_range(GL_ARRAY_BUFFER, 0, VBO_RING_SIZE, flags);
+        if (vbo_ring.mapped != NULL) {
+            vbo_ring.mode = VBO_RING_PERSISTENT;
+        } else {
+            // Storage is immutable now, so the other paths need a fresh buffer
+            glDeleteBuffers(1, &opengl_vbo);
+            glGenBuffers(1, &opengl_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, opengl_vbo);
+        }
+    }
+    if (vbo_ring.mode == VBO_RING_BUFFER_DATA && has_map_range && vbo_ring.unmap_buffer != NULL) {
+        glBufferData(GL_ARRAY_BUFFER, VBO_RING_SIZE, NULL, GL_STREAM_DRAW);
+        vbo_ring.mode = VBO_RING_MAP_RANGE;
+    }
+    vbo_ring.slot = 0;
+    vbo_ring.offset = 0;
+    vbo_ring.end = vbo_ring.mode == VBO_RING_PERSISTENT ? VBO_RING_SLOT_SIZE : VBO_RING_SIZE;
+}
+
+static void vbo_ring_wait(uint8_t slot) {
+    if (vbo_ring.fences[slot] != NULL) {
+        GLenum res;
+        do {
+            res = vbo_ring.client_wait_sync(vbo_ring.fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+        } while (res == GL_TIMEOUT_EXPIRED);
+        vbo_ring.delete_sync(vbo_ring.fences[slot]);
+        vbo_ring.fences[slot] = NULL;
+    }
+}
+
+static void vbo_ring_start_frame(void) {
+    if (vbo_ring.mode != VBO_RING_PERSISTENT) {
+        return;
+    }
+    vbo_ring.slot = (vbo_ring.slot + 1) % VBO_RING_SLOTS;
+    vbo_ring_wait(vbo_ring.slot);
+    vbo_ring.offset = (size_t)vbo_ring.slot * VBO_RING_SLOT_SIZE;
+    vbo_ring.end = vbo_ring.offset + VBO_RING_SLOT_SIZE;
+}
+
+static void vbo_ring_end_frame(void) {
+    if (vbo_ring.mode != VBO_RING_PERSISTENT) {
+        return;
+    }
+    vbo_ring.fences[vbo_ring.slot] = vbo_ring.fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Copies the vertices into the ring and returns the index of the first one
+static GLint vbo_ring_write(const float *buf_vbo, size_t size, size_t stride) {
+    // glDrawArrays can only start on a whole vertex
+    size_t offset = (vbo_ring.offset + stride - 1) / stride * stride;
+
+    if (vbo_ring.mode == VBO_RING_PERSISTENT) {
+        if (offset + size > vbo_ring.end) {
+            // This frame outgrew its slot, wait until the GPU is done with it and start over
+            glFinish();
+            offset = vbo_ring.end - VBO_RING_SLOT_SIZE;
+            offset = (offset + stride - 1) / stride * stride;
+        }
+        memcpy(vbo_ring.mapped + offset, buf_vbo, size);
+    } else {
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        void *dst;
+        if (size > VBO_RING_SIZE) {
+            // Bigger than the whole ring, the next write orphans this storage again
+            glBufferData(GL_ARRAY_BUFFER, size, buf_vbo, GL_STREAM_DRAW);
+            vbo_ring.offset = vbo_ring.end;
+            return 0;
+        }
+        if (offset + size > vbo_ring.end) {
+            // Orphan: the driver hands out fresh storage while the old one is still in use
+            glBufferData(GL_ARRAY_BUFFER, VBO_RING_SIZE, NULL, GL_STREAM_DRAW);
+            offset = 0;
+            access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+        }
+        dst = vbo_ring.map_buffer_range(GL_ARRAY_BUFFER, offset, size, access);
+        if (dst == NULL) {
+            // Keep drawing even if the driver refuses to map
+            vbo_ring.mode = VBO_RING_BUFFER_DATA;
+            glBufferData(GL_ARRAY_BUFFER, size, buf_vbo, GL_STREAM_DRAW);
+            return 0;
+        }
+        memcpy(dst, buf_vbo, size);
+        vbo_ring.unmap_buffer(GL_ARRAY_BUFFER);
+    }
+    vbo_ring.offset = offset + size;
+    return offset / stride;
+}
+
 static void gfx_opengl_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
     //printf("flushing %d tris\n", buf_vbo_num_tris);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * buf_vbo_len, buf_vbo, GL_STREAM_DRAW);
-    glDrawArrays(GL_TRIANGLES, 0, 3 * buf_vbo_num_tris);
+    size_t size = sizeof(float) * buf_vbo_len;
+    size_t stride = size / (3 * buf_vbo_num_tris);
+    GLint first = 0;
+
+    if (vbo_ring.mode == VBO_RING_BUFFER_DATA) {
+        glBufferData(GL_ARRAY_BUFFER, size, buf_vbo, GL_STREAM_DRAW);
+    } else if (vbo_ring.mode == VBO_RING_PERSISTENT && size > VBO_RING_SLOT_SIZE) {
+        // Doesn't fit in a slot, draw it from a buffer of its own and point the attributes back
+        if (vbo_ring.overflow_vbo == 0) {
+            glGenBuffers(1, &vbo_ring.overflow_vbo);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_ring.overflow_vbo);
+        glBufferData(GL_ARRAY_BUFFER, size, buf_vbo, GL_STREAM_DRAW);
+        gfx_opengl_vertex_array_set_attribs(opengl_prg);
+        glDrawArrays(GL_TRIANGLES, 0, 3 * buf_vbo_num_tris);
+        glBindBuffer(GL_ARRAY_BUFFER, opengl_vbo);
+        gfx_opengl_vertex_array_set_attribs(opengl_prg);
+        return;
+    } else {
+        first = vbo_ring_write(buf_vbo, size, stride);
+    }
+    glDrawArrays(GL_TRIANGLES, first, 3 * buf_vbo_num_tris);
 }
 
 static void gfx_opengl_init(void) {
@@ -479,6 +699,7 @@ static void gfx_opengl_init(void) {
     glGenBuffers(1, &opengl_vbo);
     
     glBindBuffer(GL_ARRAY_BUFFER, opengl_vbo);
+    vbo_ring_init();
     
     glDepthFunc(GL_LEQUAL);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -489,6 +710,7 @@ static void gfx_opengl_on_resize(void) {
 
 static void gfx_opengl_start_frame(void) {
     frame_count++;
+    vbo_ring_start_frame();
 
     glDisable(GL_SCISSOR_TEST);
     glDepthMask(GL_TRUE); // Must be set to clear Z-buffer
@@ -498,11 +720,20 @@ static void gfx_opengl_start_frame(void) {
 }
 
 static void gfx_opengl_end_frame(void) {
+    vbo_ring_end_frame();
 }
 
 static void gfx_opengl_finish_render(void) {
 }
 
+static uint32_t gfx_opengl_get_vertex_formats(void) {
+    return GFX_VERTEX_FORMAT_FULL;
+}
+
+static void gfx_opengl_set_vertex_format(uint32_t format) {
+    (void)format;
+}
+
 struct GfxRenderingAPI gfx_opengl_api = {
     gfx_opengl_z_is_from_0_to_1,
     gfx_opengl_unload_shader,
@@ -521,6 +752,8 @@ struct GfxRenderingAPI gfx_opengl_api = {
     gfx_opengl_set_scissor,
     gfx_opengl_set_use_alpha,
     gfx_opengl_draw_triangles,
+    gfx_opengl_get_vertex_formats,
+    gfx_opengl_set_vertex_format,
     gfx_opengl_init,
     gfx_opengl_on_resize,
     gfx_opengl_start_frame,
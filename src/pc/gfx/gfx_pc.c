@@ -23,6 +23,7 @@
 #include "gfx_rendering_api.h"
 #include "gfx_screen_config.h"
 #include "macros.h"
+#include "psp_texture_manager.h"
 
 #define STRINGIFY(x) #x
 #define TOSTRING(x) STRINGIFY(x)
@@ -98,6 +99,9 @@ struct TextureHashmapNode {
     uint32_t texture_id;
     uint8_t cms, cmt;
     bool linear_filter;
+#ifdef ASYNC_TEXTURES
+    bool pending; // showing a placeholder while its TextureJob decodes
+#endif
 } __attribute__((packed, aligned(4)));
 static struct {
     struct TextureHashmapNode *hashmap[1024];
@@ -189,6 +193,11 @@ typedef struct psp_fast_t {
   struct RGBA color;
   float x,y,z;
 } psp_fast_t;
+/* Same as psp_fast_t minus the texture coordinates, for untextured shaders */
+typedef struct psp_fast_notex_t {
+  struct RGBA color;
+  float x,y,z;
+} psp_fast_notex_t;
 static psp_fast_t buf_vbo[MAX_BUFFERED  * 3] __attribute__ ((aligned (32))); // 3 vertices in a triangle and 26 floats per vtx
 #else
 static float buf_vbo[MAX_BUFFERED * (26 * 3)] // 3 vertices in a triangle and 26 floats per vtx
@@ -196,6 +205,116 @@ static float buf_vbo[MAX_BUFFERED * (26 * 3)] // 3 vertices in a triangle and 26
 static size_t buf_vbo_len;
 static size_t buf_num_vert;
 static size_t buf_vbo_num_tris;
+static uint32_t buf_vbo_format = GFX_VERTEX_FORMAT_FULL;
+static uint32_t vertex_formats = GFX_VERTEX_FORMAT_FULL; // what the backend accepts
+
+/* Everything a decoder needs to turn a loaded texture into texels, copied out of rdp */
+struct TextureSource {
+    const uint8_t *addr;
+    const uint8_t *palette;
+    uint32_t size_bytes;
+    uint32_t line_size_bytes;
+    uint8_t fmt, siz;
+#ifdef GFX_2D_ATLAS
+    struct AtlasEntry *atlas; // decode into this atlas slot instead of a new texture
+#endif
+#ifdef ASYNC_TEXTURES
+    struct TextureJob *job; // decode into this job's buffer, on the worker thread
+#endif
+};
+
+#ifdef ASYNC_TEXTURES
+/* Texture misses are decoded on a low priority thread, which gets the CPU while the
+   render thread waits on the GE or vblank. The draw shows an average colour placeholder
+   until the texels are ready, at most until the next frame starts. */
+#define TEXTURE_JOBS (64)
+#define TEXTURE_PLACEHOLDER_SIZE (8)
+
+enum TextureJobState {
+    TEXTURE_JOB_FREE,
+    TEXTURE_JOB_QUEUED,
+    TEXTURE_JOB_DECODING,
+    TEXTURE_JOB_READY
+};
+
+struct TextureJob {
+    volatile int state;
+    uint32_t seq;
+    uint32_t frame; // frame the texture was first drawn in
+    struct TextureSource src;
+    struct TextureHashmapNode *node; // cache entry waiting for it, NULL for prefetches
+    uint8_t *buf;
+    int width, height;
+    unsigned int type;
+};
+
+static struct {
+    struct TextureJob jobs[TEXTURE_JOBS];
+    uint32_t seq;
+    uint32_t frame;
+    SceUID thread, queued_sema, lock;
+    struct {
+        uint32_t misses, placeholders, prefetches, prefetch_hits, sync_decodes;
+        uint32_t decode_us, stall_us;
+    } stats;
+} gfx_texture_jobs;
+
+/* Cache entries are about to be reset, jobs keep their texels but no longer own a node */
+static void gfx_texture_jobs_detach(void) {
+    for (int i = 0; i < TEXTURE_JOBS; i++) {
+        gfx_texture_jobs.jobs[i].node = NULL;
+    }
+}
+#endif
+
+/* Texture rectangles are queued here and drawn as one GU_SPRITES call when state changes */
+#define MAX_BUFFERED_SPRITES (256)
+static VertexColor sprite_vbo[MAX_BUFFERED_SPRITES * 2] __attribute__ ((aligned (32))); // 2 vertices per sprite
+static size_t sprite_vbo_num;
+
+#ifdef GFX_2D_ATLAS
+/* Texture atlas for the small textures drawn by texture rectangles (HUD digits, icons...).
+   Rectangles that land on the same page keep one texture bound and stay in one sprite batch. */
+#define ATLAS_PAGE_SIZE (256)
+#define ATLAS_MAX_PAGES (2)
+#define ATLAS_MAX_DIM (32)
+#define ATLAS_GUTTER (1)
+
+struct AtlasEntry {
+    struct AtlasEntry *next;
+
+    const uint8_t *texture_addr;
+    uint8_t fmt, siz;
+
+    uint8_t page;
+    uint16_t x, y;
+    uint16_t width, height;
+};
+
+struct AtlasPage {
+    struct TextureHashmapNode node; // texture id and sampler state, same as a cached texture
+    uint16_t *texels;
+    uint16_t shelf_x, shelf_y, shelf_height;
+};
+
+static struct {
+    struct AtlasEntry *hashmap[256];
+    struct AtlasEntry pool[256];
+    uint32_t pool_pos;
+    struct AtlasPage pages[ATLAS_MAX_PAGES];
+    uint32_t num_pages;
+    bool full;
+} gfx_atlas;
+
+/* Atlas entry currently standing in for each tile, NULL when a regular texture is bound */
+static const struct AtlasEntry *atlas_entries[2];
+#endif
+
+#ifdef GFX_2D_BENCHMARK
+static struct {
+    uint32_t rects, draws, binds, texture_changes;
+} gfx_2d_stats;
+#endif
 
 static struct GfxWindowManagerAPI *gfx_wapi;
 static struct GfxRenderingAPI *gfx_rapi;
@@ -412,7 +531,18 @@ void gfx_clip_single_vert( struct LoadedVertex *p_p_vertices, size_t *p_num_vert
 //******************* End Clipping things
 
 
+static void gfx_flush_sprites(void) {
+    if (sprite_vbo_num > 0) {
+        gfx_scegu_draw_triangles_2d((float *)sprite_vbo, sprite_vbo_num * 2 * sizeof(VertexColor), sprite_vbo_num);
+        sprite_vbo_num = 0;
+#ifdef GFX_2D_BENCHMARK
+        gfx_2d_stats.draws++;
+#endif
+    }
+}
+
 static void gfx_flush(void) {
+    gfx_flush_sprites();
     if (buf_vbo_len > 0) {
         //int num = buf_vbo_num_tris;
         //unsigned long t0 = get_time();
@@ -504,6 +634,13 @@ static struct ColorCombiner *gfx_lookup_or_create_color_combiner(uint32_t cc_id)
 extern int gfx_vram_space_available(void);
 extern void texman_clear(void);
 
+#ifdef GFX_2D_ATLAS
+static void gfx_atlas_reset(void) {
+    memset(&gfx_atlas, 0, sizeof(gfx_atlas));
+    atlas_entries[0] = atlas_entries[1] = NULL;
+}
+#endif
+
 static bool gfx_texture_cache_lookup(int tile, struct TextureHashmapNode **n, const uint8_t *orig_addr, uint32_t fmt, uint32_t siz) {
     size_t hash = (uintptr_t)orig_addr;
     hash = (hash >> 5) & 0x3ff;
@@ -519,8 +656,14 @@ static bool gfx_texture_cache_lookup(int tile, struct TextureHashmapNode **n, co
     }
     if(!gfx_vram_space_available()) {
         texman_clear();
+#ifdef GFX_2D_ATLAS
+        gfx_atlas_reset();
+#endif
 
         // Pool is full. We just invalidate everything and start over.
+#ifdef ASYNC_TEXTURES
+        gfx_texture_jobs_detach();
+#endif
         gfx_texture_cache.pool_pos = 0;
         memset(gfx_texture_cache.pool, 0, sizeof(gfx_texture_cache.pool));
         node = &gfx_texture_cache.hashmap[hash];
@@ -528,6 +671,9 @@ static bool gfx_texture_cache_lookup(int tile, struct TextureHashmapNode **n, co
     }
     if (gfx_texture_cache.pool_pos == sizeof(gfx_texture_cache.pool) / sizeof(struct TextureHashmapNode)) {
         // Pool is full. We just invalidate everything and start over.
+#ifdef ASYNC_TEXTURES
+        gfx_texture_jobs_detach();
+#endif
         gfx_texture_cache.pool_pos = 0;
         memset(gfx_texture_cache.pool, 0, sizeof(gfx_texture_cache.pool));
         node = &gfx_texture_cache.hashmap[hash];
@@ -551,10 +697,53 @@ static bool gfx_texture_cache_lookup(int tile, struct TextureHashmapNode **n, co
     return false;
 }
 
-static void import_texture_rgba16(int tile) {
+#ifdef GFX_2D_ATLAS
+/* Copies a decoded texture into its atlas slot, duplicating the edge texels into the gutter */
+static void gfx_atlas_store(const struct AtlasEntry *entry, const uint8_t *buf, int width, int height, unsigned int type) {
+    struct AtlasPage *page = &gfx_atlas.pages[entry->page];
+    for (int y = -ATLAS_GUTTER; y < height + ATLAS_GUTTER; y++) {
+        const int sy = y < 0 ? 0 : (y >= height ? height - 1 : y);
+        uint16_t *dst = &page->texels[(entry->y + y) * ATLAS_PAGE_SIZE + entry->x];
+        for (int x = -ATLAS_GUTTER; x < width + ATLAS_GUTTER; x++) {
+            const int sx = x < 0 ? 0 : (x >= width ? width - 1 : x);
+            if (type == GU_PSM_5551) {
+                dst[x] = ((const uint16_t *)buf)[sy * width + sx];
+            } else {
+                const uint8_t *c = &buf[4 * (sy * width + sx)];
+                dst[x] = ((c[3] >= 128) << 15) | ((c[2] >> 3) << 10) | ((c[1] >> 3) << 5) | (c[0] >> 3);
+            }
+        }
+    }
+    uint16_t *first_row = &page->texels[(entry->y - ATLAS_GUTTER) * ATLAS_PAGE_SIZE];
+    sceKernelDcacheWritebackRange(first_row, (height + 2 * ATLAS_GUTTER) * ATLAS_PAGE_SIZE * sizeof(uint16_t));
+    sceGuTexFlush();
+}
+#endif
+
+static void gfx_upload_texture(const struct TextureSource *src, const uint8_t *buf, int width, int height, unsigned int type) {
+#ifdef ASYNC_TEXTURES
+    if (src->job != NULL) {
+        struct TextureJob *job = src->job;
+        memcpy(job->buf, buf, width * height * (type == GU_PSM_5551 ? 2 : 4));
+        job->width = width;
+        job->height = height;
+        job->type = type;
+        return;
+    }
+#endif
+#ifdef GFX_2D_ATLAS
+    if (src->atlas != NULL) {
+        gfx_atlas_store(src->atlas, buf, width, height, type);
+        return;
+    }
+#endif
+    gfx_rapi->upload_texture(buf, width, height, type);
+}
+
+static void import_texture_rgba16(const struct TextureSource *src) {
     uint16_t rgba16_buf[4096] __attribute__ ((aligned(4)));    
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes / 2; i++) {
-        uint16_t col16 = (rdp.loaded_texture[tile].addr[2 * i] << 8) | rdp.loaded_texture[tile].addr[2 * i + 1];
+    for (uint32_t i = 0; i < src->size_bytes / 2; i++) {
+        uint16_t col16 = (src->addr[2 * i] << 8) | src->addr[2 * i + 1];
         const uint8_t a = col16 & 1;
         const uint8_t r = (col16 >> 11) & 0x1f;
         const uint8_t g = (col16 >> 6) & 0x1f;
@@ -562,23 +751,23 @@ static void import_texture_rgba16(int tile) {
         rgba16_buf[i] = (a << 15)  | (b << 10)  | (g << 5) | (r);
     }
     
-    uint32_t width = rdp.texture_tile.line_size_bytes / 2;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes / 2;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
 
-    gfx_rapi->upload_texture((const uint8_t*)rgba16_buf, width, height, GU_PSM_5551);
+    gfx_upload_texture(src, (const uint8_t*)rgba16_buf, width, height, GU_PSM_5551);
 }
 
-static void import_texture_rgba32(int tile) {
-    uint32_t width = rdp.texture_tile.line_size_bytes / 2;
-    uint32_t height = (rdp.loaded_texture[tile].size_bytes / 2) / rdp.texture_tile.line_size_bytes;
-    gfx_rapi->upload_texture(rdp.loaded_texture[tile].addr, width, height, GU_PSM_8888);
+static void import_texture_rgba32(const struct TextureSource *src) {
+    uint32_t width = src->line_size_bytes / 2;
+    uint32_t height = (src->size_bytes / 2) / src->line_size_bytes;
+    gfx_upload_texture(src, src->addr, width, height, GU_PSM_8888);
 }
 
-static void import_texture_ia4(int tile) {
+static void import_texture_ia4(const struct TextureSource *src) {
     uint8_t rgba32_buf[32768] __attribute__ ((aligned(4)));
     
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes * 2; i++) {
-        uint8_t byte = rdp.loaded_texture[tile].addr[i / 2];
+    for (uint32_t i = 0; i < src->size_bytes * 2; i++) {
+        uint8_t byte = src->addr[i / 2];
         uint8_t part = (byte >> (4 - (i % 2) * 4)) & 0xf;
         uint8_t intensity = part >> 1;
         uint8_t alpha = part & 1;
@@ -591,18 +780,18 @@ static void import_texture_ia4(int tile) {
         rgba32_buf[4*i + 3] = alpha ? 255 : 0;
     }
     
-    uint32_t width = rdp.texture_tile.line_size_bytes * 2;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes * 2;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
     
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
-static void import_texture_ia8(int tile) {
+static void import_texture_ia8(const struct TextureSource *src) {
     uint8_t rgba32_buf[16384]__attribute__ ((aligned(4)));
     
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes; i++) {
-        uint8_t intensity = rdp.loaded_texture[tile].addr[i] >> 4;
-        uint8_t alpha = rdp.loaded_texture[tile].addr[i] & 0xf;
+    for (uint32_t i = 0; i < src->size_bytes; i++) {
+        uint8_t intensity = src->addr[i] >> 4;
+        uint8_t alpha = src->addr[i] & 0xf;
         uint8_t r = intensity;
         uint8_t g = intensity;
         uint8_t b = intensity;
@@ -612,18 +801,18 @@ static void import_texture_ia8(int tile) {
         rgba32_buf[4*i + 3] = SCALE_4_8(alpha);
     }
     
-    uint32_t width = rdp.texture_tile.line_size_bytes;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
     
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
-static void import_texture_ia16(int tile) {
+static void import_texture_ia16(const struct TextureSource *src) {
     uint8_t rgba32_buf[8192];
     
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes / 2; i++) {
-        uint8_t intensity = rdp.loaded_texture[tile].addr[2 * i];
-        uint8_t alpha = rdp.loaded_texture[tile].addr[2 * i + 1];
+    for (uint32_t i = 0; i < src->size_bytes / 2; i++) {
+        uint8_t intensity = src->addr[2 * i];
+        uint8_t alpha = src->addr[2 * i + 1];
         uint8_t r = intensity;
         uint8_t g = intensity;
         uint8_t b = intensity;
@@ -633,17 +822,17 @@ static void import_texture_ia16(int tile) {
         rgba32_buf[4*i + 3] = alpha;
     }
     
-    uint32_t width = rdp.texture_tile.line_size_bytes / 2;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes / 2;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
     
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
-static void import_texture_i4(int tile) {
+static void import_texture_i4(const struct TextureSource *src) {
     uint8_t rgba32_buf[32768];
 
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes * 2; i++) {
-        uint8_t byte = rdp.loaded_texture[tile].addr[i / 2];
+    for (uint32_t i = 0; i < src->size_bytes * 2; i++) {
+        uint8_t byte = src->addr[i / 2];
         uint8_t part = (byte >> (4 - (i % 2) * 4)) & 0xf;
         uint8_t intensity = part;
         uint8_t r = intensity;
@@ -655,17 +844,17 @@ static void import_texture_i4(int tile) {
         rgba32_buf[4*i + 3] = 255;
     }
 
-    uint32_t width = rdp.texture_tile.line_size_bytes * 2;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes * 2;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
 
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
-static void import_texture_i8(int tile) {
+static void import_texture_i8(const struct TextureSource *src) {
     uint8_t rgba32_buf[16384];
 
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes; i++) {
-        uint8_t intensity = rdp.loaded_texture[tile].addr[i];
+    for (uint32_t i = 0; i < src->size_bytes; i++) {
+        uint8_t intensity = src->addr[i];
         uint8_t r = intensity;
         uint8_t g = intensity;
         uint8_t b = intensity;
@@ -675,20 +864,20 @@ static void import_texture_i8(int tile) {
         rgba32_buf[4*i + 3] = 255;
     }
 
-    uint32_t width = rdp.texture_tile.line_size_bytes;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
 
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
 
-static void import_texture_ci4(int tile) {
+static void import_texture_ci4(const struct TextureSource *src) {
     uint8_t rgba32_buf[32768];
     
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes * 2; i++) {
-        uint8_t byte = rdp.loaded_texture[tile].addr[i / 2];
+    for (uint32_t i = 0; i < src->size_bytes * 2; i++) {
+        uint8_t byte = src->addr[i / 2];
         uint8_t idx = (byte >> (4 - (i % 2) * 4)) & 0xf;
-        uint16_t col16 = (rdp.palette[idx * 2] << 8) | rdp.palette[idx * 2 + 1]; // Big endian load
+        uint16_t col16 = (src->palette[idx * 2] << 8) | src->palette[idx * 2 + 1]; // Big endian load
         uint8_t a = col16 & 1;
         uint8_t r = col16 >> 11;
         uint8_t g = (col16 >> 6) & 0x1f;
@@ -699,18 +888,18 @@ static void import_texture_ci4(int tile) {
         rgba32_buf[4*i + 3] = a ? 255 : 0;
     }
     
-    uint32_t width = rdp.texture_tile.line_size_bytes * 2;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes * 2;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
     
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
-static void import_texture_ci8(int tile) {
+static void import_texture_ci8(const struct TextureSource *src) {
     uint8_t rgba32_buf[16384];
     
-    for (uint32_t i = 0; i < rdp.loaded_texture[tile].size_bytes; i++) {
-        uint8_t idx = rdp.loaded_texture[tile].addr[i];
-        uint16_t col16 = (rdp.palette[idx * 2] << 8) | rdp.palette[idx * 2 + 1]; // Big endian load
+    for (uint32_t i = 0; i < src->size_bytes; i++) {
+        uint8_t idx = src->addr[i];
+        uint16_t col16 = (src->palette[idx * 2] << 8) | src->palette[idx * 2 + 1]; // Big endian load
         uint8_t a = col16 & 1;
         uint8_t r = col16 >> 11;
         uint8_t g = (col16 >> 6) & 0x1f;
@@ -721,52 +910,63 @@ static void import_texture_ci8(int tile) {
         rgba32_buf[4*i + 3] = a ? 255 : 0;
     }
     
-    uint32_t width = rdp.texture_tile.line_size_bytes;
-    uint32_t height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    uint32_t width = src->line_size_bytes;
+    uint32_t height = src->size_bytes / src->line_size_bytes;
     
-    gfx_rapi->upload_texture(rgba32_buf, width, height, GU_PSM_8888);
+    gfx_upload_texture(src, rgba32_buf, width, height, GU_PSM_8888);
 }
 
-static void import_texture(int tile) {
-    uint8_t fmt = rdp.texture_tile.fmt;
-    uint8_t siz = rdp.texture_tile.siz;
-    
-    if (gfx_texture_cache_lookup(tile, &rendering_state.textures[tile], rdp.loaded_texture[tile].addr, fmt, siz)) {
-        return;
-    }
+static void gfx_texture_source(int tile, struct TextureSource *src) {
+    src->addr = rdp.loaded_texture[tile].addr;
+    src->palette = rdp.palette;
+    src->size_bytes = rdp.loaded_texture[tile].size_bytes;
+    src->line_size_bytes = rdp.texture_tile.line_size_bytes;
+    src->fmt = rdp.texture_tile.fmt;
+    src->siz = rdp.texture_tile.siz;
+#ifdef GFX_2D_ATLAS
+    src->atlas = NULL;
+#endif
+#ifdef ASYNC_TEXTURES
+    src->job = NULL;
+#endif
+}
+
+static void gfx_decode_texture(const struct TextureSource *src) {
+    uint8_t fmt = src->fmt;
+    uint8_t siz = src->siz;
     
     //int t0 = get_time();
     if (fmt == G_IM_FMT_RGBA) {
         if (siz == G_IM_SIZ_16b) {
-            import_texture_rgba16(tile);
+            import_texture_rgba16(src);
         } else if (siz == G_IM_SIZ_32b) {
-            import_texture_rgba32(tile);
+            import_texture_rgba32(src);
         } else {
             abort();
         }
     } else if (fmt == G_IM_FMT_IA) {
         if (siz == G_IM_SIZ_4b) {
-            import_texture_ia4(tile);
+            import_texture_ia4(src);
         } else if (siz == G_IM_SIZ_8b) {
-            import_texture_ia8(tile);
+            import_texture_ia8(src);
         } else if (siz == G_IM_SIZ_16b) {
-            import_texture_ia16(tile);
+            import_texture_ia16(src);
         } else {
             abort();
         }
     } else if (fmt == G_IM_FMT_CI) {
         if (siz == G_IM_SIZ_4b) {
-            import_texture_ci4(tile);
+            import_texture_ci4(src);
         } else if (siz == G_IM_SIZ_8b) {
-            import_texture_ci8(tile);
+            import_texture_ci8(src);
         } else {
             abort();
         }
     } else if (fmt == G_IM_FMT_I) {
         if (siz == G_IM_SIZ_4b) {
-            import_texture_i4(tile);
+            import_texture_i4(src);
         } else if (siz == G_IM_SIZ_8b) {
-            import_texture_i8(tile);
+            import_texture_i8(src);
         } else {
             abort();
         }
@@ -777,6 +977,398 @@ static void import_texture(int tile) {
     //printf("Time diff: %d\n", t1 - t0);
 }
 
+#ifdef ASYNC_TEXTURES
+static uint32_t gfx_texture_texel_count(const struct TextureSource *src) {
+    switch (src->siz) {
+        case G_IM_SIZ_4b:
+            return src->size_bytes * 2;
+        case G_IM_SIZ_8b:
+            return src->size_bytes;
+        case G_IM_SIZ_16b:
+            return src->size_bytes / 2;
+        default:
+            return src->size_bytes / 4;
+    }
+}
+
+static struct RGBA gfx_texel_color(const struct TextureSource *src, uint32_t i) {
+    const uint8_t *addr = src->addr;
+    uint8_t v;
+    uint16_t col16;
+    switch (src->fmt) {
+        case G_IM_FMT_RGBA:
+            if (src->siz == G_IM_SIZ_32b) {
+                return (struct RGBA){addr[4 * i], addr[4 * i + 1], addr[4 * i + 2], addr[4 * i + 3]};
+            }
+            col16 = (addr[2 * i] << 8) | addr[2 * i + 1];
+            break;
+        case G_IM_FMT_IA:
+            if (src->siz == G_IM_SIZ_4b) {
+                v = (addr[i / 2] >> (4 - (i % 2) * 4)) & 0xf;
+                return (struct RGBA){SCALE_3_8(v >> 1), SCALE_3_8(v >> 1), SCALE_3_8(v >> 1), (v & 1) ? 255 : 0};
+            } else if (src->siz == G_IM_SIZ_8b) {
+                v = addr[i];
+                return (struct RGBA){SCALE_4_8(v >> 4), SCALE_4_8(v >> 4), SCALE_4_8(v >> 4), SCALE_4_8(v & 0xf)};
+            }
+            return (struct RGBA){addr[2 * i], addr[2 * i], addr[2 * i], addr[2 * i + 1]};
+        case G_IM_FMT_I:
+            v = src->siz == G_IM_SIZ_4b ? SCALE_4_8((addr[i / 2] >> (4 - (i % 2) * 4)) & 0xf) : addr[i];
+            return (struct RGBA){v, v, v, v};
+        case G_IM_FMT_CI:
+            v = src->siz == G_IM_SIZ_4b ? (addr[i / 2] >> (4 - (i % 2) * 4)) & 0xf : addr[i];
+            col16 = (src->palette[v * 2] << 8) | src->palette[v * 2 + 1];
+            break;
+        default:
+            return (struct RGBA){0x80, 0x80, 0x80, 0xff};
+    }
+    return (struct RGBA){SCALE_5_8(col16 >> 11), SCALE_5_8((col16 >> 6) & 0x1f), SCALE_5_8((col16 >> 1) & 0x1f), (col16 & 1) ? 255 : 0};
+}
+
+/* Uploads a small texture filled with the average of 16 texels spread over the source */
+static void gfx_texture_upload_placeholder(const struct TextureSource *src) {
+    uint32_t placeholder[TEXTURE_PLACEHOLDER_SIZE * TEXTURE_PLACEHOLDER_SIZE] __attribute__((aligned(16)));
+    uint32_t count = gfx_texture_texel_count(src);
+    uint32_t sum[4] = {0};
+    uint32_t samples = count < 16 ? count : 16;
+    for (uint32_t i = 0; i < samples; i++) {
+        struct RGBA c = gfx_texel_color(src, i * count / samples);
+        sum[0] += c.r;
+        sum[1] += c.g;
+        sum[2] += c.b;
+        sum[3] += c.a;
+    }
+    if (samples == 0) {
+        samples = 1;
+    }
+    uint32_t avg = (sum[3] / samples) << 24 | (sum[2] / samples) << 16 | (sum[1] / samples) << 8 | (sum[0] / samples);
+    for (int i = 0; i < TEXTURE_PLACEHOLDER_SIZE * TEXTURE_PLACEHOLDER_SIZE; i++) {
+        placeholder[i] = avg;
+    }
+    gfx_rapi->upload_texture((const uint8_t *)placeholder, TEXTURE_PLACEHOLDER_SIZE, TEXTURE_PLACEHOLDER_SIZE, GU_PSM_8888);
+}
+
+static struct TextureJob *gfx_texture_job_find(const uint8_t *addr, uint8_t fmt, uint8_t siz) {
+    for (int i = 0; i < TEXTURE_JOBS; i++) {
+        struct TextureJob *job = &gfx_texture_jobs.jobs[i];
+        if (job->state != TEXTURE_JOB_FREE && job->src.addr == addr && job->src.fmt == fmt && job->src.siz == siz) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void gfx_texture_job_release(struct TextureJob *job) {
+    if (job->node != NULL) {
+        job->node->pending = false;
+        job->node = NULL;
+    }
+    free(job->buf);
+    job->buf = NULL;
+    job->state = TEXTURE_JOB_FREE;
+}
+
+static struct TextureJob *gfx_texture_job_request(const struct TextureSource *src) {
+    struct TextureJob *job = NULL;
+    struct TextureJob *unclaimed = NULL;
+    for (int i = 0; i < TEXTURE_JOBS && job == NULL; i++) {
+        struct TextureJob *j = &gfx_texture_jobs.jobs[i];
+        if (j->state == TEXTURE_JOB_FREE) {
+            job = j;
+        } else if (j->state == TEXTURE_JOB_READY && j->node == NULL && (unclaimed == NULL || j->seq < unclaimed->seq)) {
+            unclaimed = j;
+        }
+    }
+    if (job == NULL && unclaimed != NULL) {
+        // Out of slots, give up the oldest prefetch nobody asked for yet
+        gfx_texture_job_release(unclaimed);
+        job = unclaimed;
+    }
+    if (job == NULL) {
+        return NULL;
+    }
+    job->buf = malloc(gfx_texture_texel_count(src) * 4);
+    if (job->buf == NULL) {
+        return NULL;
+    }
+    job->src = *src;
+    job->src.job = job;
+    job->node = NULL;
+    job->seq = gfx_texture_jobs.seq++;
+    job->frame = gfx_texture_jobs.frame;
+    job->state = TEXTURE_JOB_QUEUED;
+    sceKernelSignalSema(gfx_texture_jobs.queued_sema, 1);
+    return job;
+}
+
+/* Takes the oldest queued job for the calling thread to decode */
+static struct TextureJob *gfx_texture_job_claim(struct TextureJob *job) {
+    sceKernelWaitSema(gfx_texture_jobs.lock, 1, NULL);
+    if (job == NULL) {
+        for (int i = 0; i < TEXTURE_JOBS; i++) {
+            struct TextureJob *j = &gfx_texture_jobs.jobs[i];
+            if (j->state == TEXTURE_JOB_QUEUED && (job == NULL || j->seq < job->seq)) {
+                job = j;
+            }
+        }
+    }
+    if (job != NULL && job->state == TEXTURE_JOB_QUEUED) {
+        job->state = TEXTURE_JOB_DECODING;
+    } else {
+        job = NULL;
+    }
+    sceKernelSignalSema(gfx_texture_jobs.lock, 1);
+    return job;
+}
+
+static int gfx_texture_worker(SceSize args, void *argp) {
+    _UNUSED(args);
+    _UNUSED(argp);
+    for (;;) {
+        sceKernelWaitSema(gfx_texture_jobs.queued_sema, 1, NULL);
+        struct TextureJob *job = gfx_texture_job_claim(NULL);
+        if (job == NULL) {
+            // The render thread got to it first
+            continue;
+        }
+        unsigned long t0 = get_time();
+        gfx_decode_texture(&job->src);
+        gfx_texture_jobs.stats.decode_us += get_time() - t0;
+        job->state = TEXTURE_JOB_READY;
+    }
+    return 0;
+}
+
+static void gfx_texture_jobs_init(void) {
+    gfx_texture_jobs.lock = sceKernelCreateSema("texture_lock", 0, 1, 1, NULL);
+    gfx_texture_jobs.queued_sema = sceKernelCreateSema("texture_queue", 0, 0, TEXTURE_JOBS, NULL);
+    // Lower priority than the render thread, the decode buffers live on this stack
+    gfx_texture_jobs.thread = sceKernelCreateThread("texture_decode", gfx_texture_worker, 0x30, 0x10000, THREAD_ATTR_USER, NULL);
+    if (gfx_texture_jobs.thread >= 0) {
+        sceKernelStartThread(gfx_texture_jobs.thread, 0, NULL);
+    }
+}
+
+/* Makes sure nothing drawn last frame still shows a placeholder */
+static void gfx_texture_jobs_sync(void) {
+    gfx_texture_jobs.frame++;
+    for (int i = 0; i < TEXTURE_JOBS; i++) {
+        struct TextureJob *job = &gfx_texture_jobs.jobs[i];
+        if (job->node == NULL || job->frame == gfx_texture_jobs.frame) {
+            continue;
+        }
+        if (job->state != TEXTURE_JOB_QUEUED && job->state != TEXTURE_JOB_DECODING) {
+            continue;
+        }
+        unsigned long t0 = get_time();
+        if (gfx_texture_job_claim(job) != NULL) {
+            gfx_decode_texture(&job->src);
+            job->state = TEXTURE_JOB_READY;
+        }
+        while (job->state != TEXTURE_JOB_READY) {
+            sceKernelDelayThread(100);
+        }
+        gfx_texture_jobs.stats.stall_us += get_time() - t0;
+    }
+}
+
+/* Replaces a placeholder with the decoded texture once the worker is done with it. The texture
+   keeps the placeholder's number, texture numbers are only handed back when the manager clears. */
+static void gfx_texture_job_swap_in(struct TextureHashmapNode *node) {
+    for (int i = 0; i < TEXTURE_JOBS; i++) {
+        struct TextureJob *job = &gfx_texture_jobs.jobs[i];
+        if (job->node != node) {
+            continue;
+        }
+        if (job->state == TEXTURE_JOB_READY && gfx_vram_space_available()) {
+            texman_replace(node->texture_id);
+            gfx_rapi->upload_texture(job->buf, job->width, job->height, job->type);
+            gfx_texture_job_release(job);
+        }
+        return;
+    }
+    node->pending = false;
+}
+
+/* Handles a cache miss without decoding, returns false if it has to be decoded right away */
+static bool gfx_texture_job_import(struct TextureHashmapNode *node, const struct TextureSource *src) {
+    gfx_texture_jobs.stats.misses++;
+    struct TextureJob *job = gfx_texture_job_find(src->addr, src->fmt, src->siz);
+    if (job != NULL && job->state == TEXTURE_JOB_READY) {
+        // node already holds the newest texture, the upload goes straight into it
+        gfx_rapi->upload_texture(job->buf, job->width, job->height, job->type);
+        gfx_texture_job_release(job);
+        gfx_texture_jobs.stats.prefetch_hits++;
+        return true;
+    }
+    if (gfx_texture_jobs.thread < 0) {
+        return false;
+    }
+    if (job == NULL) {
+        job = gfx_texture_job_request(src);
+        if (job == NULL) {
+            gfx_texture_jobs.stats.sync_decodes++;
+            return false;
+        }
+    }
+    job->node = node;
+    job->frame = gfx_texture_jobs.frame;
+    node->pending = true;
+    gfx_texture_upload_placeholder(src);
+    gfx_texture_jobs.stats.placeholders++;
+    return true;
+}
+#endif
+
+static void import_texture(int tile) {
+    uint8_t fmt = rdp.texture_tile.fmt;
+    uint8_t siz = rdp.texture_tile.siz;
+    
+    if (gfx_texture_cache_lookup(tile, &rendering_state.textures[tile], rdp.loaded_texture[tile].addr, fmt, siz)) {
+#ifdef ASYNC_TEXTURES
+        if (rendering_state.textures[tile]->pending) {
+            gfx_texture_job_swap_in(rendering_state.textures[tile]);
+        }
+#endif
+        return;
+    }
+    struct TextureSource src;
+    gfx_texture_source(tile, &src);
+#ifdef ASYNC_TEXTURES
+    if (gfx_texture_job_import(rendering_state.textures[tile], &src)) {
+        return;
+    }
+#endif
+    gfx_decode_texture(&src);
+}
+
+#ifdef GFX_2D_ATLAS
+static struct AtlasPage *gfx_atlas_new_page(void) {
+    if (gfx_atlas.num_pages == ATLAS_MAX_PAGES || !gfx_vram_space_available()) {
+        return NULL;
+    }
+    struct AtlasPage *page = &gfx_atlas.pages[gfx_atlas.num_pages++];
+    page->node.texture_id = gfx_rapi->new_texture();
+    struct PSP_Texture *tex = texman_reserve_memory(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, GU_PSM_5551);
+    tex->width = ATLAS_PAGE_SIZE;
+    tex->height = ATLAS_PAGE_SIZE;
+    tex->type = GU_PSM_5551;
+    tex->swizzled = GU_FALSE;
+    page->texels = (uint16_t *)tex->location;
+    memset(page->texels, 0, ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * sizeof(uint16_t));
+    sceKernelDcacheWritebackRange(page->texels, ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * sizeof(uint16_t));
+    page->shelf_x = page->shelf_y = page->shelf_height = 0;
+    return page;
+}
+
+/* Shelf packer: fill rows left to right, open a new shelf below when a row runs out */
+static bool gfx_atlas_alloc(uint32_t width, uint32_t height, struct AtlasEntry *entry) {
+    width += 2 * ATLAS_GUTTER;
+    height += 2 * ATLAS_GUTTER;
+    for (uint32_t i = 0; i <= gfx_atlas.num_pages; i++) {
+        struct AtlasPage *page = i < gfx_atlas.num_pages ? &gfx_atlas.pages[i] : gfx_atlas_new_page();
+        if (page == NULL) {
+            return false;
+        }
+        if (page->shelf_x + width > ATLAS_PAGE_SIZE) {
+            page->shelf_x = 0;
+            page->shelf_y += page->shelf_height;
+            page->shelf_height = 0;
+        }
+        if (page->shelf_y + height > ATLAS_PAGE_SIZE) {
+            continue;
+        }
+        entry->page = i;
+        entry->x = page->shelf_x + ATLAS_GUTTER;
+        entry->y = page->shelf_y + ATLAS_GUTTER;
+        page->shelf_x += width;
+        if (height > page->shelf_height) {
+            page->shelf_height = height;
+        }
+        return true;
+    }
+    return false;
+}
+
+/* Formats whose decoded texels survive the trip to 5551 unchanged */
+static bool gfx_atlas_format_supported(uint8_t fmt, uint8_t siz, uint32_t *width) {
+    const uint32_t line_size_bytes = rdp.texture_tile.line_size_bytes;
+    if (fmt == G_IM_FMT_RGBA && siz == G_IM_SIZ_16b) {
+        *width = line_size_bytes / 2;
+    } else if ((fmt == G_IM_FMT_IA || fmt == G_IM_FMT_CI) && siz == G_IM_SIZ_4b) {
+        *width = line_size_bytes * 2;
+    } else if (fmt == G_IM_FMT_CI && siz == G_IM_SIZ_8b) {
+        *width = line_size_bytes;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* The gutter only makes clamped sampling inside the texture safe, a rect that wraps, mirrors
+   or reads past the edges would pick up its neighbours on the page */
+static bool gfx_atlas_can_sample(uint32_t width, uint32_t height, const short uv[2][2]) {
+    if (rdp.texture_tile.cms != G_TX_CLAMP || rdp.texture_tile.cmt != G_TX_CLAMP) {
+        return false;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (uv[i][0] < 0 || uv[i][0] > (int)width || uv[i][1] < 0 || uv[i][1] > (int)height) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Finds or places the texture loaded in tile inside the atlas, NULL if it doesn't fit there
+   or the rect with these texel coordinates can't be drawn from it */
+static const struct AtlasEntry *gfx_atlas_lookup(int tile, const short uv[2][2]) {
+    const uint8_t *orig_addr = rdp.loaded_texture[tile].addr;
+    uint8_t fmt = rdp.texture_tile.fmt;
+    uint8_t siz = rdp.texture_tile.siz;
+    
+    size_t hash = ((uintptr_t)orig_addr >> 5) & 0xff;
+    struct AtlasEntry **node = &gfx_atlas.hashmap[hash];
+    while (*node != NULL && *node - gfx_atlas.pool < (int)gfx_atlas.pool_pos) {
+        if ((*node)->texture_addr == orig_addr && (*node)->fmt == fmt && (*node)->siz == siz) {
+            return gfx_atlas_can_sample((*node)->width, (*node)->height, uv) ? *node : NULL;
+        }
+        node = &(*node)->next;
+    }
+    
+    uint32_t width, height;
+    if (gfx_atlas.full || rdp.texture_tile.line_size_bytes == 0 || !gfx_atlas_format_supported(fmt, siz, &width)) {
+        return NULL;
+    }
+    height = rdp.loaded_texture[tile].size_bytes / rdp.texture_tile.line_size_bytes;
+    if (width == 0 || height == 0 || width > ATLAS_MAX_DIM || height > ATLAS_MAX_DIM || !gfx_atlas_can_sample(width, height, uv)) {
+        return NULL;
+    }
+    if (gfx_atlas.pool_pos == sizeof(gfx_atlas.pool) / sizeof(struct AtlasEntry)) {
+        gfx_atlas.full = true;
+        return NULL;
+    }
+    
+    struct AtlasEntry *entry = &gfx_atlas.pool[gfx_atlas.pool_pos];
+    if (!gfx_atlas_alloc(width, height, entry)) {
+        gfx_atlas.full = true;
+        return NULL;
+    }
+    gfx_atlas.pool_pos++;
+    entry->next = NULL;
+    entry->texture_addr = orig_addr;
+    entry->fmt = fmt;
+    entry->siz = siz;
+    entry->width = width;
+    entry->height = height;
+    *node = entry;
+    
+    struct TextureSource src;
+    gfx_texture_source(tile, &src);
+    src.atlas = entry;
+    gfx_decode_texture(&src);
+    return entry;
+}
+#endif
+
 static inline float dot(const float a[3], const float b[3])
 {
     return (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]);
@@ -1191,11 +1783,21 @@ static void gfx_sp_tri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx) {
 
     for (int i = 0; i < 2; i++) {
         if (used_textures[i]) {
+#ifdef GFX_2D_ATLAS
+            /* An atlas page has the texture at an offset that 3D UVs don't account for */
+            if (rdp.textures_changed[i] || atlas_entries[i] != NULL) {
+                gfx_flush();
+                import_texture(i);
+                rdp.textures_changed[i] = false;
+                atlas_entries[i] = NULL;
+            }
+#else
             if (rdp.textures_changed[i]) {
                 gfx_flush();
                 import_texture(i);
                 rdp.textures_changed[i] = false;
             }
+#endif
             bool linear_filter = (rdp.other_mode_h & (3U << G_MDSFT_TEXTFILT)) != G_TF_POINT;
             if (linear_filter != rendering_state.textures[i]->linear_filter || rdp.texture_tile.cms != rendering_state.textures[i]->cms || rdp.texture_tile.cmt != rendering_state.textures[i]->cmt) {
                 gfx_flush();
@@ -1210,12 +1812,24 @@ static void gfx_sp_tri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx) {
     bool use_texture = used_textures[0] || used_textures[1];
     uint32_t tex_width = (rdp.texture_tile.lrs - rdp.texture_tile.uls + 4) / 4;
     uint32_t tex_height = (rdp.texture_tile.lrt - rdp.texture_tile.ult + 4) / 4;
+
+    /* Pick the smallest vertex the backend takes that still has what the shader needs */
+    uint32_t vertex_format = GFX_VERTEX_FORMAT_FULL;
+    if (!use_texture && (vertex_formats & GFX_VERTEX_FORMAT_NO_TEXCOORD)) {
+        vertex_format = GFX_VERTEX_FORMAT_NO_TEXCOORD;
+    }
+    if (vertex_format != buf_vbo_format) {
+        gfx_flush();
+        gfx_rapi->set_vertex_format(vertex_format);
+        buf_vbo_format = vertex_format;
+    }
     
     size_t i;
+    psp_fast_t vtx;
     for (i = 0; i < clipped_vertices_num; i++) {
-        buf_vbo[buf_num_vert].x = clipped_vertices[i]->x;
-        buf_vbo[buf_num_vert].y = clipped_vertices[i]->y;
-        buf_vbo[buf_num_vert].z = clipped_vertices[i]->z;
+        vtx.x = clipped_vertices[i]->x;
+        vtx.y = clipped_vertices[i]->y;
+        vtx.z = clipped_vertices[i]->z;
         
         if (use_texture) {
             float u = (clipped_vertices[i]->u - rdp.texture_tile.uls * 8) / 32.0f;
@@ -1225,11 +1839,11 @@ static void gfx_sp_tri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx) {
                 u += 0.5f;
                 v += 0.5f;
             }
-            buf_vbo[buf_num_vert].u = u / tex_width;
-            buf_vbo[buf_num_vert].v = v / tex_height;
+            vtx.u = u / tex_width;
+            vtx.v = v / tex_height;
         } else {
-            buf_vbo[buf_num_vert].u = 0;
-            buf_vbo[buf_num_vert].v = 0;
+            vtx.u = 0;
+            vtx.v = 0;
         }
         
         /*
@@ -1290,20 +1904,30 @@ static void gfx_sp_tri1(uint8_t vtx1_idx, uint8_t vtx2_idx, uint8_t vtx3_idx) {
 
             }
         }
-        memcpy(&buf_vbo[buf_num_vert].color, color, sizeof(struct RGBA));
+        memcpy(&vtx.color, color, sizeof(struct RGBA));
 
         /*@Note: Blue Star color */
         if((rendering_state.shader_program->shader_id == 0x01200200)){
-            memcpy(&buf_vbo[buf_num_vert].color, &clipped_vertices[0]->color, sizeof(struct RGBA));
+            memcpy(&vtx.color, &clipped_vertices[0]->color, sizeof(struct RGBA));
             if(rdp.env_color.a != 255){
-                buf_vbo[buf_num_vert].color.a = rdp.env_color.a;
+                vtx.color.a = rdp.env_color.a;
             }
         }
         if((rendering_state.shader_program->shader_id == 0x01A00045)){
             color = &tmp;
         }
+        if (buf_vbo_format == GFX_VERTEX_FORMAT_NO_TEXCOORD) {
+            psp_fast_notex_t *out = (psp_fast_notex_t *)((uint8_t *)buf_vbo + buf_vbo_len);
+            out->color = vtx.color;
+            out->x = vtx.x;
+            out->y = vtx.y;
+            out->z = vtx.z;
+            buf_vbo_len += sizeof(psp_fast_notex_t);
+        } else {
+            *(psp_fast_t *)((uint8_t *)buf_vbo + buf_vbo_len) = vtx;
+            buf_vbo_len += sizeof(psp_fast_t);
+        }
         buf_num_vert++;
-        buf_vbo_len += sizeof(psp_fast_t);
     }
     buf_vbo_num_tris += clipped_vertices_num/3;
     if (buf_vbo_num_tris == MAX_BUFFERED) {
@@ -1317,6 +1941,11 @@ static void gfx_sp_tri1_2d(uint8_t vtx1_idx, uint8_t vtx2_idx, UNUSED uint8_t vt
     struct VertexColor *v2 = &rsp.loaded_vertices_2D[vtx2_idx];
     struct VertexColor *v_arr[2] = {v1, v2};
 
+    /* Queued triangles have to go out before any sprite drawn after them */
+    if (buf_vbo_len > 0) {
+        gfx_flush();
+    }
+
     bool depth_test = (rsp.geometry_mode & G_ZBUFFER) == G_ZBUFFER;
     if (depth_test != rendering_state.depth_test) {
         gfx_flush();
@@ -1389,13 +2018,55 @@ static void gfx_sp_tri1_2d(uint8_t vtx1_idx, uint8_t vtx2_idx, UNUSED uint8_t vt
     bool used_textures[2];
     gfx_rapi->shader_get_info(prg, &num_inputs, used_textures);
     
+    /* Texel coordinates of both corners, relative to the loaded tile */
+    short uv[2][2];
+    for (int i = 0; i < 2; i++) {
+        uv[i][0] = (v_arr[i]->u - rdp.texture_tile.uls * 8) / 32;
+        uv[i][1] = (v_arr[i]->v - rdp.texture_tile.ult * 8) / 32;
+    }
+    
     for (int i = 0; i < 2; i++) {
         if (used_textures[i]) {
+#ifdef GFX_2D_ATLAS
+            /* The atlas entry still bound may not suit this rect's addressing or coordinates */
+            if (rdp.textures_changed[i] || (atlas_entries[i] != NULL && !gfx_atlas_can_sample(atlas_entries[i]->width, atlas_entries[i]->height, uv))) {
+#ifdef GFX_2D_BENCHMARK
+                gfx_2d_stats.texture_changes++;
+#endif
+                /* only tile 0 gets its coordinates moved onto the page */
+                const struct AtlasEntry *entry = i == 0 ? gfx_atlas_lookup(i, uv) : NULL;
+                if (entry != NULL) {
+                    struct TextureHashmapNode *page = &gfx_atlas.pages[entry->page].node;
+                    if (rendering_state.textures[i] != page) {
+                        gfx_flush();
+                        gfx_rapi->select_texture(i, page->texture_id);
+                        gfx_rapi->set_sampler_parameters(i, page->linear_filter, page->cms, page->cmt);
+                        rendering_state.textures[i] = page;
+#ifdef GFX_2D_BENCHMARK
+                        gfx_2d_stats.binds++;
+#endif
+                    }
+                } else {
+                    gfx_flush();
+                    import_texture(i);
+#ifdef GFX_2D_BENCHMARK
+                    gfx_2d_stats.binds++;
+#endif
+                }
+                atlas_entries[i] = entry;
+                rdp.textures_changed[i] = false;
+            }
+#else
             if (rdp.textures_changed[i]) {
+#ifdef GFX_2D_BENCHMARK
+                gfx_2d_stats.texture_changes++;
+                gfx_2d_stats.binds++;
+#endif
                 gfx_flush();
                 import_texture(i);
                 rdp.textures_changed[i] = false;
             }
+#endif
             bool linear_filter = (rdp.other_mode_h & (3U << G_MDSFT_TEXTFILT)) != G_TF_POINT;
             if (linear_filter != rendering_state.textures[i]->linear_filter || rdp.texture_tile.cms != rendering_state.textures[i]->cms || rdp.texture_tile.cmt != rendering_state.textures[i]->cmt) {
                 gfx_flush();
@@ -1411,7 +2082,7 @@ static void gfx_sp_tri1_2d(uint8_t vtx1_idx, uint8_t vtx2_idx, UNUSED uint8_t vt
     //uint32_t tex_width = (rdp.texture_tile.lrs - rdp.texture_tile.uls + 4) / 4;
     //uint32_t tex_height = (rdp.texture_tile.lrt - rdp.texture_tile.ult + 4) / 4;
 
-    VertexColor tri_buf[2] = {{0}};
+    VertexColor *tri_buf = &sprite_vbo[sprite_vbo_num * 2];
     int tri_num_vert = 0;
     
     for (int i = 0; i < 2; i++) {
@@ -1420,8 +2091,14 @@ static void gfx_sp_tri1_2d(uint8_t vtx1_idx, uint8_t vtx2_idx, UNUSED uint8_t vt
         tri_buf[tri_num_vert].z = 0;
         
         if (use_texture) {
-            short u = (v_arr[i]->u - rdp.texture_tile.uls * 8)/ 32;
-            short v = (v_arr[i]->v - rdp.texture_tile.ult * 8) / 32;
+            short u = uv[i][0];
+            short v = uv[i][1];
+#ifdef GFX_2D_ATLAS
+            if (atlas_entries[0] != NULL) {
+                u += atlas_entries[0]->x;
+                v += atlas_entries[0]->y;
+            }
+#endif
             /*
             if ((rdp.other_mode_h & (3U << G_MDSFT_TEXTFILT)) != G_TF_POINT) {
                 // Linear filter adds 0.5f to the coordinates
@@ -1497,7 +2174,12 @@ static void gfx_sp_tri1_2d(uint8_t vtx1_idx, uint8_t vtx2_idx, UNUSED uint8_t vt
         memcpy(&tri_buf[tri_num_vert].color, color, sizeof(struct RGBA));
         tri_num_vert++;
     }
-    gfx_scegu_draw_triangles_2d((float*)&tri_buf[0],0,1);
+#ifdef GFX_2D_BENCHMARK
+    gfx_2d_stats.rects++;
+#endif
+    if (++sprite_vbo_num == MAX_BUFFERED_SPRITES) {
+        gfx_flush_sprites();
+    }
 }
 
 static void gfx_sp_geometry_mode(uint32_t clear, uint32_t set) {
@@ -2154,6 +2836,108 @@ static void gfx_run_dl(Gfx* cmd) {
     }
 }
 
+#ifdef ASYNC_TEXTURES
+static bool gfx_texture_cache_contains(const uint8_t *addr, uint8_t fmt, uint8_t siz) {
+    size_t hash = ((uintptr_t)addr >> 5) & 0x3ff;
+    struct TextureHashmapNode *node = gfx_texture_cache.hashmap[hash];
+    while (node != NULL && node - gfx_texture_cache.pool < (int)gfx_texture_cache.pool_pos) {
+        if (node->texture_addr == addr && node->fmt == fmt && node->siz == siz) {
+            return true;
+        }
+        node = node->next;
+    }
+    return false;
+}
+
+/* Walks a display list the way gfx_run_dl does, but only follows texture loads */
+struct PrefetchState {
+    const uint8_t *timg;
+    uint8_t timg_siz, load_tile;
+    const uint8_t *loaded_addr[2];
+    uint32_t loaded_size[2];
+    struct TextureSource src;
+    uint32_t budget;
+};
+
+static void gfx_prefetch_dl(struct PrefetchState *st, const Gfx *cmd, int depth) {
+    uint32_t word_size_shift;
+    for (; st->budget > 0; st->budget--) {
+        uint32_t opcode = cmd->words.w0 >> 24;
+        switch (opcode) {
+            case G_DL:
+                if (C0(16, 1) == 0) {
+                    if (depth < 10) {
+                        gfx_prefetch_dl(st, (const Gfx *)seg_addr(cmd->words.w1), depth + 1);
+                    }
+                } else {
+                    cmd = (const Gfx *)seg_addr(cmd->words.w1);
+                    --cmd;
+                }
+                break;
+            case (uint8_t)G_ENDDL:
+                return;
+            case G_SETTIMG:
+                st->timg = seg_addr(cmd->words.w1);
+                st->timg_siz = C0(19, 2);
+                break;
+            case G_LOADTLUT:
+                st->src.palette = st->timg;
+                break;
+            case G_LOADBLOCK:
+                if (C1(24, 3) == G_TX_LOADTILE && st->load_tile < 2) {
+                    word_size_shift = st->timg_siz == G_IM_SIZ_16b ? 1 : (st->timg_siz == G_IM_SIZ_32b ? 2 : 0);
+                    st->loaded_addr[st->load_tile] = st->timg;
+                    st->loaded_size[st->load_tile] = (C1(12, 12) + 1) << word_size_shift;
+                }
+                break;
+            case G_SETTILE:
+                if (C1(24, 3) == G_TX_RENDERTILE) {
+                    st->src.fmt = C0(21, 3);
+                    st->src.siz = C0(19, 2);
+                    st->src.line_size_bytes = C0(9, 9) * 8;
+                } else if (C1(24, 3) == G_TX_LOADTILE) {
+                    st->load_tile = C0(0, 9) / 256;
+                }
+                break;
+            case G_SETTILESIZE:
+                // Last command of a texture load, the texture is fully described now
+                st->src.addr = st->loaded_addr[0];
+                st->src.size_bytes = st->loaded_size[0];
+                if (C1(24, 3) == G_TX_RENDERTILE && st->src.addr != NULL && st->src.size_bytes <= 4096 && st->src.line_size_bytes != 0
+                    && !gfx_texture_cache_contains(st->src.addr, st->src.fmt, st->src.siz)
+                    && gfx_texture_job_find(st->src.addr, st->src.fmt, st->src.siz) == NULL) {
+                    if (gfx_texture_job_request(&st->src) == NULL) {
+                        st->budget = 0;
+                        return;
+                    }
+                    gfx_texture_jobs.stats.prefetches++;
+                }
+                break;
+            case G_TEXRECT:
+            case G_TEXRECTFLIP:
+                cmd += 2;
+                break;
+#ifdef F3DEX_GBI_2E
+            case G_FILLRECT:
+                ++cmd;
+                break;
+#endif
+        }
+        ++cmd;
+    }
+}
+
+void gfx_prefetch_textures(const Gfx *dl) {
+    static struct PrefetchState st;
+    if (dl == NULL || gfx_texture_jobs.thread < 0) {
+        return;
+    }
+    memset(&st, 0, sizeof(st));
+    st.budget = 0x10000;
+    gfx_prefetch_dl(&st, dl, 0);
+}
+#endif
+
 static void gfx_sp_reset() {
     rsp.modelview_matrix_stack_size = 1;
     rsp.current_num_lights = 2;
@@ -2176,6 +2960,10 @@ void gfx_init(struct GfxWindowManagerAPI *wapi, struct GfxRenderingAPI *rapi, co
     gfx_rapi = rapi;
     gfx_wapi->init(game_name, start_in_fullscreen);
     gfx_rapi->init();
+    vertex_formats = gfx_rapi->get_vertex_formats();
+#ifdef ASYNC_TEXTURES
+    gfx_texture_jobs_init();
+#endif
 
     int i;
     for(i=0;i<30;i++){
@@ -2255,6 +3043,9 @@ void gfx_run(Gfx *commands) {
     //double t0 = gfx_wapi->get_time();
     unsigned int t0 = sceKernelLibcClock();
     gfx_rapi->start_frame();
+#ifdef ASYNC_TEXTURES
+    gfx_texture_jobs_sync();
+#endif
     gfx_run_dl(commands);
     gfx_flush();
     gfx_rapi->end_frame();
@@ -2278,6 +3069,27 @@ void gfx_run(Gfx *commands) {
     if(total_frame_counter == 200){
         printf("GFX FRAME 250 TIME TAKEN: %2.3f ms FPS %2.3f, AVG: %2.3f ms \n",  time_first_200, (250*1000)/time_first_200, 1000/(250/time_first_200));
     }
+    if((total_frame_counter % 300) == 0){
+#ifdef GFX_2D_BENCHMARK
+        /* without the atlas and batching every rect is a draw and every texture change a bind */
+        printf("GFX 2D: %u rects, %u draws (was %u), %u binds (was %u)\n",
+            (unsigned)gfx_2d_stats.rects, (unsigned)gfx_2d_stats.draws, (unsigned)gfx_2d_stats.rects,
+            (unsigned)gfx_2d_stats.binds, (unsigned)gfx_2d_stats.texture_changes);
+#ifdef GFX_2D_ATLAS
+        printf("GFX 2D ATLAS: %u entries on %u pages\n", (unsigned)gfx_atlas.pool_pos, (unsigned)gfx_atlas.num_pages);
+#endif
+        memset(&gfx_2d_stats, 0, sizeof(gfx_2d_stats));
+#endif
+#ifdef ASYNC_TEXTURES
+        /* decode time moved to the worker is what the render thread would have stalled for */
+        printf("GFX ASYNC TEX: %u misses, %u placeholders, %u/%u prefetches used, %u sync, %u us decoded off-thread, %u us stalled\n",
+            (unsigned)gfx_texture_jobs.stats.misses, (unsigned)gfx_texture_jobs.stats.placeholders,
+            (unsigned)gfx_texture_jobs.stats.prefetch_hits, (unsigned)gfx_texture_jobs.stats.prefetches,
+            (unsigned)gfx_texture_jobs.stats.sync_decodes, (unsigned)gfx_texture_jobs.stats.decode_us,
+            (unsigned)gfx_texture_jobs.stats.stall_us);
+        memset(&gfx_texture_jobs.stats, 0, sizeof(gfx_texture_jobs.stats));
+#endif
+    }
 }
 
 void gfx_end_frame(void) {
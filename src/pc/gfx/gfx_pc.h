@@ -22,6 +22,9 @@ struct GfxRenderingAPI *gfx_get_current_rendering_api(void);
 void gfx_start_frame(void);
 void gfx_run(Gfx *commands);
 void gfx_end_frame(void);
+#ifdef ASYNC_TEXTURES
+void gfx_prefetch_textures(const Gfx *dl);
+#endif
 
 #ifdef __cplusplus
 }
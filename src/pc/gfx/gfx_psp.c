@@ -24,6 +24,8 @@
 
 static int force_30fps = 1;
 static unsigned int last_time = 0;
+// Number of microseconds a frame should take (30 fps unless changed)
+static unsigned int frame_time_us = 33333;
 int audio_manager_thid = 0;
 
 /* I forgot why we need this */
@@ -148,19 +150,17 @@ static bool gfx_psp_start_frame(void) {
 }
 
 static void gfx_psp_swap_buffers_begin(void) {
-    // Number of microseconds a frame should take (30 fps)
-    const unsigned int FRAME_TIME_US = 33333;
     const unsigned int cur_time = sceKernelGetSystemTimeLow();
     const unsigned int elapsed = cur_time - last_time;
     last_time = cur_time;
 
     if (force_30fps) {
-        if (elapsed < FRAME_TIME_US) {
+        if (elapsed < frame_time_us) {
 #ifdef DEBUG
             printf("elapsed %d us fps %f\n", elapsed, (1000.0f * 1000.0f) / elapsed);
 #endif
-            sceKernelDelayThread(FRAME_TIME_US - elapsed);
-            last_time = cur_time + (FRAME_TIME_US - elapsed);
+            sceKernelDelayThread(frame_time_us - elapsed);
+            last_time = cur_time + (frame_time_us - elapsed);
         }
     }
 }
@@ -175,6 +175,10 @@ static double gfx_psp_get_time(void) {
     return 0.0;
 }
 
+static void gfx_psp_set_target_fps(uint32_t fps) {
+    frame_time_us = 1000000 / fps;
+}
+
 struct GfxWindowManagerAPI gfx_psp = {
     gfx_psp_init,
     gfx_psp_set_keyboard_callbacks,
@@ -186,6 +190,7 @@ struct GfxWindowManagerAPI gfx_psp = {
     gfx_psp_start_frame,
     gfx_psp_swap_buffers_begin,
     gfx_psp_swap_buffers_end,
-    gfx_psp_get_time
+    gfx_psp_get_time,
+    gfx_psp_set_target_fps
 };
 #endif // TARGET_PSP
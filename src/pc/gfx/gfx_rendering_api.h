@@ -7,6 +7,12 @@
 
 struct ShaderProgram;
 
+// Vertex layouts for draw_triangles. Every backend takes its full native
+// vertex, the others are advertised by get_vertex_formats and only used
+// when the current shader doesn't need what they leave out.
+#define GFX_VERTEX_FORMAT_FULL        (1 << 0)
+#define GFX_VERTEX_FORMAT_NO_TEXCOORD (1 << 1) // colour and position only, for untextured shaders
+
 struct GfxRenderingAPI {
     bool (*z_is_from_0_to_1)(void);
     void (*unload_shader)(struct ShaderProgram *old_prg);
@@ -29,6 +35,8 @@ struct GfxRenderingAPI {
     void (*set_scissor)(int x, int y, int width, int height);
     void (*set_use_alpha)(bool use_alpha);
     void (*draw_triangles)(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris);
+    uint32_t (*get_vertex_formats)(void);
+    void (*set_vertex_format)(uint32_t format);
     void (*init)(void);
     void (*on_resize)(void);
     void (*start_frame)(void);
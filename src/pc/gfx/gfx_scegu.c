@@ -237,6 +237,11 @@ typedef struct Vertex {
     float x, y, z;
 } Vertex;
 
+typedef struct VertexNoTex {
+    unsigned int color;
+    float x, y, z;
+} VertexNoTex;
+
 typedef struct VertexColor {
     unsigned short a, b;
     unsigned long color;
@@ -669,27 +674,44 @@ static inline void gfx_scegu_blend_fog_tris(void) {
 }
 
 extern void memcpy_vfpu(void *dst, const void *src, size_t size);
-static void gfx_scegu_draw_triangles(float buf_vbo[], UNUSED size_t buf_vbo_len, size_t buf_vbo_num_tris) {
+static uint32_t cur_vertex_format = GFX_VERTEX_FORMAT_FULL;
+
+static void gfx_scegu_draw_triangles(float buf_vbo[], size_t buf_vbo_len, size_t buf_vbo_num_tris) {
     if (!is_shader_enabled(cur_shader->shader_id)) {
         gfx_scegu_apply_shader(get_shader_from_id(get_shader_remap(cur_shader->shader_id)));
     }
 
-    void *buf = sceGuGetMemory(sizeof(Vertex) * 3 * buf_vbo_num_tris);
-    memcpy_vfpu(buf, buf_vbo, sizeof(Vertex) * 3 * buf_vbo_num_tris);
-    sceGuDrawArray(GU_TRIANGLES, GU_TEXTURE_32BITF | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, 3 * buf_vbo_num_tris, 0, buf);
+    /* buf_vbo_len is in bytes, untextured batches come in as VertexNoTex */
+    int vtype = GU_TEXTURE_32BITF | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D;
+    if (cur_vertex_format == GFX_VERTEX_FORMAT_NO_TEXCOORD) {
+        vtype = GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D;
+    }
+
+    void *buf = sceGuGetMemory(buf_vbo_len);
+    memcpy_vfpu(buf, buf_vbo, buf_vbo_len);
+    sceGuDrawArray(GU_TRIANGLES, vtype, 3 * buf_vbo_num_tris, 0, buf);
 
     // cur_fog_ofs is only set if GL_EXT_fog_coord isn't used
     // if (cur_fog_ofs) gfx_scegu_blend_fog_tris();
 }
 
-void gfx_scegu_draw_triangles_2d(float buf_vbo[], UNUSED size_t buf_vbo_len, UNUSED size_t buf_vbo_num_tris) {
+static uint32_t gfx_scegu_get_vertex_formats(void) {
+    return GFX_VERTEX_FORMAT_FULL | GFX_VERTEX_FORMAT_NO_TEXCOORD;
+}
+
+static void gfx_scegu_set_vertex_format(uint32_t format) {
+    cur_vertex_format = format;
+}
+
+/* buf_vbo_num_tris is the number of sprites here, 2 vertices each */
+void gfx_scegu_draw_triangles_2d(float buf_vbo[], UNUSED size_t buf_vbo_len, size_t buf_vbo_num_tris) {
     if (!is_shader_enabled(cur_shader->shader_id)) {
         gfx_scegu_apply_shader(get_shader_from_id(get_shader_remap(cur_shader->shader_id)));
     }
 
-    void *quad_buf = sceGuGetMemory(sizeof(VertexColor) * 2);
-    memcpy(quad_buf, buf_vbo, sizeof(VertexColor) * 2);
-    sceGuDrawArray(GU_SPRITES, GU_TEXTURE_16BIT | GU_COLOR_8888 | GU_VERTEX_16BIT | GU_TRANSFORM_2D, 2, 0, quad_buf);
+    void *quad_buf = sceGuGetMemory(sizeof(VertexColor) * 2 * buf_vbo_num_tris);
+    memcpy(quad_buf, buf_vbo, sizeof(VertexColor) * 2 * buf_vbo_num_tris);
+    sceGuDrawArray(GU_SPRITES, GU_TEXTURE_16BIT | GU_COLOR_8888 | GU_VERTEX_16BIT | GU_TRANSFORM_2D, 2 * buf_vbo_num_tris, 0, quad_buf);
 }
 
 static void gfx_scegu_init(void) {
@@ -811,6 +833,8 @@ struct GfxRenderingAPI gfx_opengl_api = {
     gfx_scegu_set_scissor,
     gfx_scegu_set_use_alpha,
     gfx_scegu_draw_triangles,
+    gfx_scegu_get_vertex_formats,
+    gfx_scegu_set_vertex_format,
     gfx_scegu_init,
     gfx_scegu_on_resize,
     gfx_scegu_start_frame,
@@ -272,15 +272,16 @@ static bool gfx_sdl_start_frame(void) {
     return true;
 }
 
+// Number of microseconds a frame should take (30 fps unless changed)
+static Uint32 frame_time_us = 1000000 / 30;
+
 static void sync_framerate_with_timer(void) {
-    // Number of milliseconds a frame should take (30 fps)
-    const Uint32 FRAME_TIME = 1000 / 30;
-    static Uint32 last_time;
-    Uint32 elapsed = SDL_GetTicks() - last_time;
-
-    if (elapsed < FRAME_TIME)
-        SDL_Delay(FRAME_TIME - elapsed);
-    last_time += FRAME_TIME;
+    static Uint64 last_time_us;
+    Uint64 elapsed = (Uint64)SDL_GetTicks() * 1000 - last_time_us;
+
+    if (elapsed < frame_time_us)
+        SDL_Delay((frame_time_us - elapsed) / 1000);
+    last_time_us += frame_time_us;
 }
 
 static void gfx_sdl_swap_buffers_begin(void) {
@@ -298,6 +299,10 @@ static double gfx_sdl_get_time(void) {
     return 0.0;
 }
 
+static void gfx_sdl_set_target_fps(uint32_t fps) {
+    frame_time_us = 1000000 / fps;
+}
+
 struct GfxWindowManagerAPI gfx_sdl = {
     gfx_sdl_init,
     gfx_sdl_set_keyboard_callbacks,
@@ -309,7 +314,8 @@ struct GfxWindowManagerAPI gfx_sdl = {
     gfx_sdl_start_frame,
     gfx_sdl_swap_buffers_begin,
     gfx_sdl_swap_buffers_end,
-    gfx_sdl_get_time
+    gfx_sdl_get_time,
+    gfx_sdl_set_target_fps
 };
 
 #endif
@@ -23,6 +23,7 @@ static void *psp_tex_buffer = NULL;
 static void *psp_tex_buffer_start = NULL;
 static void *psp_tex_buffer_max = NULL;
 static unsigned int psp_tex_number = 0;
+static unsigned int psp_tex_upload = 0; /* texture the next upload goes into */
 unsigned int psp_tex_bound = 0;
 
 static inline unsigned int getMemorySize(int width, int height, unsigned int psm) {
@@ -109,6 +110,7 @@ int texman_inited(void) {
 void texman_reset(void *buf, unsigned int size) {
     memset(textures, 0, sizeof(textures));
     psp_tex_number = 0;
+    psp_tex_upload = 0;
     psp_tex_buffer = psp_tex_buffer_start = buf;
     psp_tex_buffer_max = buf + size;
 #ifdef DEBUG
@@ -121,6 +123,7 @@ void texman_reset(void *buf, unsigned int size) {
 void texman_clear(void) {
     memset(textures, 0, sizeof(textures));
     psp_tex_number = 0;
+    psp_tex_upload = 0;
     psp_tex_buffer = psp_tex_buffer_start;
 #ifdef DEBUG
     char msg[64];
@@ -152,11 +155,11 @@ struct PSP_Texture *texman_reserve_memory(int width, int height, unsigned int ty
         (void *) ((((unsigned int) psp_tex_buffer + tex_size + TEX_ALIGNMENT - 1) / TEX_ALIGNMENT)
                   * TEX_ALIGNMENT);
 #ifdef DEBUG
-    printf("TEX_MAN tex [%d] reserved %d bytes @ %x left: %d kb\n", psp_tex_number, tex_size,
-           (unsigned int) textures[psp_tex_number].location,
+    printf("TEX_MAN tex [%d] reserved %d bytes @ %x left: %d kb\n", psp_tex_upload, tex_size,
+           (unsigned int) textures[psp_tex_upload].location,
            (psp_tex_buffer_max - psp_tex_buffer) / 1024);
 #endif
-    return &textures[psp_tex_number];
+    return &textures[psp_tex_upload];
 }
 
 unsigned int texman_create(void) {
@@ -169,6 +172,7 @@ unsigned int texman_create(void) {
         swizzled : 0
     };
     psp_tex_bound = psp_tex_number;
+    psp_tex_upload = psp_tex_number;
 
 #ifdef DEBUG
     printf("TEX_MAN new tex [%d] @ %x\n", psp_tex_number, psp_tex_buffer);
@@ -176,6 +180,13 @@ unsigned int texman_create(void) {
     return psp_tex_number;
 }
 
+/* Sends the next upload into an existing texture instead of the newest one, keeping its
+   number. Its old memory is only given back by texman_clear, like everything else. */
+void texman_replace(unsigned int num) {
+    textures[num].location = psp_tex_buffer;
+    psp_tex_upload = num;
+}
+
 void texman_upload_swizzle(int width, int height, unsigned int type, const void *buffer) {
     struct PSP_Texture *current = texman_reserve_memory(width, height, type);
     sceKernelDcacheWritebackRange(buffer, getMemorySize(width, height, type));
@@ -186,11 +197,11 @@ void texman_upload_swizzle(int width, int height, unsigned int type, const void
     swizzle_fast(current->location, buffer, getTexWidthBytes(width, type), height);
     current->swizzled = GU_TRUE;
 #ifdef DEBUG
-    printf("TEX_MAN upload swizzled [%d]\n", psp_tex_number);
+    printf("TEX_MAN upload swizzled [%d]\n", psp_tex_upload);
 #endif
     sceKernelDcacheWritebackRange(current->location, getMemorySize(width, height, type));
     sceKernelDcacheInvalidateRange(current->location, getMemorySize(width, height, type));
-    texman_bind_tex(psp_tex_number);
+    texman_bind_tex(psp_tex_upload);
 }
 
 void texman_upload(int width, int height, unsigned int type, const void *buffer) {
@@ -202,11 +213,11 @@ void texman_upload(int width, int height, unsigned int type, const void *buffer)
     current->swizzled = GU_FALSE;
     memcpy(current->location, buffer, getMemorySize(width, height, type));
 #ifdef DEBUG
-    // printf("TEX_MAN upload plain [%d]\n", psp_tex_number);
+    // printf("TEX_MAN upload plain [%d]\n", psp_tex_upload);
 #endif
     sceKernelDcacheWritebackRange(current->location, getMemorySize(width, height, type));
     sceKernelDcacheInvalidateRange(current->location, getMemorySize(width, height, type));
-    texman_bind_tex(psp_tex_number);
+    texman_bind_tex(psp_tex_upload);
 }
 
 void texman_bind_tex(unsigned int num) {
@@ -34,6 +34,7 @@ Steps:
 note: texture will be bound
 */
 unsigned int texman_create(void);
+void texman_replace(unsigned int num);
 void texman_clear(void);
 int gfx_vram_space_available(void);
 unsigned char *texman_get_tex_data(unsigned int num);
@@ -79,10 +79,53 @@ void set_vblank_handler(UNUSED s32 index, UNUSED struct VblankHandler *handler,
 static uint8_t inited = 0;
 
 #include "game/game_init.h" // for gGlobalTimer
+#ifdef HIGH_FPS
+#include "game/rendering_graph_node.h"
+
+#ifdef VERSION_EU
+#define GAME_TICK_RATE 25
+#else
+#define GAME_TICK_RATE 30
+#endif
+
+static unsigned int frame_rate = GAME_TICK_RATE;
+// Position of the last presented frame between the previous and the current tick
+static float frame_phase = 0.0f;
+
+static void set_frame_rate(unsigned int fps) {
+    if (fps < GAME_TICK_RATE) {
+        fps = GAME_TICK_RATE;
+    }
+    frame_rate = fps;
+    wm_api->set_target_fps(fps);
+}
+#endif
+
 void send_display_list(struct SPTask *spTask) {
     if (!inited) {
         return;
     }
+#ifdef HEADLESS
+    (void)spTask;
+    return;
+#endif
+#ifdef HIGH_FPS
+    /* Present the same display list several times per tick, with the
+       matrices blended between the last two ticks. The window manager
+       paces the swaps, so frames come out evenly spaced at frame_rate.
+       For rates that aren't a multiple of the tick rate the leftover phase
+       carries over, e.g. 144 fps alternates between 4 and 5 frames. */
+    const float step = (float)GAME_TICK_RATE / frame_rate;
+    while (frame_phase + step < 1.0f) {
+        frame_phase += step;
+        geo_interp_patch(frame_phase);
+        gfx_run((Gfx *)spTask->task.t.data_ptr);
+        gfx_end_frame();
+        gfx_start_frame();
+    }
+    frame_phase += step - 1.0f;
+    geo_interp_end_tick();
+#endif
     gfx_run((Gfx *)spTask->task.t.data_ptr);
 }
 
@@ -222,6 +265,186 @@ void produce_one_frame(void) {
     gfx_end_frame();
 }
 
+#ifdef HEADLESS
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "engine/behavior_script.h"
+#include "game/area.h"
+#include "game/camera.h"
+#include "game/level_update.h"
+#include "game/object_list_processor.h"
+#include "object_fields.h"
+#include "controller/controller_recorded_tas.h"
+#ifdef SNAPSHOTS
+#include "game/snapshot.h"
+#endif
+
+/* Headless runs replay cont.m64 as fast as they can, for regression checks
+   and route validation. The scene graph is still processed every frame since
+   the camera, animation frames and held object positions are updated there,
+   only drawing and audio mixing are skipped. A hash of the game state is
+   logged every frame so the logs of two builds can be diffed to find the
+   first frame where they diverge. */
+#define HEADLESS_DEFAULT_FRAMES 18000
+#define HEADLESS_REPORT_FRAMES 1000
+#ifdef SNAPSHOTS
+#define HEADLESS_SNAPSHOT_INTERVAL 30
+#endif
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    size_t i;
+
+    // FNV-1a
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/* Only values are hashed, not pointers, so builds with a different memory
+   layout still produce the same hashes. */
+static uint32_t hash_game_state(void) {
+    uint32_t hash = 2166136261u;
+    u16 seed = random_get_seed();
+    struct MarioState *m = gMarioState;
+    struct Object *obj;
+    int i;
+
+    hash = hash_bytes(hash, &gGlobalTimer, sizeof(gGlobalTimer));
+    hash = hash_bytes(hash, &seed, sizeof(seed));
+    hash = hash_bytes(hash, &gCurrLevelNum, sizeof(gCurrLevelNum));
+    hash = hash_bytes(hash, &gCurrAreaIndex, sizeof(gCurrAreaIndex));
+
+    hash = hash_bytes(hash, m->pos, sizeof(m->pos));
+    hash = hash_bytes(hash, m->vel, sizeof(m->vel));
+    hash = hash_bytes(hash, m->faceAngle, sizeof(m->faceAngle));
+    hash = hash_bytes(hash, &m->forwardVel, sizeof(m->forwardVel));
+    hash = hash_bytes(hash, &m->action, sizeof(m->action));
+    hash = hash_bytes(hash, &m->actionState, sizeof(m->actionState));
+    hash = hash_bytes(hash, &m->actionTimer, sizeof(m->actionTimer));
+    hash = hash_bytes(hash, &m->health, sizeof(m->health));
+    hash = hash_bytes(hash, &m->numCoins, sizeof(m->numCoins));
+
+    hash = hash_bytes(hash, gLakituState.pos, sizeof(gLakituState.pos));
+    hash = hash_bytes(hash, gLakituState.focus, sizeof(gLakituState.focus));
+
+    for (i = 0; i < NUM_OBJ_LISTS; i++) {
+        struct ObjectNode *listHead = &gObjectLists[i];
+
+        for (obj = (struct Object *) listHead->next; obj != (struct Object *) listHead;
+             obj = (struct Object *) obj->header.next) {
+            hash = hash_bytes(hash, &obj->activeFlags, sizeof(obj->activeFlags));
+            hash = hash_bytes(hash, &obj->oPosX, 3 * sizeof(f32));
+            hash = hash_bytes(hash, &obj->oVelX, 3 * sizeof(f32));
+            hash = hash_bytes(hash, &obj->oFaceAnglePitch, 3 * sizeof(s32));
+            hash = hash_bytes(hash, &obj->oAction, sizeof(s32));
+            hash = hash_bytes(hash, &obj->oTimer, sizeof(s32));
+            hash = hash_bytes(hash, &obj->oHealth, sizeof(s32));
+            hash = hash_bytes(hash, &obj->header.gfx.unk38.animFrame, sizeof(obj->header.gfx.unk38.animFrame));
+        }
+    }
+
+    return hash;
+}
+
+static void headless_run_frame(void) {
+    s16 audio_buffer[SAMPLES_HIGH * 2 * 2];
+
+    game_loop_one_iteration();
+    /* Two audio buffers per frame like produce_one_frame, so the sound
+       request bookkeeping runs at the same rate */
+    for (int i = 0; i < 2; i++) {
+        create_next_audio_buffer(audio_buffer + i * (SAMPLES_HIGH * 2), SAMPLES_HIGH);
+    }
+}
+
+#ifdef SNAPSHOTS
+/* Seek back to the given frame through the snapshot ring and replay from
+   there to the end, checking the hashes against the ones of the first run. */
+static void headless_seek_check(unsigned int seek_frame, unsigned int frames, const uint32_t *hashes) {
+    clock_t start = clock();
+    s32 restored = snapshot_restore(seek_frame);
+    double restore_ms = (double) (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    unsigned int frame;
+
+    if (restored < 0) {
+        printf("SIM: no snapshot at or before frame %u\n", seek_frame);
+        return;
+    }
+    printf("SIM: restored frame %d in %.3f ms\n", restored, restore_ms);
+
+    for (frame = restored + 1; frame <= frames; frame++) {
+        headless_run_frame();
+        if (hash_game_state() != hashes[frame - 1]) {
+            printf("SIM: replay after seeking diverges at frame %u\n", frame);
+            return;
+        }
+    }
+    printf("SIM: replay after seeking matches up to frame %u\n", frames);
+}
+#endif
+
+static void headless_main_loop(unsigned int frames, const char *hash_log_path,
+                               UNUSED unsigned int seek_frame) {
+    FILE *hash_log = fopen(hash_log_path, "w");
+    clock_t start = clock();
+    unsigned int frame;
+    uint32_t hash;
+    double seconds;
+#ifdef SNAPSHOTS
+    uint32_t *hashes = malloc(frames * sizeof(uint32_t));
+    clock_t snapshot_time = 0;
+    clock_t snapshot_start;
+
+    snapshot_init();
+    controller_tas_snapshot_regions();
+#endif
+
+    if (hash_log == NULL) {
+        printf("SIM: can't write %s, not logging hashes\n", hash_log_path);
+    }
+
+    for (frame = 1; frame <= frames; frame++) {
+        headless_run_frame();
+
+        hash = hash_game_state();
+        if (hash_log != NULL) {
+            fprintf(hash_log, "%u %08x\n", frame, (unsigned) hash);
+        }
+#ifdef SNAPSHOTS
+        hashes[frame - 1] = hash;
+        if (frame % HEADLESS_SNAPSHOT_INTERVAL == 0) {
+            snapshot_start = clock();
+            snapshot_take(frame);
+            snapshot_time += clock() - snapshot_start;
+        }
+#endif
+
+        if (frame % HEADLESS_REPORT_FRAMES == 0 || frame == frames) {
+            seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+            printf("SIM: %u frames in %.2f s, %.1f fps\n", frame, seconds,
+                   seconds > 0.0 ? frame / seconds : 0.0);
+        }
+    }
+
+    if (hash_log != NULL) {
+        fclose(hash_log);
+    }
+
+#ifdef SNAPSHOTS
+    printf("SIM: %u snapshots taken in %.3f ms each\n", frames / HEADLESS_SNAPSHOT_INTERVAL,
+           frames >= HEADLESS_SNAPSHOT_INTERVAL
+               ? (double) snapshot_time * 1000.0 / CLOCKS_PER_SEC / (frames / HEADLESS_SNAPSHOT_INTERVAL)
+               : 0.0);
+    snapshot_print_stats();
+    headless_seek_check(seek_frame != 0 ? seek_frame : frames / 2, frames, hashes);
+    free(hashes);
+#endif
+}
+#endif
+
 #ifdef TARGET_WEB
 static void em_main_loop(void) {
 }
@@ -268,6 +491,11 @@ static void on_fullscreen_changed(bool is_now_fullscreen) {
 void *main_pc_pool = NULL;
 void *main_pc_pool_gd = NULL;
 #endif
+#ifdef HEADLESS
+static unsigned int headless_frames = HEADLESS_DEFAULT_FRAMES;
+static const char *headless_hash_log = "sim_hashes.log";
+static unsigned int headless_seek_frame = 0;
+#endif
 void main_func(void) {
 #if !(defined(TARGET_DC) || defined(TARGET_PSP))
     static u32 pool[0x165000/8 / 4 * sizeof(void *) * 2];
@@ -287,6 +515,19 @@ void main_func(void) {
     request_anim_frame(on_anim_frame);
 #endif
 
+#ifdef HEADLESS
+    /* No window and no audio output */
+    audio_api = &audio_null;
+    audio_init();
+    sound_init();
+
+    thread5_game_loop(NULL);
+    inited = 1;
+
+    headless_main_loop(headless_frames, headless_hash_log, headless_seek_frame);
+    return;
+#endif
+
 #if defined(ENABLE_DX12)
     rendering_api = &gfx_direct3d12_api;
     wm_api = &gfx_dxgi_api;
@@ -310,6 +551,9 @@ void main_func(void) {
     
     wm_api->set_fullscreen_changed_callback(on_fullscreen_changed);
     wm_api->set_keyboard_callbacks(keyboard_on_key_down, keyboard_on_key_up, keyboard_on_all_keys_up);
+#ifdef HIGH_FPS
+    set_frame_rate(configFrameRate);
+#endif
     
 #if HAVE_WASAPI
     if (audio_api == NULL && audio_wasapi.init()) {
@@ -369,6 +613,67 @@ void main_func(void) {
 #endif
 }
 
+#if defined(HEADLESS) && (defined(__linux__) || defined(__BSD__) || defined(__APPLE__))
+#include <sys/wait.h>
+#include <unistd.h>
+
+static unsigned int headless_jobs = 1;
+
+/* Run the jobs as separate processes. The game state lives in globals, so a
+   forked child is an independent instance of the game, and the jobs scale
+   with the number of cores without sharing anything. Job n replays
+   cont.<n>.m64 if it exists, cont.m64 otherwise, and logs its hashes to
+   <hash log>.<n>. */
+static int headless_run_jobs(void) {
+    static char input_path[32];
+    static char hash_log_path[256];
+    struct timespec start, end;
+    unsigned int job;
+    unsigned int started = 0;
+    unsigned int failed = 0;
+    int status;
+    double seconds;
+    pid_t pid;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fflush(stdout);
+
+    for (job = 0; job < headless_jobs; job++) {
+        pid = fork();
+        if (pid == 0) {
+            snprintf(input_path, sizeof(input_path), "cont.%u.m64", job);
+            controller_tas_set_input(access(input_path, R_OK) == 0 ? input_path : "cont.m64");
+            snprintf(hash_log_path, sizeof(hash_log_path), "%s.%u", headless_hash_log, job);
+            headless_hash_log = hash_log_path;
+
+            main_func();
+            fflush(stdout);
+            /* Skip the atexit handlers, the parent saves the config */
+            _exit(0);
+        }
+        if (pid < 0) {
+            perror("SIM: fork");
+            break;
+        }
+        started++;
+    }
+
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("SIM: %u jobs of %u frames in %.2f s, %.1f fps total, %u failed\n", started,
+           headless_frames, seconds, seconds > 0.0 ? started * headless_frames / seconds : 0.0,
+           failed);
+
+    return failed != 0 || started != headless_jobs;
+}
+#endif
+
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 int WINAPI WinMain(UNUSED HINSTANCE hInstance, UNUSED HINSTANCE hPrevInstance, UNUSED LPSTR pCmdLine, UNUSED int nCmdShow) {
@@ -377,6 +682,37 @@ int WINAPI WinMain(UNUSED HINSTANCE hInstance, UNUSED HINSTANCE hPrevInstance, U
 }
 #else
 int main(UNUSED int argc, UNUSED char *argv[]) {
+#ifdef HEADLESS
+    /* sm64 [-j jobs] [frames] [hash log] [frame to seek back to, with SNAPSHOTS] */
+    int arg = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+#if defined(__linux__) || defined(__BSD__) || defined(__APPLE__)
+            headless_jobs = strtoul(argv[++i], NULL, 10);
+#else
+            i++;
+#endif
+            continue;
+        }
+        switch (arg++) {
+            case 0:
+                headless_frames = strtoul(argv[i], NULL, 10);
+                break;
+            case 1:
+                headless_hash_log = argv[i];
+                break;
+            case 2:
+                headless_seek_frame = strtoul(argv[i], NULL, 10);
+                break;
+        }
+    }
+#if defined(__linux__) || defined(__BSD__) || defined(__APPLE__)
+    if (headless_jobs > 1) {
+        return headless_run_jobs();
+    }
+#endif
+#endif
     main_func();
     return 0;
 }